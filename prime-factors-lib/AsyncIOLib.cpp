@@ -0,0 +1,233 @@
+///////////////////////////////////////
+///
+///	\file		AsyncIOLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for AsyncIOLib.h
+///
+///	\notes
+///		1. Each class hands exactly one buffer back and forth between the caller and its I/O thread. Buffers are
+///			swapped rather than copied so their capacity is reused from block to block.
+///		2. Exceptions raised on an I/O thread are captured and rethrown on the calling thread the next time it
+///			talks to the reader/writer.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "AsyncIOLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <stdexcept>
+#include <utility>
+
+
+//
+// Namespaces:
+//
+using namespace std;
+
+
+//
+// Main library namespace:
+//
+namespace async_io
+{
+
+	// BlockReader constructor:
+	BlockReader::BlockReader(
+		const string& inFileName,
+		size_t inLinesPerBlock,
+		unsigned inDecompressThreads,
+		uint64_t inStartOffset
+		) : file(inFileName, inDecompressThreads), fileName(inFileName), linesPerBlock(inLinesPerBlock > 0 ? inLinesPerBlock : 1),
+			fileSize(file.getFileSize()), backReady(false), endOfFile(false), stopping(false)
+	{
+		// Continue where an earlier reader stopped:
+		if (inStartOffset > 0) file.skip(inStartOffset);
+
+		// Start prefetching the first block:
+		ioThread = thread(&BlockReader::readLoop, this);
+	}
+
+	// BlockReader destructor:
+	BlockReader::~BlockReader()
+	{
+		{
+			lock_guard<mutex> lock(blockMutex);
+			stopping = true;
+		}
+		blockCondition.notify_all();
+
+		if (ioThread.joinable()) ioThread.join();
+	}
+
+	// Swap next prefetched block to caller:
+	bool BlockReader::nextBlock(
+		LineBlock& outBlock
+		)
+	{
+		unique_lock<mutex> lock(blockMutex);
+		blockCondition.wait(lock, [this] { return backReady || endOfFile || ioError; });
+
+		if (ioError) rethrow_exception(ioError);
+		if (!backReady) return false;
+
+		// Take the filled block and give the I/O thread our old one to refill:
+		swap(outBlock, backBlock);
+		backReady = false;
+		lock.unlock();
+		blockCondition.notify_all();
+
+		return !outBlock.lines.empty();
+	}
+
+	// Reader I/O thread:
+	void BlockReader::readLoop()
+	{
+		try
+		{
+			while (true)
+			{
+				// Wait until the caller has taken the previous block:
+				{
+					unique_lock<mutex> lock(blockMutex);
+					blockCondition.wait(lock, [this] { return !backReady || stopping; });
+					if (stopping) return;
+				}
+
+				// Fill the back block outside the lock, it is ours until backReady is set:
+				backBlock.lines.clear();
+				backBlock.byteCount = 0;
+				istream& stream = file.getStream();
+				string line;
+				while ((backBlock.lines.size() < linesPerBlock) && getline(stream, line))
+				{
+					// The line ending only counts if there was one, the last line may end at the end of the file:
+					backBlock.byteCount += line.size() + (stream.eof() ? 0 : 1);
+					backBlock.lines.push_back(move(line));
+				}
+
+				// A failed read is an error, not the end of the file, or the run would end early and look complete:
+				if (stream.bad())
+				{
+					throw runtime_error(string("Error: Problem(s) occured while trying to read the file: '") + fileName + string("'; aborting."));
+				}
+				bool exhausted = !stream;
+
+				// Publish block:
+				{
+					lock_guard<mutex> lock(blockMutex);
+					backReady = true;
+					endOfFile = exhausted;
+				}
+				blockCondition.notify_all();
+
+				if (exhausted) return;
+			}
+		}
+		catch (...)
+		{
+			lock_guard<mutex> lock(blockMutex);
+			ioError = current_exception();
+			blockCondition.notify_all();
+		}
+	}
+
+
+	// AsyncWriter constructor:
+	AsyncWriter::AsyncWriter(
+		ostream& inStream,
+		bool inFlushEachBuffer
+		) : stream(inStream), flushEachBuffer(inFlushEachBuffer), bytesWritten(0), backPending(false), stopping(false)
+	{
+		ioThread = thread(&AsyncWriter::writeLoop, this);
+	}
+
+	// AsyncWriter destructor:
+	AsyncWriter::~AsyncWriter()
+	{
+		// Destructors must not throw, so errors are only reported through close():
+		try
+		{
+			close();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	// Hand buffer to I/O thread:
+	void AsyncWriter::write(
+		string& ioBuffer
+		)
+	{
+		unique_lock<mutex> lock(bufferMutex);
+
+		// Wait for the previous buffer to be drained:
+		bufferCondition.wait(lock, [this] { return !backPending || ioError; });
+		if (ioError) rethrow_exception(ioError);
+		if (stopping) throw logic_error("Error: write() called on a closed AsyncWriter; aborting.");
+
+		swap(ioBuffer, backBuffer);
+		backPending = true;
+		lock.unlock();
+		bufferCondition.notify_all();
+	}
+
+	// Drain and stop I/O thread:
+	void AsyncWriter::close()
+	{
+		{
+			lock_guard<mutex> lock(bufferMutex);
+			stopping = true;
+		}
+		bufferCondition.notify_all();
+
+		if (ioThread.joinable()) ioThread.join();
+
+		lock_guard<mutex> lock(bufferMutex);
+		if (ioError) rethrow_exception(ioError);
+	}
+
+	// Writer I/O thread:
+	void AsyncWriter::writeLoop()
+	{
+		while (true)
+		{
+			// Wait for work (or for close() once everything is drained):
+			{
+				unique_lock<mutex> lock(bufferMutex);
+				bufferCondition.wait(lock, [this] { return backPending || stopping; });
+				if (!backPending) break;
+			}
+
+			// Write the back buffer outside the lock, it is ours until backPending is cleared:
+			stream.write(backBuffer.data(), backBuffer.size());
+			if (flushEachBuffer) stream.flush();
+			bool failed = !stream;
+			if (!failed) bytesWritten += backBuffer.size();
+			backBuffer.clear();
+
+			{
+				lock_guard<mutex> lock(bufferMutex);
+				backPending = false;
+				if (failed)
+				{
+					ioError = make_exception_ptr(runtime_error("Error: Problem(s) occured while writing output; aborting."));
+				}
+			}
+			bufferCondition.notify_all();
+
+			if (failed) return;
+		}
+
+		stream.flush();
+	}
+
+} // namespace async_io
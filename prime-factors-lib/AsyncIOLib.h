@@ -0,0 +1,209 @@
+///////////////////////////////////////
+///
+///	\file		AsyncIOLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		AsyncIOLib library header
+///
+///	\notes
+///		1. Double-buffered reader and writer that each own a dedicated I/O thread so that disk reads and
+///			console writes overlap with the factoring done on the calling thread.
+///		2. While the caller works on one block, the I/O thread prefetches the next input block (BlockReader)
+///			or drains the previous output block (AsyncWriter). Only the two buffers are ever alive, so memory
+///			use does not grow with the size of the input file.
+///		3. BlockReader reads gzip and zstd files as well (see CompressedInputLib.h), block byte counts are then
+///			counted in decompressed bytes.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef ASYNC_IO_LIB_H
+#define	ASYNC_IO_LIB_H
+
+
+//
+// Local includes:
+//
+#include "CompressedInputLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace async_io
+{
+
+	/// Block of consecutive lines handed from the I/O thread to the caller.
+	struct LineBlock
+	{
+		std::vector<std::string> lines;				///< Lines of the block, in file order
+		std::size_t byteCount;						///< File bytes the lines were read from, line endings included
+
+		/// Default constructor:
+		LineBlock() : byteCount(0) {}
+	};
+
+
+	/// RAII double-buffered file reader that prefetches the next block on a dedicated I/O thread.
+	class BlockReader
+	{
+	public:
+
+		/// Default constructor:
+		BlockReader() = delete;
+
+		/// Custom constructor:
+		explicit BlockReader(
+			const std::string& inFileName,				///< File name of file to open
+			std::size_t inLinesPerBlock = 4096,			///< Maximum number of lines per block
+			unsigned inDecompressThreads = 1,			///< Worker threads for compressed formats that allow it
+			uint64_t inStartOffset = 0					///< Bytes to skip first, a sum of earlier blocks' byteCount
+			);
+
+		/// Destructor:
+		~BlockReader();
+
+		/// No copies, the I/O thread holds a pointer to this object:
+		BlockReader(const BlockReader&) = delete;
+		BlockReader& operator=(const BlockReader&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Get name of file.
+		std::string getFileName() { return fileName; }
+
+		/// Get size of file in bytes, taken when it was opened (0 for compressed files and pipes).
+		uint64_t getFileSize() const { return fileSize; }
+
+		/// Swap the next prefetched block into outBlock. Returns false once the file is exhausted.
+		bool nextBlock(
+			LineBlock& outBlock							///< Block to fill, its old buffers are recycled by the I/O thread
+			);
+
+	private:
+
+		//
+		// Member variables:
+		//
+		compressed_input::InputFile file;
+		const std::string fileName;
+		const std::size_t linesPerBlock;
+		uint64_t fileSize;
+
+		std::mutex blockMutex;
+		std::condition_variable blockCondition;
+		LineBlock backBlock;						///< Block owned by the I/O thread while backReady == false
+		bool backReady;
+		bool endOfFile;
+		bool stopping;
+		std::exception_ptr ioError;
+
+		std::thread ioThread;
+
+
+		//
+		// Member functions:
+		//
+
+		/// I/O thread body:
+		void readLoop();
+
+	};
+
+
+	/// RAII double-buffered writer that drains output blocks to a stream on a dedicated I/O thread.
+	class AsyncWriter
+	{
+	public:
+
+		/// Default constructor:
+		AsyncWriter() = delete;
+
+		/// Custom constructor:
+		explicit AsyncWriter(
+			std::ostream& inStream,						///< Stream to write to, must outlive the writer
+			bool inFlushEachBuffer = false				///< Flush the stream after every buffer (see getBytesWritten())
+			);
+
+		/// Destructor (drains any pending output):
+		~AsyncWriter();
+
+		/// No copies, the I/O thread holds a pointer to this object:
+		AsyncWriter(const AsyncWriter&) = delete;
+		AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Hand ioBuffer to the I/O thread. ioBuffer is swapped with an empty, recycled buffer to fill next.
+		void write(
+			std::string& ioBuffer						///< Filled buffer in, empty buffer out
+			);
+
+		/// Wait for all pending output to be written and stop the I/O thread. Rethrows any write error.
+		void close();
+
+		/// Get bytes of all buffers written so far, always a whole number of buffers. With inFlushEachBuffer
+		///	they have also been flushed to the stream's destination.
+		uint64_t getBytesWritten() const { return bytesWritten; }
+
+	private:
+
+		//
+		// Member variables:
+		//
+		std::ostream& stream;
+		const bool flushEachBuffer;
+		std::atomic<uint64_t> bytesWritten;
+
+		std::mutex bufferMutex;
+		std::condition_variable bufferCondition;
+		std::string backBuffer;						///< Buffer owned by the I/O thread while backPending == true
+		bool backPending;
+		bool stopping;
+		std::exception_ptr ioError;
+
+		std::thread ioThread;
+
+
+		//
+		// Member functions:
+		//
+
+		/// I/O thread body:
+		void writeLoop();
+
+	};
+
+} // namespace async_io
+
+#endif // ASYNC_IO_LIB_H
@@ -0,0 +1,899 @@
+///////////////////////////////////////
+///
+///	\file		BatchGcdLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for BatchGcdLib.h
+///
+///	\notes
+///		1. Long division is Knuth's algorithm D (TAOCP vol. 2, 4.3.1) as written in Hacker's Delight, 9-2.
+///		2. The reciprocal is built top down: a reciprocal of the top half of the divisor is refined with one
+///			Newton step, x' = x + x * (B^2n - b * x) / B^2n, then nudged to the exact floor.
+///		3. The NTT works modulo the prime 2^64 - 2^32 + 1, whose special form makes reduction a few additions, on
+///			16-bit digits so the coefficients of a product fit below the prime without a second modulus.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "BatchGcdLib.h"
+#include "FactorAlgorithmsLib.h"
+#include "UtilsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+
+//
+// Namespaces:
+//
+using namespace std;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	typedef vector<uint32_t> Limbs;
+
+	// Below these sizes (in limbs) the simple algorithms win:
+	const size_t karatsubaThreshold = 32;
+	const size_t barrettThreshold = 48;
+	const size_t nttThreshold = 6144;
+
+	// Fewest digits a thread takes in one transform, and most digits transformed as one block in cache:
+	const size_t nttParallelGrain = size_t(1) << 14;
+	const size_t nttCacheDigits = size_t(1) << 14;
+
+	// Drop leading zero limbs:
+	inline void trim(
+		Limbs& limbs
+		)
+	{
+		while (!limbs.empty() && (limbs.back() == 0)) limbs.pop_back();
+	}
+
+	// Copy a limb range without its leading zeros:
+	inline Limbs slice(
+		const uint32_t* data,
+		size_t count
+		)
+	{
+		while ((count != 0) && (data[count - 1] == 0)) --count;
+		return Limbs(data, data + count);
+	}
+
+	// accumulator += value * B^shift:
+	void addShifted(
+		Limbs& accumulator,
+		const Limbs& value,
+		size_t shift
+		)
+	{
+		if (value.empty()) return;
+		if (accumulator.size() < shift + value.size()) accumulator.resize(shift + value.size(), 0);
+
+		uint64_t carry = 0;
+		size_t i = 0;
+		for (; i < value.size(); ++i)
+		{
+			uint64_t sum = uint64_t(accumulator[shift + i]) + value[i] + carry;
+			accumulator[shift + i] = static_cast<uint32_t>(sum);
+			carry = sum >> 32;
+		}
+		for (size_t k = shift + i; carry != 0; ++k)
+		{
+			if (k == accumulator.size()) accumulator.push_back(0);
+			uint64_t sum = uint64_t(accumulator[k]) + carry;
+			accumulator[k] = static_cast<uint32_t>(sum);
+			carry = sum >> 32;
+		}
+	}
+
+	// minuend -= subtrahend, requires minuend >= subtrahend:
+	void subtractInPlace(
+		Limbs& minuend,
+		const Limbs& subtrahend
+		)
+	{
+		int64_t borrow = 0;
+		size_t i = 0;
+		for (; i < subtrahend.size(); ++i)
+		{
+			int64_t difference = int64_t(minuend[i]) - subtrahend[i] - borrow;
+			minuend[i] = static_cast<uint32_t>(difference);
+			borrow = (difference < 0) ? 1 : 0;
+		}
+		for (; (borrow != 0) && (i < minuend.size()); ++i)
+		{
+			borrow = (minuend[i] == 0) ? 1 : 0;
+			--minuend[i];
+		}
+		trim(minuend);
+	}
+
+	// Run body(i) for every i in [0, count), spread over up to threadCount threads:
+	template <typename Body>
+	void parallelFor(
+		size_t count,
+		unsigned threadCount,
+		Body body
+		)
+	{
+		if ((threadCount <= 1) || (count < 2))
+		{
+			for (size_t i = 0; i < count; ++i) body(i);
+			return;
+		}
+
+		atomic<size_t> nextIndex(0);
+		exception_ptr firstError;
+		mutex errorMutex;
+		auto worker = [&]()
+		{
+			try
+			{
+				for (size_t i = nextIndex++; i < count; i = nextIndex++) body(i);
+			}
+			catch (...)
+			{
+				lock_guard<mutex> lock(errorMutex);
+				if (!firstError) firstError = current_exception();
+				nextIndex = count;
+			}
+		};
+
+		vector<thread> workers;
+		for (size_t t = 0; t < min<size_t>(threadCount, count); ++t) workers.emplace_back(worker);
+		for (auto& w : workers) w.join();
+
+		if (firstError) rethrow_exception(firstError);
+	}
+
+	// NTT modulus 2^64 - 2^32 + 1, its multiplicative group has a generator of 7 and order divisible by 2^32:
+	const uint64_t nttPrime = 0xffffffff00000001ull;
+	const uint64_t nttGenerator = 7;
+
+	// a + b mod nttPrime, a and b reduced:
+	inline uint64_t addMod(
+		uint64_t a,
+		uint64_t b
+		)
+	{
+		uint64_t sum = a + b;
+		if ((sum < a) || (sum >= nttPrime)) sum -= nttPrime;
+		return sum;
+	}
+
+	// a - b mod nttPrime, a and b reduced:
+	inline uint64_t subtractMod(
+		uint64_t a,
+		uint64_t b
+		)
+	{
+		uint64_t difference = a - b;
+		if (a < b) difference += nttPrime;
+		return difference;
+	}
+
+	// a * b mod nttPrime, a and b reduced. 2^64 = 2^32 - 1 and 2^96 = -1 modulo the prime, so no division is needed:
+	inline uint64_t multiplyMod(
+		uint64_t a,
+		uint64_t b
+		)
+	{
+		uint64_t lo, hi;
+#if defined(__SIZEOF_INT128__)
+		unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+		lo = static_cast<uint64_t>(product);
+		hi = static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		lo = _umul128(a, b, &hi);
+#else
+		uint64_t aLo = a & 0xffffffff, aHi = a >> 32;
+		uint64_t bLo = b & 0xffffffff, bHi = b >> 32;
+		uint64_t loLo = aLo * bLo, hiLo = aHi * bLo, loHi = aLo * bHi, hiHi = aHi * bHi;
+		uint64_t cross = (loLo >> 32) + (hiLo & 0xffffffff) + loHi;
+		hi = hiHi + (hiLo >> 32) + (cross >> 32);
+		lo = (cross << 32) | (loLo & 0xffffffff);
+#endif
+
+		// lo + (hi mod 2^32) * (2^32 - 1) - (hi >> 32):
+		uint64_t low = lo - (hi >> 32);
+		if (lo < (hi >> 32)) low -= 0xffffffff;
+		uint64_t middle = (hi & 0xffffffff) * 0xffffffff;
+		uint64_t result = low + middle;
+		if (result < middle) result += 0xffffffff;
+		if (result >= nttPrime) result -= nttPrime;
+		return result;
+	}
+
+	// base^exponent mod nttPrime:
+	uint64_t powerMod(
+		uint64_t base,
+		uint64_t exponent
+		)
+	{
+		uint64_t result = 1;
+		for (; exponent != 0; exponent >>= 1)
+		{
+			if (exponent & 1) result = multiplyMod(result, base);
+			base = multiplyMod(base, base);
+		}
+		return result;
+	}
+
+	// Roots of every stage of a transform of length size: the powers w_len^0 .. w_len^(len/2 - 1) of a primitive
+	//	len-th root of unity (or of its inverse) start at index len/2, so each stage reads them in order:
+	vector<uint64_t> stageRoots(
+		size_t size,
+		bool inverse
+		)
+	{
+		uint64_t root = powerMod(nttGenerator, (nttPrime - 1) / size);
+		if (inverse) root = powerMod(root, nttPrime - 2);
+
+		vector<uint64_t> roots(size);
+		uint64_t power = 1;
+		for (size_t j = 0; j < size / 2; ++j)
+		{
+			roots[size / 2 + j] = power;
+			power = multiplyMod(power, root);
+		}
+
+		// w_len = w_2len^2:
+		for (size_t half = size / 4; half >= 1; half /= 2)
+		{
+			for (size_t j = 0; j < half; ++j) roots[half + j] = roots[2 * half + 2 * j];
+		}
+		return roots;
+	}
+
+	// Butterflies [begin, end) of one stage on one block of length len, roots from stageRoots():
+	inline void forwardButterflies(
+		uint64_t* block,
+		size_t len,
+		size_t begin,
+		size_t end,
+		const uint64_t* roots
+		)
+	{
+		const size_t half = len / 2;
+		for (size_t j = begin; j < end; ++j)
+		{
+			uint64_t u = block[j], v = block[j + half];
+			block[j] = addMod(u, v);
+			block[j + half] = multiplyMod(subtractMod(u, v), roots[half + j]);
+		}
+	}
+
+	// Inverse butterflies, same arguments with roots of the inverse root:
+	inline void inverseButterflies(
+		uint64_t* block,
+		size_t len,
+		size_t begin,
+		size_t end,
+		const uint64_t* roots
+		)
+	{
+		const size_t half = len / 2;
+		for (size_t j = begin; j < end; ++j)
+		{
+			uint64_t u = block[j], v = multiplyMod(block[j + half], roots[half + j]);
+			block[j] = addMod(u, v);
+			block[j + half] = subtractMod(u, v);
+		}
+	}
+
+	// In-place transform of a power-of-two length. Forward (decimation in frequency) leaves the result in bit-reversed
+	//	order and inverse (decimation in time) expects it that way, so the pointwise product needs no reordering. Stages
+	//	on blocks longer than blockLen are split over the threads by ranges of butterflies, the rest are run block by
+	//	block, each block staying in cache and going to one thread:
+	void transform(
+		vector<uint64_t>& values,
+		const vector<uint64_t>& roots,
+		bool inverse,
+		unsigned threadCount
+		)
+	{
+		const size_t size = values.size();
+		size_t chunks = 1;
+		while ((chunks < threadCount) && (size / (2 * chunks) >= nttParallelGrain)) chunks *= 2;
+		const size_t blockLen = min(size / chunks, nttCacheDigits);
+		uint64_t* data = values.data();
+
+		// One stage on blocks longer than blockLen:
+		auto largeStage = [&](size_t len)
+		{
+			const size_t perChunk = (len / 2 + chunks - 1) / chunks;
+			parallelFor(chunks, threadCount, [&](size_t c)
+			{
+				const size_t begin = c * perChunk, end = min(len / 2, begin + perChunk);
+				for (size_t offset = 0; offset < size; offset += len)
+				{
+					if (inverse) inverseButterflies(data + offset, len, begin, end, roots.data());
+					else forwardButterflies(data + offset, len, begin, end, roots.data());
+				}
+			});
+		};
+
+		// All stages on blocks of blockLen and shorter:
+		auto smallStages = [&]()
+		{
+			parallelFor(size / blockLen, threadCount, [&](size_t b)
+			{
+				uint64_t* block = data + b * blockLen;
+				for (size_t len = inverse ? 2 : blockLen; (len >= 2) && (len <= blockLen); len = inverse ? len * 2 : len / 2)
+				{
+					for (size_t offset = 0; offset < blockLen; offset += len)
+					{
+						if (inverse) inverseButterflies(block + offset, len, 0, len / 2, roots.data());
+						else forwardButterflies(block + offset, len, 0, len / 2, roots.data());
+					}
+				}
+			});
+		};
+
+		if (inverse)
+		{
+			smallStages();
+			for (size_t len = blockLen * 2; len <= size; len *= 2) largeStage(len);
+		}
+		else
+		{
+			for (size_t len = size; len > blockLen; len /= 2) largeStage(len);
+			smallStages();
+		}
+	}
+
+	// Product of two limb ranges by NTT over 16-bit digits. Every coefficient of the digit product is below
+	//	2^32 * (digit count), which is below nttPrime, so one prime recovers it exactly:
+	Limbs multiplyNtt(
+		const uint32_t* a,
+		size_t aCount,
+		const uint32_t* b,
+		size_t bCount,
+		unsigned threadCount
+		)
+	{
+		const bool square = (a == b) && (aCount == bCount);
+		size_t size = 1;
+		while (size < 2 * (aCount + bCount)) size *= 2;
+		if (size < 2 * nttParallelGrain) threadCount = 1;
+
+		auto toDigits = [&](const uint32_t* limbs, size_t count)
+		{
+			vector<uint64_t> digits(size, 0);
+			for (size_t i = 0; i < count; ++i)
+			{
+				digits[2 * i] = limbs[i] & 0xffff;
+				digits[2 * i + 1] = limbs[i] >> 16;
+			}
+			return digits;
+		};
+
+		const vector<uint64_t> roots = stageRoots(size, false);
+		vector<uint64_t> fa = toDigits(a, aCount);
+		transform(fa, roots, false, threadCount);
+		if (square)
+		{
+			for (auto& value : fa) value = multiplyMod(value, value);
+		}
+		else
+		{
+			vector<uint64_t> fb = toDigits(b, bCount);
+			transform(fb, roots, false, threadCount);
+			for (size_t i = 0; i < size; ++i) fa[i] = multiplyMod(fa[i], fb[i]);
+		}
+		transform(fa, stageRoots(size, true), true, threadCount);
+
+		// Scale by 1/size and carry the coefficients back into 16-bit digits, two per limb:
+		const uint64_t sizeInverse = powerMod(size, nttPrime - 2);
+		Limbs product(aCount + bCount, 0);
+		uint64_t carry = 0;
+		for (size_t i = 0; i < 2 * product.size(); ++i)
+		{
+			carry += multiplyMod(fa[i], sizeInverse);
+			product[i / 2] |= static_cast<uint32_t>(carry & 0xffff) << ((i & 1) * 16);
+			carry >>= 16;
+		}
+		trim(product);
+		return product;
+	}
+
+	// Schoolbook product of two limb ranges:
+	Limbs multiplySchoolbook(
+		const uint32_t* a,
+		size_t aCount,
+		const uint32_t* b,
+		size_t bCount
+		)
+	{
+		Limbs product(aCount + bCount, 0);
+		for (size_t i = 0; i < aCount; ++i)
+		{
+			uint64_t carry = 0;
+			for (size_t j = 0; j < bCount; ++j)
+			{
+				uint64_t t = uint64_t(a[i]) * b[j] + product[i + j] + carry;
+				product[i + j] = static_cast<uint32_t>(t);
+				carry = t >> 32;
+			}
+			product[i + bCount] = static_cast<uint32_t>(carry);
+		}
+		trim(product);
+		return product;
+	}
+
+	// Product of two limb ranges, schoolbook, Karatsuba or NTT by size. threadCount is only used by the NTT:
+	Limbs multiplyLimbs(
+		const uint32_t* a,
+		size_t aCount,
+		const uint32_t* b,
+		size_t bCount,
+		unsigned threadCount
+		)
+	{
+		if (aCount < bCount)
+		{
+			swap(a, b);
+			swap(aCount, bCount);
+		}
+		if (bCount == 0) return Limbs();
+		if (bCount < karatsubaThreshold) return multiplySchoolbook(a, aCount, b, bCount);
+
+		// Very unbalanced operands: multiply b by each b-sized chunk of a:
+		if (aCount >= 2 * bCount)
+		{
+			Limbs product;
+			for (size_t offset = 0; offset < aCount; offset += bCount)
+			{
+				size_t chunk = min(bCount, aCount - offset);
+				addShifted(product, multiplyLimbs(a + offset, chunk, b, bCount, threadCount), offset);
+			}
+			trim(product);
+			return product;
+		}
+		if (bCount >= nttThreshold) return multiplyNtt(a, aCount, b, bCount, threadCount);
+
+		// a = a1 * B^m + a0, b = b1 * B^m + b0, and (a0 + a1) * (b0 + b1) gives the cross terms:
+		const size_t m = (aCount + 1) / 2;
+		const size_t bLow = min(m, bCount);
+		Limbs a0 = slice(a, m), a1 = slice(a + m, aCount - m);
+		Limbs b0 = slice(b, bLow), b1 = slice(b + bLow, bCount - bLow);
+
+		Limbs z0 = multiplyLimbs(a0.data(), a0.size(), b0.data(), b0.size(), 1);
+		Limbs z2 = multiplyLimbs(a1.data(), a1.size(), b1.data(), b1.size(), 1);
+		addShifted(a0, a1, 0);
+		addShifted(b0, b1, 0);
+		Limbs z1 = multiplyLimbs(a0.data(), a0.size(), b0.data(), b0.size(), 1);
+		subtractInPlace(z1, z0);
+		subtractInPlace(z1, z2);
+
+		Limbs product = z0;
+		addShifted(product, z1, m);
+		addShifted(product, z2, 2 * m);
+		trim(product);
+		return product;
+	}
+
+	// Number of leading zero bits in a nonzero limb:
+	inline int leadingZeros(
+		uint32_t limb
+		)
+	{
+		int count = 0;
+		while ((limb & 0x80000000u) == 0)
+		{
+			limb <<= 1;
+			++count;
+		}
+		return count;
+	}
+
+} // namespace
+
+
+//
+// Main library namespace:
+//
+namespace batch_gcd
+{
+
+	// BigUnsigned constructor:
+	BigUnsigned::BigUnsigned(
+		uint64_t inValue
+		)
+	{
+		limbs.push_back(static_cast<uint32_t>(inValue));
+		limbs.push_back(static_cast<uint32_t>(inValue >> 32));
+		normalize();
+	}
+
+	// Normalize:
+	void BigUnsigned::normalize()
+	{
+		trim(limbs);
+	}
+
+	// To uint64:
+	uint64_t BigUnsigned::toUint64() const
+	{
+		uint64_t value = 0;
+		if (limbs.size() > 1) value = uint64_t(limbs[1]) << 32;
+		if (!limbs.empty()) value |= limbs[0];
+		return value;
+	}
+
+	// Compare:
+	int BigUnsigned::compare(
+		const BigUnsigned& a,
+		const BigUnsigned& b
+		)
+	{
+		if (a.limbs.size() != b.limbs.size()) return (a.limbs.size() < b.limbs.size()) ? -1 : 1;
+		for (size_t i = a.limbs.size(); i-- > 0;)
+		{
+			if (a.limbs[i] != b.limbs[i]) return (a.limbs[i] < b.limbs[i]) ? -1 : 1;
+		}
+		return 0;
+	}
+
+	// Add:
+	BigUnsigned BigUnsigned::add(
+		const BigUnsigned& a,
+		const BigUnsigned& b
+		)
+	{
+		BigUnsigned sum(a);
+		addShifted(sum.limbs, b.limbs, 0);
+		return sum;
+	}
+
+	// Subtract:
+	BigUnsigned BigUnsigned::subtract(
+		const BigUnsigned& a,
+		const BigUnsigned& b
+		)
+	{
+		BigUnsigned difference(a);
+		subtractInPlace(difference.limbs, b.limbs);
+		return difference;
+	}
+
+	// Multiply:
+	BigUnsigned BigUnsigned::multiply(
+		const BigUnsigned& a,
+		const BigUnsigned& b,
+		unsigned inThreadCount
+		)
+	{
+		BigUnsigned product;
+		product.limbs = multiplyLimbs(a.limbs.data(), a.limbs.size(), b.limbs.data(), b.limbs.size(), inThreadCount);
+		return product;
+	}
+
+	// Shift limbs left:
+	BigUnsigned BigUnsigned::shiftLimbsLeft(
+		size_t inLimbs
+		) const
+	{
+		BigUnsigned shifted;
+		if (limbs.empty()) return shifted;
+		shifted.limbs.assign(inLimbs, 0);
+		shifted.limbs.insert(shifted.limbs.end(), limbs.begin(), limbs.end());
+		return shifted;
+	}
+
+	// Shift limbs right:
+	BigUnsigned BigUnsigned::shiftLimbsRight(
+		size_t inLimbs
+		) const
+	{
+		BigUnsigned shifted;
+		if (inLimbs < limbs.size()) shifted.limbs.assign(limbs.begin() + inLimbs, limbs.end());
+		return shifted;
+	}
+
+	// Low limbs:
+	BigUnsigned BigUnsigned::lowLimbs(
+		size_t inLimbs
+		) const
+	{
+		BigUnsigned low;
+		low.limbs = slice(limbs.data(), min(inLimbs, limbs.size()));
+		return low;
+	}
+
+	// Divide and modulo (Knuth D):
+	void BigUnsigned::divideModulo(
+		const BigUnsigned& a,
+		const BigUnsigned& b,
+		BigUnsigned& outQuotient,
+		BigUnsigned& outRemainder
+		)
+	{
+		const Limbs& u = a.limbs;
+		const Limbs& v = b.limbs;
+		const size_t m = u.size(), n = v.size();
+
+		outQuotient.limbs.clear();
+		if (compare(a, b) < 0)
+		{
+			outRemainder = a;
+			return;
+		}
+
+		// Single-limb divisor, plain short division:
+		if (n == 1)
+		{
+			outQuotient.limbs.assign(m, 0);
+			uint64_t remainder = 0;
+			for (size_t i = m; i-- > 0;)
+			{
+				uint64_t current = (remainder << 32) | u[i];
+				outQuotient.limbs[i] = static_cast<uint32_t>(current / v[0]);
+				remainder = current % v[0];
+			}
+			outQuotient.normalize();
+			outRemainder = BigUnsigned(remainder);
+			return;
+		}
+
+		// Normalize so the divisor's top bit is set, which keeps each quotient estimate off by at most 2:
+		const int s = leadingZeros(v[n - 1]);
+		Limbs vn(n), un(m + 1);
+		for (size_t i = n - 1; i > 0; --i) vn[i] = (v[i] << s) | (s ? v[i - 1] >> (32 - s) : 0);
+		vn[0] = v[0] << s;
+		un[m] = s ? u[m - 1] >> (32 - s) : 0;
+		for (size_t i = m - 1; i > 0; --i) un[i] = (u[i] << s) | (s ? u[i - 1] >> (32 - s) : 0);
+		un[0] = u[0] << s;
+
+		const uint64_t base = uint64_t(1) << 32;
+		outQuotient.limbs.assign(m - n + 1, 0);
+		for (size_t j = m - n + 1; j-- > 0;)
+		{
+			// Estimate the quotient digit from the top two limbs and refine it with the next one:
+			uint64_t numerator = (uint64_t(un[j + n]) << 32) | un[j + n - 1];
+			uint64_t qHat = numerator / vn[n - 1];
+			uint64_t rHat = numerator - qHat * vn[n - 1];
+			while ((qHat >= base) || (qHat * vn[n - 2] > ((rHat << 32) | un[j + n - 2])))
+			{
+				--qHat;
+				rHat += vn[n - 1];
+				if (rHat >= base) break;
+			}
+
+			// Multiply and subtract:
+			int64_t borrow = 0;
+			int64_t t = 0;
+			for (size_t i = 0; i < n; ++i)
+			{
+				uint64_t p = qHat * vn[i];
+				t = int64_t(un[i + j]) - borrow - int64_t(p & 0xffffffff);
+				un[i + j] = static_cast<uint32_t>(t);
+				borrow = int64_t(p >> 32) - (t >> 32);
+			}
+			t = int64_t(un[j + n]) - borrow;
+			un[j + n] = static_cast<uint32_t>(t);
+
+			// Subtracted too much, add one divisor back:
+			if (t < 0)
+			{
+				--qHat;
+				uint64_t carry = 0;
+				for (size_t i = 0; i < n; ++i)
+				{
+					uint64_t sum = uint64_t(un[i + j]) + vn[i] + carry;
+					un[i + j] = static_cast<uint32_t>(sum);
+					carry = sum >> 32;
+				}
+				un[j + n] = static_cast<uint32_t>(un[j + n] + carry);
+			}
+			outQuotient.limbs[j] = static_cast<uint32_t>(qHat);
+		}
+		outQuotient.normalize();
+
+		// Unnormalize the remainder:
+		outRemainder.limbs.assign(n, 0);
+		for (size_t i = 0; i < n; ++i) outRemainder.limbs[i] = (un[i] >> s) | (s ? un[i + 1] << (32 - s) : 0);
+		outRemainder.normalize();
+	}
+
+	// Reciprocal:
+	BigUnsigned BigUnsigned::reciprocal(
+		const BigUnsigned& b,
+		unsigned inThreadCount
+		)
+	{
+		const size_t n = b.limbs.size();
+		const BigUnsigned power = BigUnsigned(1).shiftLimbsLeft(2 * n);
+
+		BigUnsigned x, remainder;
+		if (n <= barrettThreshold)
+		{
+			divideModulo(power, b, x, remainder);
+			return x;
+		}
+
+		// Start from the reciprocal of the top h limbs, good to about h - 1 limbs:
+		const size_t h = n / 2 + 2;
+		x = reciprocal(b.shiftLimbsRight(n - h), inThreadCount).shiftLimbsLeft(n - h);
+
+		// One Newton step roughly doubles the correct limbs:
+		BigUnsigned product = multiply(b, x, inThreadCount);
+		if (compare(product, power) <= 0)
+		{
+			BigUnsigned error = subtract(power, product);
+			x = add(x, multiply(x, error, inThreadCount).shiftLimbsRight(2 * n));
+		}
+		else
+		{
+			BigUnsigned error = subtract(product, power);
+			x = subtract(x, multiply(x, error, inThreadCount).shiftLimbsRight(2 * n));
+		}
+
+		// What is left is a few units at most:
+		const BigUnsigned one(1);
+		product = multiply(b, x, inThreadCount);
+		while (compare(product, power) > 0)
+		{
+			x = subtract(x, one);
+			product = subtract(product, b);
+		}
+		remainder = subtract(power, product);
+		while (compare(remainder, b) >= 0)
+		{
+			x = add(x, one);
+			remainder = subtract(remainder, b);
+		}
+
+		return x;
+	}
+
+	// Modulo:
+	BigUnsigned BigUnsigned::modulo(
+		const BigUnsigned& a,
+		const BigUnsigned& b,
+		unsigned inThreadCount
+		)
+	{
+		if (compare(a, b) < 0) return a;
+
+		// Short quotients or small divisors are cheaper by long division:
+		const size_t n = b.limbs.size();
+		BigUnsigned quotient, remainder;
+		if ((n <= barrettThreshold) || (a.limbs.size() - n <= barrettThreshold))
+		{
+			divideModulo(a, b, quotient, remainder);
+			return remainder;
+		}
+
+		// Barrett: reduce the top 2n limbs at a time, each pass removes about n limbs:
+		const BigUnsigned inverse = reciprocal(b, inThreadCount);
+		remainder = a;
+		while (compare(remainder, b) >= 0)
+		{
+			const size_t shift = (remainder.limbs.size() > 2 * n) ? remainder.limbs.size() - 2 * n : 0;
+			BigUnsigned top = remainder.shiftLimbsRight(shift);
+
+			// The estimate never exceeds the true quotient and is short by at most 2:
+			quotient = multiply(top, inverse, inThreadCount).shiftLimbsRight(2 * n);
+			top = subtract(top, multiply(quotient, b, inThreadCount));
+			while (compare(top, b) >= 0) top = subtract(top, b);
+
+			remainder = add(top.shiftLimbsLeft(shift), remainder.lowLimbs(shift));
+		}
+
+		return remainder;
+	}
+
+
+	// Find shared factors:
+	vector<SharedFactor> findSharedFactors(
+		const vector<uint64_t>& inNumbers,
+		unsigned inThreadCount
+		)
+	{
+		vector<SharedFactor> shared;
+
+		// Each distinct number goes into the trees once, copies are counted:
+		vector<uint64_t> numbers;
+		for (auto n : inNumbers)
+		{
+			if (n >= 2) numbers.push_back(n);
+		}
+		sort(numbers.begin(), numbers.end());
+		vector<size_t> copies;
+		size_t distinct = 0;
+		for (size_t i = 0; i < numbers.size(); ++i)
+		{
+			if ((distinct > 0) && (numbers[distinct - 1] == numbers[i]))
+			{
+				++copies[distinct - 1];
+				continue;
+			}
+			numbers[distinct++] = numbers[i];
+			copies.push_back(1);
+		}
+		numbers.resize(distinct);
+		if (numbers.empty()) return shared;
+
+		// Threads left for each node when a level has fewer nodes than threads:
+		auto threadsPerNode = [&](size_t nodeCount)
+		{
+			return static_cast<unsigned>(max<size_t>(1, inThreadCount / max<size_t>(nodeCount, 1)));
+		};
+
+		// Product tree, leaves first:
+		vector<vector<BigUnsigned>> tree(1);
+		for (auto n : numbers) tree[0].push_back(BigUnsigned(n));
+		while (tree.back().size() > 1)
+		{
+			const vector<BigUnsigned>& below = tree.back();
+			vector<BigUnsigned> level((below.size() + 1) / 2);
+			const unsigned nodeThreads = threadsPerNode(level.size());
+			parallelFor(level.size(), inThreadCount, [&](size_t i)
+			{
+				level[i] = (2 * i + 1 < below.size()) ? BigUnsigned::multiply(below[2 * i], below[2 * i + 1], nodeThreads) : below[2 * i];
+			});
+			tree.push_back(move(level));
+		}
+
+		// Remainder tree, P mod node^2 from the root down, dropping each product level once it is used:
+		vector<BigUnsigned> remainders(1, tree.back()[0]);
+		tree.pop_back();
+		while (!tree.empty())
+		{
+			const vector<BigUnsigned>& nodes = tree.back();
+			vector<BigUnsigned> level(nodes.size());
+			const unsigned nodeThreads = threadsPerNode(level.size());
+			parallelFor(level.size(), inThreadCount, [&](size_t i)
+			{
+				level[i] = BigUnsigned::modulo(remainders[i / 2], BigUnsigned::multiply(nodes[i], nodes[i], nodeThreads), nodeThreads);
+			});
+			remainders.swap(level);
+			tree.pop_back();
+		}
+
+		// (P mod n^2) / n = (P / n) mod n, which is coprime to n unless another distinct input shares a factor:
+		for (size_t i = 0; i < numbers.size(); ++i)
+		{
+			const uint64_t n = numbers[i];
+			uint64_t factor = 1;
+			if (numbers.size() > 1)
+			{
+				BigUnsigned quotient, remainder;
+				BigUnsigned::divideModulo(remainders[i], BigUnsigned(n), quotient, remainder);
+				factor = factor_algorithms::gcd(quotient.toUint64(), n);
+			}
+
+			// All of n's primes divide other inputs, so its smallest prime is shared (a prime n is left whole):
+			if (factor == n) factor = utils::calculatePrimeFactors(n).front();
+
+			// Otherwise a repeated number shares all of itself with its copies:
+			if ((factor == 1) && (copies[i] > 1)) factor = n;
+			if (factor == 1) continue;
+
+			SharedFactor result = { n, factor };
+			shared.insert(shared.end(), copies[i], result);
+		}
+
+		return shared;
+	}
+
+} // namespace batch_gcd
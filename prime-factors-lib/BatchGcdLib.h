@@ -0,0 +1,154 @@
+///////////////////////////////////////
+///
+///	\file		BatchGcdLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		BatchGcdLib library header
+///
+///	\notes
+///		1. Bernstein's batch gcd ("How to find smooth parts of integers", 2004): the product P of all inputs is
+///			built with a product tree, then a remainder tree gives P mod n_i^2 for every input. Input n_i shares
+///			a factor with some other input exactly when gcd((P mod n_i^2) / n_i, n_i) > 1.
+///		2. BigUnsigned only implements what the trees need. Multiplication is Karatsuba above a small size and a
+///			number-theoretic transform (NTT) above a few thousand limbs, and large remainders use Barrett reduction
+///			with a Newton reciprocal, so every tree level costs O(n log n) and the whole computation is
+///			quasi-linear in the size of the input set.
+///		3. The nodes of each tree level are split over the given number of threads. Near the root, where a level
+///			has fewer nodes than threads, the spare threads go into each node's products (the NTT of one product
+///			is split over them).
+///		4. Equal inputs go into the trees once. A number that is repeated and shares nothing with any other
+///			input is still reported, once per copy, with itself as the shared factor.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef BATCH_GCD_LIB_H
+#define	BATCH_GCD_LIB_H
+
+
+//
+// Local includes:
+//
+//...
+
+
+//
+// Compiler includes:
+//
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace batch_gcd
+{
+
+	/// Arbitrary-precision unsigned integer with 32-bit limbs, least significant first.
+	class BigUnsigned
+	{
+	public:
+
+		/// Default constructor (zero):
+		BigUnsigned() {}
+
+		/// Custom constructor:
+		explicit BigUnsigned(
+			uint64_t inValue							///< Initial value
+			);
+
+
+		//
+		// Member functions:
+		//
+
+		/// Limbs, least significant first, no leading zero limbs.
+		const std::vector<uint32_t>& getLimbs() const { return limbs; }
+
+		/// Number of limbs (0 for zero).
+		std::size_t size() const { return limbs.size(); }
+
+		/// True if the value is zero.
+		bool isZero() const { return limbs.empty(); }
+
+		/// Low 64 bits of the value.
+		uint64_t toUint64() const;
+
+		/// Three-way comparison, returns <0, 0 or >0.
+		static int compare(const BigUnsigned& a, const BigUnsigned& b);
+
+		/// a + b.
+		static BigUnsigned add(const BigUnsigned& a, const BigUnsigned& b);
+
+		/// a - b, requires a >= b.
+		static BigUnsigned subtract(const BigUnsigned& a, const BigUnsigned& b);
+
+		/// a * b, large products are split over up to inThreadCount threads.
+		static BigUnsigned multiply(const BigUnsigned& a, const BigUnsigned& b, unsigned inThreadCount = 1);
+
+		/// Quotient and remainder of a / b (schoolbook long division), b must not be zero.
+		static void divideModulo(const BigUnsigned& a, const BigUnsigned& b, BigUnsigned& outQuotient, BigUnsigned& outRemainder);
+
+		/// a mod b, using Barrett reduction for large b. b must not be zero.
+		static BigUnsigned modulo(const BigUnsigned& a, const BigUnsigned& b, unsigned inThreadCount = 1);
+
+		/// floor(2^(64 * b.size()) / b), b must not be zero.
+		static BigUnsigned reciprocal(const BigUnsigned& b, unsigned inThreadCount = 1);
+
+		/// Value shifted left by whole limbs.
+		BigUnsigned shiftLimbsLeft(std::size_t inLimbs) const;
+
+		/// Value shifted right by whole limbs.
+		BigUnsigned shiftLimbsRight(std::size_t inLimbs) const;
+
+		/// Low inLimbs limbs of the value.
+		BigUnsigned lowLimbs(std::size_t inLimbs) const;
+
+	private:
+
+		//
+		// Member variables:
+		//
+		std::vector<uint32_t> limbs;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Drop leading zero limbs.
+		void normalize();
+
+	};
+
+
+	/// Input that shares a nontrivial factor with at least one other input.
+	struct SharedFactor
+	{
+		uint64_t number;							///< Input number
+		uint64_t sharedFactor;						///< Factor shared with another input, number / sharedFactor is the rest
+	};
+
+
+	/// Find every input that shares a nontrivial factor with another input, in ascending order with one entry per copy.
+	///	Note: Numbers below 2 are ignored. sharedFactor is a prime when all of number's primes are shared, and equals
+	///		   number only when number is a prime or is repeated and shares nothing with the other inputs.
+	std::vector<SharedFactor> findSharedFactors(
+		const std::vector<uint64_t>& inNumbers,			///< Numbers to check against each other
+		unsigned inThreadCount = 1						///< Threads to split each tree level and its large products over
+		);
+
+} // namespace batch_gcd
+
+#endif // BATCH_GCD_LIB_H
@@ -0,0 +1,556 @@
+///////////////////////////////////////
+///
+///	\file		BatchPrimalityLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for BatchPrimalityLib.h
+///
+///	\notes
+///		1. The SIMD kernels are compiled with per-function target attributes, so the rest of the library keeps
+///			the baseline instruction set and a CPU without AVX2/IFMA never runs them. They are only built with
+///			GCC 8+ or Clang on x86-64; everything else gets the scalar kernel.
+///		2. IFMA Montgomery multiplication is CIOS over two 52-bit limbs with R = 2^104. Every intermediate fits the
+///			64-bit accumulators and results are fully reduced, so Montgomery values can be compared for equality.
+///		3. Lanes of a group have different exponents and squaring counts. The exponent is walked left to right
+///			over the longest one with a masked multiply, and the squaring loop runs until the longest lane is
+///			done, each lane ignoring the steps past its own count.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "BatchPrimalityLib.h"
+#include "FactorAlgorithmsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <limits>
+
+#if defined(__x86_64__) && defined(__GNUC__) && (defined(__clang__) || (__GNUC__ >= 8))
+#define BATCH_PRIMALITY_SIMD
+#include <immintrin.h>
+#endif
+
+
+//
+// Namespaces:
+//
+using namespace std;
+namespace fa = factor_algorithms;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	// Same bases as factor_algorithms::isPrime():
+	const uint32_t narrowBases[] = { 2, 7, 61 };
+	const uint32_t wideBases[] = { 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+
+	// Largest number the narrow kernels take:
+	const uint64_t narrowMax = numeric_limits<uint32_t>::max();
+
+	// Decide the numbers Miller-Rabin is not needed for, returns false if n still has to be tested:
+	//	Note: Survivors are odd, above 37^2 and free of primes up to 37, as the kernels expect.
+	bool screen(
+		uint64_t n,
+		uint8_t& isPrime
+		)
+	{
+		static const uint64_t smallPrimes[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+
+		isPrime = 0;
+		if (n < 2) return true;
+		for (auto p : smallPrimes)
+		{
+			if (n == p)
+			{
+				isPrime = 1;
+				return true;
+			}
+			if ((n % p) == 0) return true;
+		}
+		if (n < 37 * 37)
+		{
+			isPrime = 1;
+			return true;
+		}
+		return false;
+	}
+
+	// Write n - 1 = d * 2^s with d odd:
+	void splitPowerOfTwo(
+		uint64_t n,
+		uint64_t& d,
+		uint64_t& s
+		)
+	{
+		d = n - 1;
+		s = 0;
+		while ((d & 1) == 0)
+		{
+			d >>= 1;
+			++s;
+		}
+	}
+
+	// Kernel signature: test groups of up to laneCount screened numbers, numbers[i] < 2^64 (wide) or 2^32 (narrow):
+	typedef void (*GroupTest)(const uint64_t* numbers, size_t count, uint8_t* isPrime);
+
+	// Gather the numbers that survive the screen into groups for groupTest, wide ones go to wideTest:
+	void runGrouped(
+		const uint64_t* numbers,
+		size_t count,
+		uint8_t* isPrime,
+		size_t laneCount,
+		GroupTest narrowTest,
+		GroupTest wideTest
+		)
+	{
+		const size_t maxLanes = 16;
+		uint64_t narrowNumbers[maxLanes], wideNumbers[maxLanes];
+		size_t narrowIndex[maxLanes], wideIndex[maxLanes];
+		size_t narrowCount = 0, wideCount = 0;
+		uint8_t results[maxLanes];
+
+		auto flush = [&](uint64_t* group, size_t* index, size_t& groupCount, GroupTest test)
+		{
+			test(group, groupCount, results);
+			for (size_t lane = 0; lane < groupCount; ++lane) isPrime[index[lane]] = results[lane];
+			groupCount = 0;
+		};
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (screen(numbers[i], isPrime[i])) continue;
+
+			if (numbers[i] <= narrowMax)
+			{
+				narrowIndex[narrowCount] = i;
+				narrowNumbers[narrowCount++] = numbers[i];
+				if (narrowCount == laneCount) flush(narrowNumbers, narrowIndex, narrowCount, narrowTest);
+			}
+			else
+			{
+				wideIndex[wideCount] = i;
+				wideNumbers[wideCount++] = numbers[i];
+				if (wideCount == laneCount) flush(wideNumbers, wideIndex, wideCount, wideTest);
+			}
+		}
+
+		// Partial groups at the end:
+		if (narrowCount != 0) flush(narrowNumbers, narrowIndex, narrowCount, narrowTest);
+		if (wideCount != 0) flush(wideNumbers, wideIndex, wideCount, wideTest);
+	}
+
+	// Scalar group test:
+	void scalarTest(
+		const uint64_t* numbers,
+		size_t count,
+		uint8_t* isPrime
+		)
+	{
+		for (size_t i = 0; i < count; ++i) isPrime[i] = fa::isPrime(numbers[i]) ? 1 : 0;
+	}
+
+#if defined(BATCH_PRIMALITY_SIMD)
+
+	//
+	// AVX2 kernel, 4 lanes of 32-bit Montgomery arithmetic in 64-bit slots:
+	//
+
+	// Montgomery product (same reduction as factor_algorithms::Montgomery<uint32_t>):
+	__attribute__((target("avx2")))
+	inline __m256i multiplyAvx2(
+		__m256i a,
+		__m256i b,
+		__m256i n,
+		__m256i nInverse
+		)
+	{
+		// Only the low 32 bits of each slot take part in _mm256_mul_epu32, so no masking is needed:
+		__m256i t = _mm256_mul_epu32(a, b);
+		__m256i m = _mm256_mul_epu32(t, nInverse);
+		__m256i mn = _mm256_mul_epu32(m, n);
+		__m256i tHigh = _mm256_srli_epi64(t, 32);
+		__m256i mnHigh = _mm256_srli_epi64(mn, 32);
+		__m256i result = _mm256_sub_epi64(tHigh, mnHigh);
+		return _mm256_add_epi64(result, _mm256_and_si256(_mm256_cmpgt_epi64(mnHigh, tHigh), n));
+	}
+
+	// Lanes where a == b as a 4-bit mask:
+	__attribute__((target("avx2")))
+	inline uint32_t equalAvx2(
+		__m256i a,
+		__m256i b
+		)
+	{
+		return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b))));
+	}
+
+	// Miller-Rabin on up to 4 screened numbers below 2^32:
+	__attribute__((target("avx2")))
+	void avx2NarrowTest(
+		const uint64_t* numbers,
+		size_t count,
+		uint8_t* isPrime
+		)
+	{
+		const size_t laneCount = 4;
+		alignas(32) uint64_t n[laneCount], nInverse[laneCount], one[laneCount], rSquared[laneCount], d[laneCount], s[laneCount];
+
+		// Unused lanes repeat the first number:
+		uint64_t maxD = 0, maxS = 0;
+		for (size_t lane = 0; lane < laneCount; ++lane)
+		{
+			uint32_t modulus = static_cast<uint32_t>(numbers[lane < count ? lane : 0]);
+			uint32_t inverse = modulus;
+			for (int i = 0; i < 4; ++i) inverse *= 2 - modulus * inverse;
+
+			n[lane] = modulus;
+			nInverse[lane] = inverse;
+			one[lane] = (uint64_t(1) << 32) % modulus;
+			rSquared[lane] = (one[lane] * one[lane]) % modulus;
+			splitPowerOfTwo(modulus, d[lane], s[lane]);
+			if (d[lane] > maxD) maxD = d[lane];
+			if (s[lane] > maxS) maxS = s[lane];
+		}
+
+		const __m256i nVector = _mm256_load_si256(reinterpret_cast<const __m256i*>(n));
+		const __m256i nInverseVector = _mm256_load_si256(reinterpret_cast<const __m256i*>(nInverse));
+		const __m256i oneVector = _mm256_load_si256(reinterpret_cast<const __m256i*>(one));
+		const __m256i rSquaredVector = _mm256_load_si256(reinterpret_cast<const __m256i*>(rSquared));
+		const __m256i minusOneVector = _mm256_sub_epi64(nVector, oneVector);
+		const __m256i dVector = _mm256_load_si256(reinterpret_cast<const __m256i*>(d));
+		const __m256i sVector = _mm256_load_si256(reinterpret_cast<const __m256i*>(s));
+		const uint32_t allLanes = (1u << laneCount) - 1;
+
+		uint32_t composite = 0;
+		for (auto b : narrowBases)
+		{
+			// Bases are below every screened number:
+			__m256i a = multiplyAvx2(_mm256_set1_epi64x(b), rSquaredVector, nVector, nInverseVector);
+
+			// x = a^d, left to right over the longest exponent:
+			__m256i x = oneVector;
+			for (int bit = 63 - __builtin_clzll(maxD); bit >= 0; --bit)
+			{
+				// The blend only looks at the sign bit, so the exponent bit is shifted up there:
+				x = multiplyAvx2(x, x, nVector, nInverseVector);
+				__m256i take = _mm256_sll_epi64(dVector, _mm_cvtsi32_si128(63 - bit));
+				__m256i y = multiplyAvx2(x, a, nVector, nInverseVector);
+				x = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(x), _mm256_castsi256_pd(y), _mm256_castsi256_pd(take)));
+			}
+
+			// Lanes pass with x = +-1, or with x reaching -1 within s - 1 squarings:
+			uint32_t passed = equalAvx2(x, oneVector) | equalAvx2(x, minusOneVector);
+			for (uint64_t round = 1; (round < maxS) && (passed != allLanes); ++round)
+			{
+				x = multiplyAvx2(x, x, nVector, nInverseVector);
+				__m256i inRange = _mm256_cmpgt_epi64(sVector, _mm256_set1_epi64x(static_cast<long long>(round)));
+				uint32_t rangeMask = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(inRange)));
+				passed |= equalAvx2(x, minusOneVector) & rangeMask;
+			}
+
+			composite |= ~passed & allLanes;
+			if (composite == allLanes) break;
+		}
+
+		for (size_t lane = 0; lane < count; ++lane) isPrime[lane] = ((composite >> lane) & 1) ? 0 : 1;
+	}
+
+
+	//
+	// AVX-512 IFMA kernel, 16 lanes (two vectors of 8) of 64-bit Montgomery arithmetic on two 52-bit limbs:
+	//
+
+	// Montgomery product of (a1:a0) and (b1:b0), R = 2^104, result in (outHigh:outLow) and below n:
+	__attribute__((target("avx512f,avx512ifma")))
+	inline void multiplyIfma(
+		__m512i a0,
+		__m512i a1,
+		__m512i b0,
+		__m512i b1,
+		__m512i n0,
+		__m512i n1,
+		__m512i nInverse,
+		__m512i& outLow,
+		__m512i& outHigh
+		)
+	{
+		// Shifts are the zero-masked forms, the plain ones trip GCC's uninitialized warning in target functions:
+		const __mmask8 allLanes = 0xff;
+		const __m512i zero = _mm512_setzero_si512();
+		const __m512i mask52 = _mm512_set1_epi64((int64_t(1) << 52) - 1);
+
+		__m512i t0 = zero, t1 = zero, t2 = zero;
+		const __m512i bLimbs[2] = { b0, b1 };
+		for (int i = 0; i < 2; ++i)
+		{
+			// T += a * b_i:
+			t0 = _mm512_madd52lo_epu64(t0, a0, bLimbs[i]);
+			t1 = _mm512_madd52hi_epu64(t1, a0, bLimbs[i]);
+			t1 = _mm512_madd52lo_epu64(t1, a1, bLimbs[i]);
+			t2 = _mm512_madd52hi_epu64(t2, a1, bLimbs[i]);
+
+			// T += m * n with m chosen so the low limb becomes 0 mod 2^52:
+			__m512i m = _mm512_madd52lo_epu64(zero, t0, nInverse);
+			t0 = _mm512_madd52lo_epu64(t0, m, n0);
+			t1 = _mm512_madd52hi_epu64(t1, m, n0);
+			t1 = _mm512_madd52lo_epu64(t1, m, n1);
+			t2 = _mm512_madd52hi_epu64(t2, m, n1);
+
+			// T /= 2^52, the low limb only carries:
+			t0 = _mm512_add_epi64(t1, _mm512_maskz_srli_epi64(allLanes, t0, 52));
+			t1 = t2;
+			t2 = zero;
+		}
+
+		// Normalize to 52-bit limbs, T < 2n:
+		t1 = _mm512_add_epi64(t1, _mm512_maskz_srli_epi64(allLanes, t0, 52));
+		t0 = _mm512_and_si512(t0, mask52);
+
+		// T - n, kept where it does not go negative:
+		__m512i d0 = _mm512_sub_epi64(t0, n0);
+		__m512i borrow = _mm512_maskz_srli_epi64(allLanes, d0, 63);
+		d0 = _mm512_and_si512(d0, mask52);
+		__m512i d1 = _mm512_sub_epi64(_mm512_sub_epi64(t1, n1), borrow);
+		__mmask8 negative = _mm512_cmplt_epi64_mask(d1, zero);
+		outLow = _mm512_mask_blend_epi64(negative, d0, t0);
+		outHigh = _mm512_mask_blend_epi64(negative, d1, t1);
+	}
+
+	// Lanes where (aHigh:aLow) == (bHigh:bLow):
+	__attribute__((target("avx512f,avx512ifma")))
+	inline __mmask8 equalIfma(
+		__m512i aLow,
+		__m512i aHigh,
+		__m512i bLow,
+		__m512i bHigh
+		)
+	{
+		return _mm512_cmpeq_epi64_mask(aLow, bLow) & _mm512_cmpeq_epi64_mask(aHigh, bHigh);
+	}
+
+	// Miller-Rabin on up to 16 screened numbers of any size:
+	//	Note: A Montgomery product is one long dependency chain, so two independent vectors of 8 lanes are carried
+	//		   side by side to keep the multipliers busy while either waits on its previous step.
+	__attribute__((target("avx512f,avx512ifma")))
+	void ifmaTest(
+		const uint64_t* numbers,
+		size_t count,
+		uint8_t* isPrime
+		)
+	{
+		const size_t vectorCount = 2;
+		const size_t laneCount = 8 * vectorCount;
+		const uint64_t mask52 = (uint64_t(1) << 52) - 1;
+		alignas(64) uint64_t n0[laneCount], n1[laneCount], nInverse[laneCount], one0[laneCount], one1[laneCount];
+		alignas(64) uint64_t rSquared0[laneCount], rSquared1[laneCount], minusOne0[laneCount], minusOne1[laneCount];
+		alignas(64) uint64_t d[laneCount], s[laneCount], base0[laneCount], base1[laneCount];
+
+		// Unused lanes repeat the first number. Only narrow groups can use the three bases:
+		bool narrow = true;
+		uint64_t maxD = 0, maxS = 0;
+		for (size_t lane = 0; lane < laneCount; ++lane)
+		{
+			uint64_t modulus = numbers[lane < count ? lane : 0];
+			if (modulus > narrowMax) narrow = false;
+
+			// -modulus^-1 mod 2^52 by Newton iteration:
+			uint64_t inverse = modulus;
+			for (int i = 0; i < 5; ++i) inverse *= 2 - modulus * inverse;
+
+			// R = 2^104 and R^2 mod modulus, from 2^64 mod modulus:
+			uint64_t r64 = (0 - modulus) % modulus;
+			uint64_t one = static_cast<uint64_t>((static_cast<unsigned __int128>(r64) << 40) % modulus);
+			uint64_t rSquared = static_cast<uint64_t>((static_cast<unsigned __int128>(one) * one) % modulus);
+
+			n0[lane] = modulus & mask52;
+			n1[lane] = modulus >> 52;
+			nInverse[lane] = (0 - inverse) & mask52;
+			one0[lane] = one & mask52;
+			one1[lane] = one >> 52;
+			rSquared0[lane] = rSquared & mask52;
+			rSquared1[lane] = rSquared >> 52;
+			minusOne0[lane] = (modulus - one) & mask52;
+			minusOne1[lane] = (modulus - one) >> 52;
+			splitPowerOfTwo(modulus, d[lane], s[lane]);
+			if (d[lane] > maxD) maxD = d[lane];
+			if (s[lane] > maxS) maxS = s[lane];
+		}
+
+		__m512i nLow[vectorCount], nHigh[vectorCount], nInverseVector[vectorCount], oneLow[vectorCount], oneHigh[vectorCount];
+		__m512i rSquaredLow[vectorCount], rSquaredHigh[vectorCount], minusOneLow[vectorCount], minusOneHigh[vectorCount];
+		__m512i dVector[vectorCount], sVector[vectorCount];
+		for (size_t v = 0; v < vectorCount; ++v)
+		{
+			nLow[v] = _mm512_load_si512(n0 + 8 * v);
+			nHigh[v] = _mm512_load_si512(n1 + 8 * v);
+			nInverseVector[v] = _mm512_load_si512(nInverse + 8 * v);
+			oneLow[v] = _mm512_load_si512(one0 + 8 * v);
+			oneHigh[v] = _mm512_load_si512(one1 + 8 * v);
+			rSquaredLow[v] = _mm512_load_si512(rSquared0 + 8 * v);
+			rSquaredHigh[v] = _mm512_load_si512(rSquared1 + 8 * v);
+			minusOneLow[v] = _mm512_load_si512(minusOne0 + 8 * v);
+			minusOneHigh[v] = _mm512_load_si512(minusOne1 + 8 * v);
+			dVector[v] = _mm512_load_si512(d + 8 * v);
+			sVector[v] = _mm512_load_si512(s + 8 * v);
+		}
+		const uint32_t allLanes = (uint32_t(1) << laneCount) - 1;
+
+		const uint32_t* bases = narrow ? narrowBases : wideBases;
+		size_t baseCount = narrow ? (sizeof(narrowBases) / sizeof(narrowBases[0])) : (sizeof(wideBases) / sizeof(wideBases[0]));
+
+		uint32_t composite = 0;
+		for (size_t b = 0; b < baseCount; ++b)
+		{
+			// Bases that are a multiple of the number prove nothing and pass:
+			uint32_t passed = 0;
+			for (size_t lane = 0; lane < laneCount; ++lane)
+			{
+				uint64_t modulus = (n1[lane] << 52) | n0[lane];
+				uint64_t a = bases[b] % modulus;
+				if (a == 0) passed |= uint32_t(1) << lane;
+				base0[lane] = a & mask52;
+				base1[lane] = a >> 52;
+			}
+
+			__m512i aLow[vectorCount], aHigh[vectorCount], xLow[vectorCount], xHigh[vectorCount];
+			for (size_t v = 0; v < vectorCount; ++v)
+			{
+				multiplyIfma(_mm512_load_si512(base0 + 8 * v), _mm512_load_si512(base1 + 8 * v), rSquaredLow[v], rSquaredHigh[v],
+							 nLow[v], nHigh[v], nInverseVector[v], aLow[v], aHigh[v]);
+				xLow[v] = oneLow[v];
+				xHigh[v] = oneHigh[v];
+			}
+
+			// x = a^d, left to right over the longest exponent:
+			for (int bit = 63 - __builtin_clzll(maxD); bit >= 0; --bit)
+			{
+				const __m512i bitVector = _mm512_set1_epi64(int64_t(uint64_t(1) << bit));
+				for (size_t v = 0; v < vectorCount; ++v)
+				{
+					multiplyIfma(xLow[v], xHigh[v], xLow[v], xHigh[v], nLow[v], nHigh[v], nInverseVector[v], xLow[v], xHigh[v]);
+				}
+				for (size_t v = 0; v < vectorCount; ++v)
+				{
+					__m512i yLow, yHigh;
+					multiplyIfma(xLow[v], xHigh[v], aLow[v], aHigh[v], nLow[v], nHigh[v], nInverseVector[v], yLow, yHigh);
+					__mmask8 take = _mm512_test_epi64_mask(dVector[v], bitVector);
+					xLow[v] = _mm512_mask_blend_epi64(take, xLow[v], yLow);
+					xHigh[v] = _mm512_mask_blend_epi64(take, xHigh[v], yHigh);
+				}
+			}
+
+			// Lanes pass with x = +-1, or with x reaching -1 within s - 1 squarings:
+			for (size_t v = 0; v < vectorCount; ++v)
+			{
+				uint32_t hit = equalIfma(xLow[v], xHigh[v], oneLow[v], oneHigh[v]) | equalIfma(xLow[v], xHigh[v], minusOneLow[v], minusOneHigh[v]);
+				passed |= hit << (8 * v);
+			}
+			for (uint64_t round = 1; (round < maxS) && (passed != allLanes); ++round)
+			{
+				const __m512i roundVector = _mm512_set1_epi64(int64_t(round));
+				for (size_t v = 0; v < vectorCount; ++v)
+				{
+					multiplyIfma(xLow[v], xHigh[v], xLow[v], xHigh[v], nLow[v], nHigh[v], nInverseVector[v], xLow[v], xHigh[v]);
+					uint32_t hit = equalIfma(xLow[v], xHigh[v], minusOneLow[v], minusOneHigh[v]) & _mm512_cmpgt_epu64_mask(sVector[v], roundVector);
+					passed |= hit << (8 * v);
+				}
+			}
+
+			composite |= ~passed & allLanes;
+			if (composite == allLanes) break;
+		}
+
+		for (size_t lane = 0; lane < count; ++lane) isPrime[lane] = ((composite >> lane) & 1) ? 0 : 1;
+	}
+
+#endif // BATCH_PRIMALITY_SIMD
+
+} // namespace
+
+
+//
+// Main library namespace:
+//
+namespace batch_primality
+{
+
+	// Kernel supported:
+	bool isSupported(
+		Kernel kernel
+		)
+	{
+		switch (kernel)
+		{
+		case Kernel::scalar:
+			return true;
+
+#if defined(BATCH_PRIMALITY_SIMD)
+		case Kernel::avx2:
+			return __builtin_cpu_supports("avx2");
+
+		case Kernel::avx512ifma:
+			return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+#endif
+
+		default:
+			return false;
+		}
+	}
+
+	// Best kernel:
+	//	Note: Function-local statics are initialized exactly once, even with concurrent callers.
+	Kernel bestKernel()
+	{
+		static const Kernel best = isSupported(Kernel::avx512ifma) ? Kernel::avx512ifma
+								 : isSupported(Kernel::avx2) ? Kernel::avx2
+								 : Kernel::scalar;
+		return best;
+	}
+
+	// Primality batch with best kernel:
+	void isPrimeBatch(
+		const uint64_t* numbers,
+		size_t count,
+		uint8_t* isPrime
+		)
+	{
+		isPrimeBatch(numbers, count, isPrime, bestKernel());
+	}
+
+	// Primality batch:
+	void isPrimeBatch(
+		const uint64_t* numbers,
+		size_t count,
+		uint8_t* isPrime,
+		Kernel kernel
+		)
+	{
+		switch (kernel)
+		{
+#if defined(BATCH_PRIMALITY_SIMD)
+		case Kernel::avx512ifma:
+			runGrouped(numbers, count, isPrime, 16, ifmaTest, ifmaTest);
+			return;
+
+		case Kernel::avx2:
+			runGrouped(numbers, count, isPrime, 4, avx2NarrowTest, scalarTest);
+			return;
+#endif
+
+		default:
+			for (size_t i = 0; i < count; ++i) isPrime[i] = fa::isPrime(numbers[i]) ? 1 : 0;
+			return;
+		}
+	}
+
+} // namespace batch_primality
@@ -0,0 +1,97 @@
+///////////////////////////////////////
+///
+///	\file		BatchPrimalityLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		BatchPrimalityLib library header
+///
+///	\notes
+///		1. Primality of many independent numbers at once. After a cheap scalar screen (tiny numbers and small
+///			prime divisors) the survivors are gathered into groups that run Montgomery Miller-Rabin side by side
+///			in SIMD lanes, so bulk tests of large primes keep the multipliers busy instead of waiting on one
+///			dependency chain at a time.
+///		2. Kernels, the fastest one the CPU supports is chosen at runtime:
+///			- avx512ifma: 16 lanes (two vectors of 8) of 64-bit moduli held as two 52-bit limbs, multiplied with
+///			  the IFMA 52-bit multiply-adds. Handles every number.
+///			- avx2: 4 lanes of 32-bit moduli. Numbers of 33 bits and more have no fast AVX2 multiply and go to the
+///			  scalar kernel.
+///			- scalar: factor_algorithms::isPrime() one number at a time.
+///		3. Every kernel uses the same deterministic bases as factor_algorithms::isPrime(), so all of them give
+///			exact answers and agree with each other.
+///		4. Rho is not vectorized: its walks end after very different numbers of steps and need a gcd at every
+///			batch, so lanes would mostly sit idle. It stays with factor_algorithms::pollardRho().
+///		5. No heap allocations, lanes are gathered into fixed-size groups on the stack.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef BATCH_PRIMALITY_LIB_H
+#define	BATCH_PRIMALITY_LIB_H
+
+
+//
+// Local includes:
+//
+//...
+
+
+//
+// Compiler includes:
+//
+#include <cstddef>
+#include <stdint.h>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace batch_primality
+{
+
+	/// Miller-Rabin kernels.
+	enum class Kernel
+	{
+		scalar,										///< One number at a time
+		avx2,										///< 4 lanes, numbers below 2^32
+		avx512ifma									///< 16 lanes, any number
+	};
+
+
+	/// True if this build and this CPU can run inKernel.
+	bool isSupported(
+		Kernel inKernel								///< Kernel to check
+		);
+
+
+	/// Fastest kernel supported here (checked once).
+	Kernel bestKernel();
+
+
+	/// Test every number for primality with the fastest supported kernel.
+	void isPrimeBatch(
+		const uint64_t* inNumbers,					///< Numbers to test
+		std::size_t inCount,						///< Number of numbers
+		uint8_t* outIsPrime							///< 1 if prime, 0 if not, for each number
+		);
+
+
+	/// Test every number for primality with the given kernel, which must be supported.
+	void isPrimeBatch(
+		const uint64_t* inNumbers,					///< Numbers to test
+		std::size_t inCount,						///< Number of numbers
+		uint8_t* outIsPrime,						///< 1 if prime, 0 if not, for each number
+		Kernel inKernel								///< Kernel to use
+		);
+
+} // namespace batch_primality
+
+#endif // BATCH_PRIMALITY_LIB_H
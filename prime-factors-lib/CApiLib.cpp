@@ -0,0 +1,215 @@
+///////////////////////////////////////
+///
+///	\file		CApiLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for CApiLib.h
+///
+///	\notes
+///		1. Numbers are factored with factor_generator::FactorGenerator, which keeps all of its state inside the
+///			object. Together with the caller's buffers this is what keeps the calls free of heap allocations.
+///		2. No exception may cross into C: every entry point catches everything and returns PF_ERROR_INTERNAL.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "CApiLib.h"
+#include "BatchPrimalityLib.h"
+#include "FactorGeneratorLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <exception>
+
+
+//
+// Namespaces:
+//
+using namespace std;
+namespace fg = factor_generator;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	// Factor number into outFactors, counting past capacity without writing so the caller learns the size needed:
+	size_t factorInto(
+		uint64_t number,
+		uint64_t* outFactors,
+		size_t capacity
+		)
+	{
+		if (number < 2) return 0;
+
+		fg::FactorGenerator generator(number);
+		size_t count = 0;
+		uint64_t factor = 0;
+		while (generator.next(factor))
+		{
+			if (count < capacity) outFactors[count] = factor;
+			++count;
+		}
+		return count;
+	}
+
+} // namespace
+
+
+//
+// C interface:
+//
+extern "C"
+{
+
+	// ABI version:
+	uint32_t pf_abi_version(void)
+	{
+		return PF_ABI_VERSION;
+	}
+
+	// Status string:
+	const char* pf_status_string(
+		int32_t status
+		)
+	{
+		switch (status)
+		{
+		case PF_OK: return "success";
+		case PF_ERROR_NULL_ARGUMENT: return "a required pointer argument was null";
+		case PF_ERROR_BUFFER_TOO_SMALL: return "the output buffer is too small";
+		case PF_ERROR_INTERNAL: return "internal error";
+		default: return "unknown status code";
+		}
+	}
+
+	// Factor one number:
+	int32_t pf_factor(
+		uint64_t number,
+		uint64_t* out_factors,
+		size_t capacity,
+		size_t* out_count
+		)
+	{
+		try
+		{
+			if ((out_count == nullptr) || ((out_factors == nullptr) && (capacity > 0))) return PF_ERROR_NULL_ARGUMENT;
+
+			*out_count = factorInto(number, out_factors, capacity);
+			return (*out_count <= capacity) ? PF_OK : PF_ERROR_BUFFER_TOO_SMALL;
+		}
+		catch (...)
+		{
+			return PF_ERROR_INTERNAL;
+		}
+	}
+
+	// Factor batch into packed buffer:
+	int32_t pf_factor_batch(
+		const uint64_t* numbers,
+		size_t count,
+		uint64_t* out_factors,
+		size_t factors_capacity,
+		size_t* out_offsets,
+		size_t* out_done
+		)
+	{
+		try
+		{
+			if ((out_offsets == nullptr) || (out_done == nullptr)) return PF_ERROR_NULL_ARGUMENT;
+			if ((count > 0) && (numbers == nullptr)) return PF_ERROR_NULL_ARGUMENT;
+			if ((out_factors == nullptr) && (factors_capacity > 0)) return PF_ERROR_NULL_ARGUMENT;
+
+			*out_done = 0;
+			out_offsets[0] = 0;
+			size_t used = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				// A number that does not fit is not counted as done, its partial factors are simply overwritten later:
+				size_t factorCount = factorInto(numbers[i], out_factors + used, factors_capacity - used);
+				if (factorCount > factors_capacity - used) return PF_ERROR_BUFFER_TOO_SMALL;
+
+				used += factorCount;
+				out_offsets[i + 1] = used;
+				*out_done = i + 1;
+			}
+			return PF_OK;
+		}
+		catch (...)
+		{
+			return PF_ERROR_INTERNAL;
+		}
+	}
+
+	// Factor batch into fixed rows:
+	int32_t pf_factor_batch_fixed(
+		const uint64_t* numbers,
+		size_t count,
+		uint64_t* out_factors,
+		uint8_t* out_counts
+		)
+	{
+		try
+		{
+			if ((count > 0) && ((numbers == nullptr) || (out_factors == nullptr) || (out_counts == nullptr))) return PF_ERROR_NULL_ARGUMENT;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				out_counts[i] = static_cast<uint8_t>(factorInto(numbers[i], out_factors + i * PF_MAX_FACTORS, PF_MAX_FACTORS));
+			}
+			return PF_OK;
+		}
+		catch (...)
+		{
+			return PF_ERROR_INTERNAL;
+		}
+	}
+
+	// Smallest factor batch:
+	int32_t pf_smallest_factor_batch(
+		const uint64_t* numbers,
+		size_t count,
+		uint64_t* out_smallest
+		)
+	{
+		try
+		{
+			if ((count > 0) && ((numbers == nullptr) || (out_smallest == nullptr))) return PF_ERROR_NULL_ARGUMENT;
+
+			for (size_t i = 0; i < count; ++i) out_smallest[i] = fg::smallestPrimeFactor(numbers[i]);
+			return PF_OK;
+		}
+		catch (...)
+		{
+			return PF_ERROR_INTERNAL;
+		}
+	}
+
+	// Primality batch:
+	int32_t pf_is_prime_batch(
+		const uint64_t* numbers,
+		size_t count,
+		uint8_t* out_is_prime
+		)
+	{
+		try
+		{
+			if ((count > 0) && ((numbers == nullptr) || (out_is_prime == nullptr))) return PF_ERROR_NULL_ARGUMENT;
+
+			batch_primality::isPrimeBatch(numbers, count, out_is_prime);
+			return PF_OK;
+		}
+		catch (...)
+		{
+			return PF_ERROR_INTERNAL;
+		}
+	}
+
+} // extern "C"
@@ -0,0 +1,133 @@
+///////////////////////////////////////
+///
+///	\file		CApiLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		CApiLib library header (C interface of the prime-factors-c shared library)
+///
+///	\notes
+///		1. Plain C so the factorizer can be loaded in-process from other languages. Only fixed-width integer
+///			types cross the boundary, nothing is returned by the library that the caller has to free, and no
+///			function throws: every call returns a PF_* status code.
+///		2. The batch calls fill caller-provided buffers and allocate nothing on the heap, so calling them costs
+///			little more than the factoring itself. Factors always come out in ascending order, with multiplicity.
+///		3. Numbers below 2 have no prime factors and come out with a count of 0. Every uint64_t is accepted.
+///		4. The interface is versioned: PF_ABI_VERSION only changes when existing functions change, new functions
+///			can be added without changing it. pf_abi_version() tells which version a loaded library implements.
+///		5. All functions are thread safe and may be called from any number of threads at once.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef C_API_LIB_H
+#define	C_API_LIB_H
+
+
+//
+// Compiler includes:
+//
+#include <stddef.h>
+#include <stdint.h>
+
+
+//
+// Export macro, PRIME_FACTORS_C_EXPORTS is only defined while building the shared library:
+//	Note: Callers on Windows get no dllimport, calls then go through the import library's thunks. That costs one
+//		   jump but lets the same header serve the DLL and a static build (the Visual Studio test project).
+//
+#if defined(WIN32) || defined(_WIN32)
+	#if defined(PRIME_FACTORS_C_EXPORTS)
+		#define PF_API __declspec(dllexport)
+	#else
+		#define PF_API
+	#endif
+#elif defined(__GNUC__)
+	#define PF_API __attribute__((visibility("default")))
+#else
+	#define PF_API
+#endif
+
+
+//
+// Constants:
+//
+
+/// Version of this interface.
+#define PF_ABI_VERSION 1
+
+/// Most prime factors a uint64_t can have (2^63 has 63), so a buffer of this size always fits one number.
+#define PF_MAX_FACTORS 64
+
+/// Status codes:
+#define PF_OK 0								///< Success
+#define PF_ERROR_NULL_ARGUMENT 1			///< A required pointer was null
+#define PF_ERROR_BUFFER_TOO_SMALL 2			///< The output buffer filled up before every number was done
+#define PF_ERROR_INTERNAL 3					///< Unexpected failure inside the library
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/// Get PF_ABI_VERSION of the loaded library.
+	PF_API uint32_t pf_abi_version(void);
+
+	/// Get a static, human-readable description of a status code (never null).
+	PF_API const char* pf_status_string(
+		int32_t status								///< Status code returned by a pf_* call
+		);
+
+	/// Factor one number into out_factors.
+	///	Note: On PF_ERROR_BUFFER_TOO_SMALL *out_count is the number of factors needed, a capacity of
+	///		   PF_MAX_FACTORS is always enough.
+	PF_API int32_t pf_factor(
+		uint64_t number,							///< Number to factor
+		uint64_t* out_factors,						///< Buffer for the prime factors, ascending
+		size_t capacity,							///< Size of out_factors
+		size_t* out_count							///< Number of prime factors written
+		);
+
+	/// Factor count numbers into one packed buffer: the factors of numbers[i] are
+	///	out_factors[out_offsets[i]] .. out_factors[out_offsets[i + 1] - 1].
+	///	Note: On PF_ERROR_BUFFER_TOO_SMALL the first *out_done numbers are complete (out_offsets valid up to
+	///		   out_offsets[*out_done]), so the caller can continue from numbers + *out_done with a fresh buffer.
+	PF_API int32_t pf_factor_batch(
+		const uint64_t* numbers,					///< Numbers to factor
+		size_t count,								///< Number of numbers
+		uint64_t* out_factors,						///< Buffer for the prime factors of all numbers
+		size_t factors_capacity,					///< Size of out_factors
+		size_t* out_offsets,						///< count + 1 offsets into out_factors
+		size_t* out_done							///< Numbers completely written
+		);
+
+	/// Factor count numbers into fixed rows: the factors of numbers[i] are
+	///	out_factors[i * PF_MAX_FACTORS] .. out_factors[i * PF_MAX_FACTORS + out_counts[i] - 1]. Cannot run out of room.
+	PF_API int32_t pf_factor_batch_fixed(
+		const uint64_t* numbers,					///< Numbers to factor
+		size_t count,								///< Number of numbers
+		uint64_t* out_factors,						///< count * PF_MAX_FACTORS factors
+		uint8_t* out_counts							///< count factor counts
+		);
+
+	/// Smallest prime factor of each number (0 for numbers below 2), cheaper than factoring completely.
+	PF_API int32_t pf_smallest_factor_batch(
+		const uint64_t* numbers,					///< Numbers to inspect
+		size_t count,								///< Number of numbers
+		uint64_t* out_smallest						///< count smallest prime factors
+		);
+
+	/// Primality of each number: 1 if prime, 0 if not (numbers below 2 are not prime).
+	PF_API int32_t pf_is_prime_batch(
+		const uint64_t* numbers,					///< Numbers to test
+		size_t count,								///< Number of numbers
+		uint8_t* out_is_prime						///< count flags
+		);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // C_API_LIB_H
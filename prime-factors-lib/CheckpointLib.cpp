@@ -0,0 +1,252 @@
+///////////////////////////////////////
+///
+///	\file		CheckpointLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for CheckpointLib.h
+///
+///	\notes
+///		1. Checkpoints are small text files of 'key = value' lines, like the dispatch config.
+///		2. rename() cannot replace a file on Windows, the old checkpoint is removed first there. A crash between
+///			the two leaves only '<file>.tmp', which loadCheckpoint() falls back to.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "CheckpointLib.h"
+#include "UtilsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+
+//
+// Namespaces:
+//
+using namespace std;
+namespace u = utils;
+
+
+//
+// Main library namespace:
+//
+namespace checkpoint
+{
+
+	// Has checkpoint:
+	bool hasCheckpoint(
+		const string& fileName
+		)
+	{
+		return ifstream(fileName).is_open() || ifstream(fileName + ".tmp").is_open();
+	}
+
+	// Load checkpoint:
+	Position loadCheckpoint(
+		const string& fileName
+		)
+	{
+		string usedFileName = fileName;
+		ifstream file(usedFileName);
+		if (!file.is_open())
+		{
+			usedFileName = fileName + ".tmp";
+			file.open(usedFileName);
+		}
+		if (!file.is_open())
+		{
+			throw runtime_error(string("Error: Problem(s) occured while trying to open the file: '") + fileName + string("'; aborting."));
+		}
+
+		Position position;
+		bool hasInputBytes = false, hasLines = false, hasOutputBytes = false;
+		string line;
+		while (getline(file, line))
+		{
+			// Skip blank lines and comments, every other line is 'key = value':
+			istringstream lineStream(line);
+			string key, equals;
+			uint64_t value = 0;
+			if (!(lineStream >> key) || (key[0] == '#')) continue;
+			if (!(lineStream >> equals >> value) || (equals != "="))
+			{
+				throw runtime_error(string("Error: Invalid line '") + line + string("' in '") + usedFileName + string("'; aborting."));
+			}
+
+			if (key == "inputBytes") { position.inputBytes = value; hasInputBytes = true; }
+			else if (key == "lines") { position.lines = value; hasLines = true; }
+			else if (key == "outputBytes") { position.outputBytes = value; hasOutputBytes = true; }
+			else
+			{
+				throw runtime_error(string("Error: Unknown key '") + key + string("' in '") + usedFileName + string("'; aborting."));
+			}
+		}
+
+		if (!hasInputBytes || !hasLines || !hasOutputBytes)
+		{
+			throw runtime_error(string("Error: The checkpoint '") + usedFileName + string("' is incomplete; aborting."));
+		}
+		return position;
+	}
+
+	// Save checkpoint:
+	void saveCheckpoint(
+		const Position& position,
+		const string& fileName
+		)
+	{
+		string tempFileName = fileName + ".tmp";
+		{
+			ofstream file(tempFileName, ios::trunc);
+			if (!file.is_open())
+			{
+				throw runtime_error(string("Error: Problem(s) occured while trying to open the file: '") + tempFileName + string("'; aborting."));
+			}
+
+			file << "# prime-factors checkpoint" << '\n'
+				 << "inputBytes = " << position.inputBytes << '\n'
+				 << "lines = " << position.lines << '\n'
+				 << "outputBytes = " << position.outputBytes << '\n';
+			file.close();
+			if (file.fail())
+			{
+				throw runtime_error(string("Error: Problem(s) occured while writing the file: '") + tempFileName + string("'; aborting."));
+			}
+		}
+
+#if defined(WIN32) || defined(_WIN32)
+		remove(fileName.c_str());
+#endif
+		if (rename(tempFileName.c_str(), fileName.c_str()) != 0)
+		{
+			throw runtime_error(string("Error: Problem(s) occured while replacing the file: '") + fileName + string("'; aborting."));
+		}
+	}
+
+	// Rewind output:
+	void rewindOutput(
+		const string& inOutputFileName,
+		const Position& inPosition
+		)
+	{
+		streamoff outputSize = -1;
+		{
+			ifstream output(inOutputFileName, ios::binary | ios::ate);
+			if (output.is_open()) outputSize = output.tellg();
+		}
+
+		if ((outputSize < 0) || (static_cast<uint64_t>(outputSize) < inPosition.outputBytes))
+		{
+			throw runtime_error(string("Error: The output file: '") + inOutputFileName + string("' is shorter than its checkpoint records, it does not belong to it; aborting."));
+		}
+		if (static_cast<uint64_t>(outputSize) > inPosition.outputBytes) u::truncateFile(inOutputFileName, inPosition.outputBytes);
+	}
+
+
+	// Checkpointer constructor:
+	Checkpointer::Checkpointer(
+		const string& inFileName,
+		const Position& inStart,
+		const BytesWritten& inBytesWritten,
+		chrono::milliseconds inInterval
+		) : fileName(inFileName), startOutputBytes(inStart.outputBytes), bytesWritten(inBytesWritten), interval(inInterval),
+			handedOff(inStart), written(inStart), stopping(false), saved(inStart)
+	{
+		saveThread = thread(&Checkpointer::saveLoop, this);
+	}
+
+	// Checkpointer destructor:
+	Checkpointer::~Checkpointer()
+	{
+		{
+			lock_guard<mutex> lock(positionMutex);
+			stopping = true;
+		}
+		stopCondition.notify_all();
+
+		if (saveThread.joinable()) saveThread.join();
+	}
+
+	// Add unit:
+	void Checkpointer::add(
+		uint64_t inInputBytes,
+		uint64_t inLines,
+		uint64_t inOutputBytes
+		)
+	{
+		lock_guard<mutex> lock(positionMutex);
+		handedOff.inputBytes += inInputBytes;
+		handedOff.lines += inLines;
+		handedOff.outputBytes += inOutputBytes;
+		pending.push_back(handedOff);
+	}
+
+	// Stop and save final position:
+	void Checkpointer::stop()
+	{
+		{
+			lock_guard<mutex> lock(positionMutex);
+			stopping = true;
+		}
+		stopCondition.notify_all();
+
+		if (saveThread.joinable()) saveThread.join();
+		if (saveError) rethrow_exception(saveError);
+
+		saveCheckpoint(commit(), fileName);
+	}
+
+	// Commit written positions:
+	Position Checkpointer::commit()
+	{
+		// Polled before taking the lock, a unit written after this is simply committed next time:
+		uint64_t outputWritten = bytesWritten();
+
+		lock_guard<mutex> lock(positionMutex);
+		while (!pending.empty() && (pending.front().outputBytes - startOutputBytes <= outputWritten))
+		{
+			written = pending.front();
+			pending.pop_front();
+		}
+		return written;
+	}
+
+	// Saver thread:
+	void Checkpointer::saveLoop()
+	{
+		try
+		{
+			while (true)
+			{
+				{
+					unique_lock<mutex> lock(positionMutex);
+					stopCondition.wait_for(lock, interval, [this] { return stopping; });
+					if (stopping) return;
+				}
+
+				// Only save when something new was written:
+				Position position = commit();
+				if ((position.lines != saved.lines) || (position.inputBytes != saved.inputBytes))
+				{
+					saveCheckpoint(position, fileName);
+					saved = position;
+				}
+			}
+		}
+		catch (...)
+		{
+			// Reported by stop(), the last checkpoint saved stays valid until then:
+			saveError = current_exception();
+		}
+	}
+
+} // namespace checkpoint
@@ -0,0 +1,177 @@
+///////////////////////////////////////
+///
+///	\file		CheckpointLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		CheckpointLib library header
+///
+///	\notes
+///		1. A checkpoint records how far a run got: the input bytes and lines consumed and the output bytes written
+///			when the last fully written result was done. A later run skips that much input, cuts the output back to
+///			that length and carries on, so nothing is factored or written twice.
+///		2. Checkpoints are written to '<file>.tmp' and renamed over '<file>', so a run killed at any point leaves
+///			either the old or the new checkpoint behind, never half of one. The output must have been flushed up
+///			to the recorded length before it is recorded, see async_io::AsyncWriter::getBytesWritten().
+///		3. Checkpointer saves on its own thread. The thread producing output only appends each unit's position
+///			to a queue, the saves (file writes and renames) never hold it up.
+///		4. Positions only make sense with output written in input order, and with the same input file.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef CHECKPOINT_LIB_H
+#define	CHECKPOINT_LIB_H
+
+
+//
+// Local includes:
+//
+//...
+
+
+//
+// Compiler includes:
+//
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace checkpoint
+{
+
+	/// How far a run got.
+	struct Position
+	{
+		uint64_t inputBytes;						///< Input bytes consumed (decompressed bytes for compressed input)
+		uint64_t lines;								///< Input lines consumed
+		uint64_t outputBytes;						///< Output bytes written
+
+		/// Default constructor (start of the input):
+		Position() : inputBytes(0), lines(0), outputBytes(0) {}
+	};
+
+
+	/// True if a checkpoint was saved to fileName (or only its temporary file survived).
+	bool hasCheckpoint(
+		const std::string& fileName					///< File name of the checkpoint
+		);
+
+
+	/// Load a checkpoint saved by saveCheckpoint().
+	Position loadCheckpoint(
+		const std::string& fileName					///< File name of the checkpoint
+		);
+
+
+	/// Save a checkpoint atomically (write a temporary file, then rename it over fileName).
+	void saveCheckpoint(
+		const Position& position,					///< Position to save
+		const std::string& fileName					///< File name of the checkpoint
+		);
+
+
+	/// Cut an output file back to the length recorded in a checkpoint, dropping results written after it was
+	///	saved. Throws if the file is shorter than that, it then does not belong to the checkpoint.
+	void rewindOutput(
+		const std::string& inOutputFileName,		///< Output file of the run that saved the checkpoint
+		const Position& inPosition					///< Position loaded from the checkpoint
+		);
+
+
+	/// RAII saver of periodic checkpoints on a dedicated thread.
+	class Checkpointer
+	{
+	public:
+
+		/// Number of output bytes written and flushed so far by this run.
+		typedef std::function<uint64_t()> BytesWritten;
+
+		/// Default constructor:
+		Checkpointer() = delete;
+
+		/// Custom constructor:
+		Checkpointer(
+			const std::string& inFileName,				///< File name of the checkpoint
+			const Position& inStart,					///< Position this run started from
+			const BytesWritten& inBytesWritten,			///< Output written by this run, polled by the saver thread
+			std::chrono::milliseconds inInterval		///< Time between saves
+			);
+
+		/// Destructor (stops the thread without a final save):
+		~Checkpointer();
+
+		/// No copies, the thread holds a pointer to this object:
+		Checkpointer(const Checkpointer&) = delete;
+		Checkpointer& operator=(const Checkpointer&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Record one more unit handed to the writer, in output order.
+		void add(
+			uint64_t inInputBytes,						///< Input bytes of the unit
+			uint64_t inLines,							///< Input lines of the unit
+			uint64_t inOutputBytes						///< Output bytes of the unit
+			);
+
+		/// Stop the thread and save the position of everything written. Rethrows a failed save.
+		void stop();
+
+	private:
+
+		//
+		// Member variables:
+		//
+		const std::string fileName;
+		const uint64_t startOutputBytes;
+		const BytesWritten bytesWritten;
+		const std::chrono::milliseconds interval;
+
+		std::mutex positionMutex;
+		std::condition_variable stopCondition;
+		Position handedOff;							///< Position after the last unit added
+		std::deque<Position> pending;				///< Positions after each unit whose output may not be written yet
+		Position written;							///< Last position whose output is known to be written
+		bool stopping;
+
+		Position saved;								///< Used by the saver thread only
+		std::exception_ptr saveError;
+		std::thread saveThread;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Move pending positions whose output is written to written, returns written:
+		Position commit();
+
+		/// Saver thread body:
+		void saveLoop();
+
+	};
+
+} // namespace checkpoint
+
+#endif // CHECKPOINT_LIB_H
@@ -0,0 +1,711 @@
+///////////////////////////////////////
+///
+///	\file		CompressedInputLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for CompressedInputLib.h
+///
+///	\notes
+///		1. DecompressingBuffer is the std::streambuf behind compressed files. While the format allows it, complete
+///			members/frames are split off the input into units of about unitSize compressed bytes and decoded by
+///			worker threads, at most two units per worker in flight. As soon as a piece cannot be split off (a
+///			plain gzip member, a very large zstd frame) the rest of the input is decoded in order on the reading
+///			thread, after the units already split off have been handed out.
+///		2. Errors are thrown from underflow(). The stream has badbit in its exception mask so istream rethrows
+///			them to the reader instead of quietly ending the input.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "CompressedInputLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(PRIME_FACTORS_WITH_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(PRIME_FACTORS_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+
+//
+// Namespaces:
+//
+using namespace std;
+using compressed_input::Compression;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	// Compressed bytes read from the file at a time:
+	const size_t readSize = 1 << 20;
+
+	// Decompressed bytes handed out per step when decoding in order:
+	const size_t streamChunkSize = 1 << 18;
+
+	// Compressed bytes gathered into one unit for a worker, and the largest frame split off on its own:
+	const size_t unitSize = 1 << 20;
+	const size_t maxPieceSize = 8 << 20;
+
+	// Probe results besides a size:
+	const size_t needMoreInput = 0;
+	const size_t notSplittable = numeric_limits<size_t>::max();
+
+
+	// Name of a format for messages:
+	const char* compressionName(
+		Compression inCompression
+		)
+	{
+		switch (inCompression)
+		{
+		case Compression::gzip: return "gzip";
+		case Compression::zstd: return "zstd";
+		default: return "plain";
+		}
+	}
+
+	// Error for data that does not decode:
+	runtime_error corruptDataError(
+		Compression inCompression,
+		const string& inDetail
+		)
+	{
+		return runtime_error(string("Error: The input is not valid ") + compressionName(inCompression) + string(" data (") + inDetail + string("); aborting."));
+	}
+
+
+	// Incremental decoder of one format, state is kept between calls so input can arrive in any pieces:
+	class Decoder
+	{
+	public:
+
+		explicit Decoder(
+			Compression inCompression
+			);
+
+		~Decoder();
+
+		Decoder(const Decoder&) = delete;
+		Decoder& operator=(const Decoder&) = delete;
+
+		// Decode from ioInput up to inEnd, appending at most inMaxOutput bytes to ioOutput. ioInput is advanced past
+		//	the input used. Returns when the output is full or the decoder needs more input:
+		void decode(
+			const char*& ioInput,
+			const char* inEnd,
+			string& ioOutput,
+			size_t inMaxOutput
+			);
+
+		// True between members/frames, false inside one (input ending here was cut short):
+		bool atBoundary() const { return boundary; }
+
+	private:
+
+		const Compression compression;
+		bool boundary;
+
+#if defined(PRIME_FACTORS_WITH_ZLIB)
+		z_stream zlibStream;
+#endif
+
+#if defined(PRIME_FACTORS_WITH_ZSTD)
+		ZSTD_DStream* zstdStream;
+#endif
+
+	};
+
+	// Decoder constructor:
+	Decoder::Decoder(
+		Compression inCompression
+		) : compression(inCompression), boundary(true)
+	{
+		if (!compressed_input::isSupported(compression))
+		{
+			throw runtime_error(string("Error: This build cannot decompress ") + compressionName(compression) + string(" data; aborting."));
+		}
+
+#if defined(PRIME_FACTORS_WITH_ZLIB)
+		// 16 + 15: gzip wrapper, largest window:
+		memset(&zlibStream, 0, sizeof(zlibStream));
+		if ((compression == Compression::gzip) && (inflateInit2(&zlibStream, 16 + 15) != Z_OK))
+		{
+			throw runtime_error("Error: Could not set up gzip decompression; aborting.");
+		}
+#endif
+
+#if defined(PRIME_FACTORS_WITH_ZSTD)
+		zstdStream = nullptr;
+		if ((compression == Compression::zstd) && ((zstdStream = ZSTD_createDStream()) == nullptr))
+		{
+			throw runtime_error("Error: Could not set up zstd decompression; aborting.");
+		}
+#endif
+	}
+
+	// Decoder destructor:
+	Decoder::~Decoder()
+	{
+#if defined(PRIME_FACTORS_WITH_ZLIB)
+		if (compression == Compression::gzip) inflateEnd(&zlibStream);
+#endif
+
+#if defined(PRIME_FACTORS_WITH_ZSTD)
+		if (zstdStream != nullptr) ZSTD_freeDStream(zstdStream);
+#endif
+	}
+
+	// Decode:
+	void Decoder::decode(
+		const char*& ioInput,
+		const char* inEnd,
+		string& ioOutput,
+		size_t inMaxOutput
+		)
+	{
+		// Output goes straight into ioOutput, grown a step at a time and trimmed to what was written:
+		size_t written = 0;
+		while (written < inMaxOutput)
+		{
+			size_t step = min(inMaxOutput - written, streamChunkSize);
+			size_t oldSize = ioOutput.size();
+			ioOutput.resize(oldSize + step);
+			char* output = &ioOutput[oldSize];
+			size_t consumed = 0, produced = 0;
+
+			if (compression == Compression::none)
+			{
+				consumed = produced = min(step, static_cast<size_t>(inEnd - ioInput));
+				if (produced > 0) memcpy(output, ioInput, produced);
+			}
+#if defined(PRIME_FACTORS_WITH_ZLIB)
+			else if (compression == Compression::gzip)
+			{
+				zlibStream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(ioInput));
+				zlibStream.avail_in = static_cast<uInt>(min(static_cast<size_t>(inEnd - ioInput), static_cast<size_t>(UINT_MAX)));
+				zlibStream.next_out = reinterpret_cast<Bytef*>(output);
+				zlibStream.avail_out = static_cast<uInt>(step);
+
+				// Z_BUF_ERROR only means no progress was possible, i.e. no input left:
+				int result = inflate(&zlibStream, Z_NO_FLUSH);
+				if ((result != Z_OK) && (result != Z_STREAM_END) && (result != Z_BUF_ERROR))
+				{
+					throw corruptDataError(compression, (zlibStream.msg != nullptr) ? zlibStream.msg : "inflate failed");
+				}
+				consumed = reinterpret_cast<const char*>(zlibStream.next_in) - ioInput;
+				produced = step - zlibStream.avail_out;
+
+				// Concatenated members (BGZF, pigz, cat a.gz b.gz) continue with a fresh header:
+				if (result == Z_STREAM_END)
+				{
+					inflateReset(&zlibStream);
+					boundary = true;
+				}
+				else if (result == Z_OK)
+				{
+					boundary = false;
+				}
+			}
+#endif
+#if defined(PRIME_FACTORS_WITH_ZSTD)
+			else if (compression == Compression::zstd)
+			{
+				ZSTD_inBuffer inBuffer = { ioInput, static_cast<size_t>(inEnd - ioInput), 0 };
+				ZSTD_outBuffer outBuffer = { output, step, 0 };
+
+				// 0 means a frame was completely decoded and flushed, later frames just continue. A call without
+				//	progress (no input left) only asks for the next frame header and leaves the boundary as it was:
+				size_t result = ZSTD_decompressStream(zstdStream, &outBuffer, &inBuffer);
+				if (ZSTD_isError(result)) throw corruptDataError(compression, ZSTD_getErrorName(result));
+				consumed = inBuffer.pos;
+				produced = outBuffer.pos;
+				if ((consumed > 0) || (produced > 0)) boundary = (result == 0);
+			}
+#endif
+
+			ioOutput.resize(oldSize + produced);
+			ioInput += consumed;
+			written += produced;
+
+			// Stop once the decoder is starved, it wrote less than it could and has no input left:
+			if ((produced < step) && (ioInput == inEnd)) break;
+			if ((produced == 0) && (consumed == 0)) break;
+		}
+	}
+
+
+	// Size of the BGZF member at inData, from the BSIZE subfield of its gzip header:
+	size_t probeBgzf(
+		const unsigned char* inData,
+		size_t inSize
+		)
+	{
+		if (inSize < 12) return needMoreInput;
+		if ((inData[0] != 0x1f) || (inData[1] != 0x8b) || (inData[2] != 8) || ((inData[3] & 4) == 0)) return notSplittable;
+
+		size_t extraEnd = 12 + (inData[10] | (inData[11] << 8));
+		if (inSize < extraEnd) return needMoreInput;
+
+		for (size_t field = 12; field + 4 <= extraEnd; field += 4 + (inData[field + 2] | (inData[field + 3] << 8)))
+		{
+			bool isBlockSize = (inData[field] == 'B') && (inData[field + 1] == 'C') && (inData[field + 2] == 2) && (inData[field + 3] == 0);
+			if (isBlockSize && (field + 6 <= extraEnd)) return (inData[field + 4] | (inData[field + 5] << 8)) + 1;
+		}
+		return notSplittable;
+	}
+
+	// Size of the next member or frame at inData, needMoreInput if it is not all there yet:
+	size_t probePiece(
+		Compression inCompression,
+		const char* inData,
+		size_t inSize
+		)
+	{
+		if (inCompression == Compression::gzip) return probeBgzf(reinterpret_cast<const unsigned char*>(inData), inSize);
+
+#if defined(PRIME_FACTORS_WITH_ZSTD)
+		// Walks the block headers, so it fails until the whole frame is there (or forever on bad data):
+		if (inCompression == Compression::zstd)
+		{
+			size_t frameSize = ZSTD_findFrameCompressedSize(inData, inSize);
+			return ZSTD_isError(frameSize) ? needMoreInput : frameSize;
+		}
+#endif
+
+		return notSplittable;
+	}
+
+
+	// Stream buffer that decompresses a source stream:
+	class DecompressingBuffer : public streambuf
+	{
+	public:
+
+		DecompressingBuffer(
+			istream& inSource,
+			Compression inCompression,
+			string&& inPrefix,
+			unsigned inThreadCount,
+			const string& inFileName
+			);
+
+		~DecompressingBuffer();
+
+		DecompressingBuffer(const DecompressingBuffer&) = delete;
+		DecompressingBuffer& operator=(const DecompressingBuffer&) = delete;
+
+	protected:
+
+		int_type underflow() override;
+
+	private:
+
+		// Complete members/frames decoded by a worker:
+		struct Unit
+		{
+			string compressed;
+			string output;
+			bool done;
+			exception_ptr error;
+
+			Unit() : done(false) {}
+		};
+
+		istream& source;
+		const Compression compression;
+		const string fileName;
+		string input;								// Compressed bytes, input[inputStart..] is not used yet
+		size_t inputStart;
+		bool sourceExhausted;
+
+		// Used by the reading thread only:
+		const unsigned threadCount;
+		bool splitting;								// Units are still split off the input
+		deque<shared_ptr<Unit>> units;				// Units in input order
+		bool frontTaken;							// get area points into units.front()
+		Decoder decoder;							// Decodes in order once splitting is over
+		string output;
+
+		// Shared with the workers:
+		mutex unitMutex;
+		condition_variable workCondition;
+		condition_variable doneCondition;
+		deque<shared_ptr<Unit>> pendingUnits;
+		bool stopping;
+		vector<thread> workers;
+
+		bool readMore();
+		size_t nextPieceSize();
+		bool splitUnit(
+			string& outCompressed
+			);
+		void fillUnits();
+		void workerLoop();
+
+	};
+
+	// DecompressingBuffer constructor:
+	DecompressingBuffer::DecompressingBuffer(
+		istream& inSource,
+		Compression inCompression,
+		string&& inPrefix,
+		unsigned inThreadCount,
+		const string& inFileName
+		) : source(inSource), compression(inCompression), fileName(inFileName), input(move(inPrefix)), inputStart(0), sourceExhausted(false),
+			threadCount(inThreadCount), splitting((inThreadCount > 1) && (inCompression != Compression::none)), frontTaken(false),
+			decoder(inCompression), stopping(false)
+	{
+	}
+
+	// DecompressingBuffer destructor:
+	DecompressingBuffer::~DecompressingBuffer()
+	{
+		{
+			lock_guard<mutex> lock(unitMutex);
+			stopping = true;
+		}
+		workCondition.notify_all();
+
+		for (auto& worker : workers) worker.join();
+	}
+
+	// Read more compressed input, false at the end of the file:
+	bool DecompressingBuffer::readMore()
+	{
+		if (sourceExhausted) return false;
+
+		// Drop what was used before growing:
+		input.erase(0, inputStart);
+		inputStart = 0;
+
+		size_t oldSize = input.size();
+		input.resize(oldSize + readSize);
+		source.read(&input[oldSize], readSize);
+		size_t readCount = static_cast<size_t>(source.gcount());
+		input.resize(oldSize + readCount);
+
+		if (!source)
+		{
+			if (source.bad())
+			{
+				throw runtime_error(string("Error: Problem(s) occured while trying to read the file: '") + fileName + string("'; aborting."));
+			}
+			sourceExhausted = true;
+		}
+		return readCount > 0;
+	}
+
+	// Size of the next piece that can be split off, 0 at the end of the input:
+	size_t DecompressingBuffer::nextPieceSize()
+	{
+		while (true)
+		{
+			size_t available = input.size() - inputStart;
+			size_t size = (available > 0) ? probePiece(compression, input.data() + inputStart, available) : needMoreInput;
+			if ((size == notSplittable) || (size > maxPieceSize)) return notSplittable;
+
+			if (size != needMoreInput)
+			{
+				// BGZF sizes come from the header, the rest of the member may still be on disk:
+				while (input.size() - inputStart < size)
+				{
+					if (!readMore()) return notSplittable;
+				}
+				return size;
+			}
+
+			// Truncated or bad data is left to the in-order decoder, which reports it:
+			if (available >= maxPieceSize) return notSplittable;
+			if (!readMore()) return (available == 0) ? 0 : notSplittable;
+		}
+	}
+
+	// Split the next unit off the input, splitting stops at the first piece that cannot be split off:
+	bool DecompressingBuffer::splitUnit(
+		string& outCompressed
+		)
+	{
+		while (outCompressed.size() < unitSize)
+		{
+			size_t size = nextPieceSize();
+			if ((size == 0) || (size == notSplittable))
+			{
+				splitting = false;
+				break;
+			}
+
+			outCompressed.append(input, inputStart, size);
+			inputStart += size;
+		}
+		return !outCompressed.empty();
+	}
+
+	// Keep the workers supplied:
+	void DecompressingBuffer::fillUnits()
+	{
+		while (splitting && (units.size() < 2 * threadCount))
+		{
+			shared_ptr<Unit> unit = make_shared<Unit>();
+			if (!splitUnit(unit->compressed)) break;
+
+			// Workers start with the first unit, plain gzip files never need them:
+			if (workers.empty())
+			{
+				for (unsigned worker = 0; worker < threadCount; ++worker) workers.emplace_back(&DecompressingBuffer::workerLoop, this);
+			}
+
+			units.push_back(unit);
+			{
+				lock_guard<mutex> lock(unitMutex);
+				pendingUnits.push_back(unit);
+			}
+			workCondition.notify_one();
+		}
+	}
+
+	// Worker thread:
+	void DecompressingBuffer::workerLoop()
+	{
+		while (true)
+		{
+			shared_ptr<Unit> unit;
+			{
+				unique_lock<mutex> lock(unitMutex);
+				workCondition.wait(lock, [this] { return stopping || !pendingUnits.empty(); });
+				if (stopping) return;
+
+				unit = pendingUnits.front();
+				pendingUnits.pop_front();
+			}
+
+			try
+			{
+				Decoder unitDecoder(compression);
+				const char* next = unit->compressed.data();
+				const char* end = next + unit->compressed.size();
+				unitDecoder.decode(next, end, unit->output, numeric_limits<size_t>::max());
+				if ((next != end) || !unitDecoder.atBoundary()) throw corruptDataError(compression, "member cut short");
+			}
+			catch (...)
+			{
+				unit->error = current_exception();
+			}
+			string().swap(unit->compressed);
+
+			{
+				lock_guard<mutex> lock(unitMutex);
+				unit->done = true;
+			}
+			doneCondition.notify_all();
+		}
+	}
+
+	// Refill get area:
+	DecompressingBuffer::int_type DecompressingBuffer::underflow()
+	{
+		if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+		// The unit just read is done with:
+		if (frontTaken)
+		{
+			units.pop_front();
+			frontTaken = false;
+		}
+
+		// Units split off earlier come first:
+		fillUnits();
+		while (!units.empty())
+		{
+			shared_ptr<Unit> front = units.front();
+			{
+				unique_lock<mutex> lock(unitMutex);
+				doneCondition.wait(lock, [&front] { return front->done; });
+			}
+			if (front->error) rethrow_exception(front->error);
+
+			if (!front->output.empty())
+			{
+				frontTaken = true;
+				char* begin = &front->output[0];
+				setg(begin, begin, begin + front->output.size());
+				return traits_type::to_int_type(*gptr());
+			}
+
+			units.pop_front();
+			fillUnits();
+		}
+
+		// Then the rest of the input in order:
+		output.clear();
+		while (true)
+		{
+			const char* begin = input.data() + inputStart;
+			const char* next = begin;
+			decoder.decode(next, input.data() + input.size(), output, streamChunkSize);
+			inputStart += next - begin;
+			if (!output.empty()) break;
+
+			if (!readMore())
+			{
+				if (!decoder.atBoundary()) throw corruptDataError(compression, "file cut short");
+				return traits_type::eof();
+			}
+		}
+
+		setg(&output[0], &output[0], &output[0] + output.size());
+		return traits_type::to_int_type(*gptr());
+	}
+
+} // namespace
+
+
+//
+// Main library namespace:
+//
+namespace compressed_input
+{
+
+	// Detect compression:
+	Compression detectCompression(
+		const char* inMagic,
+		size_t inSize
+		)
+	{
+		const unsigned char* magic = reinterpret_cast<const unsigned char*>(inMagic);
+
+		if ((inSize >= 2) && (magic[0] == 0x1f) && (magic[1] == 0x8b)) return Compression::gzip;
+		if (inSize < 4) return Compression::none;
+
+		// zstd frames, or skippable frames (0x184D2A50 to 0x184D2A5F) such as the size headers pzstd writes:
+		if ((magic[0] == 0x28) && (magic[1] == 0xb5) && (magic[2] == 0x2f) && (magic[3] == 0xfd)) return Compression::zstd;
+		if (((magic[0] & 0xf0) == 0x50) && (magic[1] == 0x2a) && (magic[2] == 0x4d) && (magic[3] == 0x18)) return Compression::zstd;
+
+		return Compression::none;
+	}
+
+	// Is supported:
+	bool isSupported(
+		Compression inCompression
+		)
+	{
+		switch (inCompression)
+		{
+		case Compression::none: return true;
+#if defined(PRIME_FACTORS_WITH_ZLIB)
+		case Compression::gzip: return true;
+#endif
+#if defined(PRIME_FACTORS_WITH_ZSTD)
+		case Compression::zstd: return true;
+#endif
+		default: return false;
+		}
+	}
+
+
+	// InputFile constructor:
+	InputFile::InputFile(
+		const string& inFileName,
+		unsigned inDecompressThreads
+		) : fileName(inFileName), compression(Compression::none), fileSize(0), stream(nullptr)
+	{
+		// Open file in binary mode to look at its first bytes:
+		file.open(fileName, ios::binary);
+
+		// Check is file was opened incorrectly:
+		if (!file.is_open())
+		{
+			throw runtime_error(string("Error: Problem(s) occured while trying to open the file: '") + fileName + string("'; aborting."));
+		}
+
+		char magic[4];
+		file.read(magic, sizeof(magic));
+		string prefix(magic, static_cast<size_t>(file.gcount()));
+		compression = detectCompression(prefix.data(), prefix.size());
+		file.clear();
+
+		if (compression == Compression::none)
+		{
+			// Plain files are reopened in text mode, only pipes (which cannot seek) replay the bytes already read:
+			file.seekg(0, ios::end);
+			streamoff endOffset = file.tellg();
+			if (endOffset >= 0)
+			{
+				fileSize = static_cast<uint64_t>(endOffset);
+				file.close();
+				file.open(fileName);
+				if (!file.is_open())
+				{
+					throw runtime_error(string("Error: Problem(s) occured while trying to open the file: '") + fileName + string("'; aborting."));
+				}
+				stream.rdbuf(file.rdbuf());
+				return;
+			}
+			file.clear();
+		}
+		else if (!isSupported(compression))
+		{
+			throw runtime_error(string("Error: The file: '") + fileName + string("' is ") + compressionName(compression) +
+								string(" compressed but this build has no ") + compressionName(compression) + string(" support; aborting."));
+		}
+
+		decompressingBuffer.reset(new DecompressingBuffer(file, compression, move(prefix), inDecompressThreads, fileName));
+		stream.rdbuf(decompressingBuffer.get());
+		stream.exceptions(ios::badbit);
+	}
+
+	// Skip:
+	void InputFile::skip(
+		uint64_t inBytes
+		)
+	{
+#if !defined(WIN32) && !defined(_WIN32)
+		// Plain files read the same bytes in text mode here, so content offsets are file offsets:
+		if (!decompressingBuffer)
+		{
+			stream.seekg(static_cast<streamoff>(min(inBytes, fileSize)), ios::beg);
+			return;
+		}
+#endif
+
+		// Line endings may be translated (Windows) or there is nothing to seek in:
+		const uint64_t maxStep = 1 << 30;
+		while ((inBytes > 0) && stream)
+		{
+			uint64_t step = min(inBytes, maxStep);
+			stream.ignore(static_cast<streamsize>(step));
+			inBytes -= step;
+		}
+	}
+
+	// InputFile destructor:
+	InputFile::~InputFile()
+	{
+		// Members go in reverse order: stream, then the buffer reading from file, then file.
+	}
+
+} // namespace compressed_input
@@ -0,0 +1,139 @@
+///////////////////////////////////////
+///
+///	\file		CompressedInputLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		CompressedInputLib library header
+///
+///	\notes
+///		1. Input files may be gzip or zstd compressed. The format is detected from the first bytes of the file and
+///			the data is decompressed on the fly behind a std::istream, so compressed archives are read directly
+///			instead of being unpacked to a temporary file first.
+///		2. Formats whose independent pieces can be found without decompressing are decompressed in parallel:
+///			- gzip written in blocks with their sizes in the header (BGZF, as written by bgzip).
+///			- zstd, whose frame sizes can always be read from the block headers.
+///			The pieces are handed to worker threads and read back in file order. A plain gzip stream can only be
+///			decompressed from start to end and is decompressed on the thread reading from the stream.
+///		3. Each format is only available when the build found its library (zlib: PRIME_FACTORS_WITH_ZLIB, zstd:
+///			PRIME_FACTORS_WITH_ZSTD). Opening a file in a format this build lacks throws.
+///		4. Plain files are read like before, in text mode through std::ifstream.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef COMPRESSED_INPUT_LIB_H
+#define	COMPRESSED_INPUT_LIB_H
+
+
+//
+// Local includes:
+//
+//...
+
+
+//
+// Compiler includes:
+//
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace compressed_input
+{
+
+	/// Compression formats of input files.
+	enum class Compression
+	{
+		none,										///< Plain text
+		gzip,										///< gzip, including BGZF
+		zstd										///< zstd, including skippable frames
+	};
+
+
+	/// Detect the compression of a file from its first bytes (4 are enough, fewer only ever give none).
+	Compression detectCompression(
+		const char* inMagic,						///< First bytes of the file
+		std::size_t inSize							///< Number of bytes in inMagic
+		);
+
+
+	/// True if this build can decompress inCompression.
+	bool isSupported(
+		Compression inCompression					///< Format to check
+		);
+
+
+	/// RAII input file that decompresses gzip and zstd files transparently.
+	class InputFile
+	{
+	public:
+
+		/// Default constructor:
+		InputFile() = delete;
+
+		/// Custom constructor:
+		explicit InputFile(
+			const std::string& inFileName,				///< File name of file to open
+			unsigned inDecompressThreads = 1			///< Worker threads for formats that decompress in parallel
+			);
+
+		/// Destructor:
+		~InputFile();
+
+		/// No copies, the stream points into this object:
+		InputFile(const InputFile&) = delete;
+		InputFile& operator=(const InputFile&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Get the decompressed contents of the file.
+		std::istream& getStream() { return stream; }
+
+		/// Get compression format of the file.
+		Compression getCompression() const { return compression; }
+
+		/// Get size of a plain file in bytes, 0 when it is compressed or its size is unknown (pipes).
+		uint64_t getFileSize() const { return fileSize; }
+
+		/// Skip the first inBytes bytes of the contents, as counted through getStream(). Seeks where it can,
+		///	compressed files and pipes are read past. Skipping past the end leaves nothing to read.
+		void skip(
+			uint64_t inBytes							///< Bytes to skip
+			);
+
+	private:
+
+		//
+		// Member variables:
+		//
+		std::ifstream file;
+		const std::string fileName;
+		Compression compression;
+		uint64_t fileSize;
+		std::unique_ptr<std::streambuf> decompressingBuffer;	///< Set for compressed files (and plain pipes)
+		std::istream stream;
+
+	};
+
+} // namespace compressed_input
+
+#endif // COMPRESSED_INPUT_LIB_H
@@ -0,0 +1,161 @@
+///////////////////////////////////////
+///
+///	\file		DedupeLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for DedupeLib.h
+///
+///	\notes
+///		1. Entry sizes are estimates (key, result, factor storage and container overhead), good enough to keep
+///			the table within the same order of magnitude as the requested cap.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "DedupeLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <utility>
+
+
+//
+// Namespaces:
+//
+using namespace std;
+
+
+//
+// Main library namespace:
+//
+namespace dedupe
+{
+
+	// DedupeTable constructor:
+	DedupeTable::DedupeTable(
+		size_t inMaxBytes,
+		size_t inShardCount
+		) : shardMaxBytes(inMaxBytes / (inShardCount > 0 ? inShardCount : 1))
+	{
+		for (size_t i = 0; i < (inShardCount > 0 ? inShardCount : 1); ++i)
+		{
+			unique_ptr<Shard> shard(new Shard());
+			shard->bytesUsed = 0;
+			shard->hits = 0;
+			shard->misses = 0;
+			shards.push_back(move(shard));
+		}
+	}
+
+	// Find stored result:
+	bool DedupeTable::find(
+		uint64_t number,
+		utils::FactorResult& result
+		)
+	{
+		Shard& shard = shardFor(number);
+		lock_guard<mutex> lock(shard.shardMutex);
+
+		auto entry = shard.entries.find(number);
+		if (entry == shard.entries.end())
+		{
+			++shard.misses;
+			return false;
+		}
+
+		++shard.hits;
+		result = entry->second;
+		return true;
+	}
+
+	// Store result:
+	void DedupeTable::insert(
+		uint64_t number,
+		const utils::FactorResult& result
+		)
+	{
+		size_t newBytes = entryBytes(result);
+		if (newBytes > shardMaxBytes) return;
+
+		Shard& shard = shardFor(number);
+		lock_guard<mutex> lock(shard.shardMutex);
+		if (shard.entries.count(number) != 0) return;
+
+		// Make room by dropping the oldest entries:
+		while ((shard.bytesUsed + newBytes > shardMaxBytes) && !shard.insertionOrder.empty())
+		{
+			auto oldest = shard.entries.find(shard.insertionOrder.front());
+			shard.bytesUsed -= entryBytes(oldest->second);
+			shard.entries.erase(oldest);
+			shard.insertionOrder.pop_front();
+		}
+
+		shard.entries.insert(make_pair(number, result));
+		shard.insertionOrder.push_back(number);
+		shard.bytesUsed += newBytes;
+	}
+
+	// Get bytes used:
+	size_t DedupeTable::getBytesUsed() const
+	{
+		size_t bytesUsed = 0;
+		for (auto& shard : shards)
+		{
+			lock_guard<mutex> lock(shard->shardMutex);
+			bytesUsed += shard->bytesUsed;
+		}
+		return bytesUsed;
+	}
+
+	// Get hits:
+	uint64_t DedupeTable::getHits() const
+	{
+		uint64_t hits = 0;
+		for (auto& shard : shards)
+		{
+			lock_guard<mutex> lock(shard->shardMutex);
+			hits += shard->hits;
+		}
+		return hits;
+	}
+
+	// Get misses:
+	uint64_t DedupeTable::getMisses() const
+	{
+		uint64_t misses = 0;
+		for (auto& shard : shards)
+		{
+			lock_guard<mutex> lock(shard->shardMutex);
+			misses += shard->misses;
+		}
+		return misses;
+	}
+
+	// Shard for number:
+	//	Note: Same splitmix64 mix as factor_cache::FactorCache, so runs of nearby numbers spread over all shards.
+	DedupeTable::Shard& DedupeTable::shardFor(
+		uint64_t number
+		)
+	{
+		uint64_t h = number;
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+		h = h ^ (h >> 31);
+		return *shards[h % shards.size()];
+	}
+
+	// Estimate entry size:
+	size_t DedupeTable::entryBytes(
+		const utils::FactorResult& result
+		)
+	{
+		// The result is the map's value, the number also sits in the eviction queue:
+		return utils::factorEntryBytes(result, sizeof(utils::FactorResult) + sizeof(uint64_t));
+	}
+
+} // namespace dedupe
@@ -0,0 +1,139 @@
+///////////////////////////////////////
+///
+///	\file		DedupeLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		DedupeLib library header
+///
+///	\notes
+///		1. Remembers the factorization of recently seen numbers so repeated inputs in one run are only factored
+///			once. Memory is capped; once the cap is reached the oldest entries are dropped first (FIFO), which
+///			keeps the bookkeeping to one hash lookup per number.
+///		2. One table is shared by all worker threads, so a number seen by any worker is not factored again by
+///			another. It is split into shards by a hash of the number, each with its own lock and its own share of
+///			the cap, so workers rarely wait on each other. Two workers that miss the same number at the same moment
+///			may both factor it; the second insert() is then ignored.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef DEDUPE_LIB_H
+#define	DEDUPE_LIB_H
+
+
+//
+// Local includes:
+//
+#include "UtilsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace dedupe
+{
+
+	/// Bounded, thread-safe map from number to factorization for one run.
+	class DedupeTable
+	{
+	public:
+
+		/// Default constructor:
+		DedupeTable() = delete;
+
+		/// Custom constructor:
+		explicit DedupeTable(
+			std::size_t inMaxBytes,						///< Approximate memory cap over all shards, 0 disables the table
+			std::size_t inShardCount = 1				///< Number of independently locked shards
+			);
+
+		/// No copies, shards own mutexes:
+		DedupeTable(const DedupeTable&) = delete;
+		DedupeTable& operator=(const DedupeTable&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Copy the result stored for inNumber into outResult. Returns false if there is none.
+		bool find(
+			uint64_t inNumber,							///< Number to look up
+			utils::FactorResult& outResult				///< Stored result if found
+			);
+
+		/// Store the result for inNumber, dropping the oldest entries if needed to stay under the cap.
+		void insert(
+			uint64_t inNumber,							///< Number that was factored
+			const utils::FactorResult& inResult			///< Its factorization
+			);
+
+		/// Get approximate memory in use, summed over all shards.
+		std::size_t getBytesUsed() const;
+
+		/// Get number of find() calls that returned a result.
+		uint64_t getHits() const;
+
+		/// Get number of find() calls that did not.
+		uint64_t getMisses() const;
+
+	private:
+
+		/// One independently locked part of the table:
+		struct Shard
+		{
+			mutable std::mutex shardMutex;
+			std::size_t bytesUsed;
+			uint64_t hits;
+			uint64_t misses;
+			std::unordered_map<uint64_t, utils::FactorResult> entries;
+			std::deque<uint64_t> insertionOrder;	///< Oldest first, for eviction
+		};
+
+		//
+		// Member variables:
+		//
+		const std::size_t shardMaxBytes;
+		std::vector<std::unique_ptr<Shard>> shards;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Shard owning inNumber.
+		Shard& shardFor(
+			uint64_t inNumber							///< Number to place
+			);
+
+		/// Approximate memory used by one entry.
+		static std::size_t entryBytes(
+			const utils::FactorResult& inResult			///< Entry to measure
+			);
+
+	};
+
+} // namespace dedupe
+
+#endif // DEDUPE_LIB_H
@@ -0,0 +1,522 @@
+///////////////////////////////////////
+///
+///	\file		FactorAlgorithmsLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for FactorAlgorithmsLib.h
+///
+///	\notes
+///		1. Trial division modified from: http://www.geeksforgeeks.org/print-all-prime-factors-of-a-given-number/
+///		2. Miller-Rabin bases {2, 325, 9375, 28178, 450775, 9780504, 1795265022} are deterministic for all
+///			n < 2^64 (Jim Sinclair, 2011).
+///		3. Pollard-Brent rho follows R. P. Brent, "An improved Monte Carlo factorization algorithm" (1980),
+///			batching the gcd over many steps and backtracking when the batch overshoots.
+///		4. Below 2^32 Miller-Rabin only needs the bases {2, 7, 61} (Jaeschke, 1993).
+///		5. Templates are defined here and explicitly instantiated for uint32_t and uint64_t, and for both counter
+///			policies, at the end of the file.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "FactorAlgorithmsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+
+//
+// Namespaces:
+//
+using namespace std;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	// Full 32x32 -> 64-bit product, returns the low half and stores the high half in outHigh:
+	inline uint32_t multiplyWide(
+		uint32_t a,
+		uint32_t b,
+		uint32_t& outHigh
+		)
+	{
+		uint64_t product = uint64_t(a) * b;
+		outHigh = static_cast<uint32_t>(product >> 32);
+		return static_cast<uint32_t>(product);
+	}
+
+	// Full 64x64 -> 128-bit product, returns the low half and stores the high half in outHigh:
+	inline uint64_t multiplyWide(
+		uint64_t a,
+		uint64_t b,
+		uint64_t& outHigh
+		)
+	{
+#if defined(__SIZEOF_INT128__)
+		unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+		outHigh = static_cast<uint64_t>(product >> 64);
+		return static_cast<uint64_t>(product);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		return _umul128(a, b, &outHigh);
+#else
+		// Schoolbook multiplication on 32-bit halves:
+		uint64_t aLo = a & 0xffffffff, aHi = a >> 32;
+		uint64_t bLo = b & 0xffffffff, bHi = b >> 32;
+		uint64_t loLo = aLo * bLo, hiLo = aHi * bLo, loHi = aLo * bHi, hiHi = aHi * bHi;
+		uint64_t cross = (loLo >> 32) + (hiLo & 0xffffffff) + loHi;
+		outHigh = hiHi + (hiLo >> 32) + (cross >> 32);
+		return (cross << 32) | (loLo & 0xffffffff);
+#endif
+	}
+
+	// Binary gcd at any width:
+	template <typename Word>
+	Word binaryGcd(
+		Word a,
+		Word b
+		)
+	{
+		if (a == 0) return b;
+		if (b == 0) return a;
+
+		uint32_t shift = 0;
+		while (((a | b) & 1) == 0)
+		{
+			a >>= 1;
+			b >>= 1;
+			++shift;
+		}
+		while ((a & 1) == 0) a >>= 1;
+		do
+		{
+			while ((b & 1) == 0) b >>= 1;
+			if (a > b) std::swap(a, b);
+			b -= a;
+		} while (b != 0);
+
+		return a << shift;
+	}
+
+	// Miller-Rabin on an odd n > 37^2 with the given bases:
+	template <typename Word, typename Counters, size_t baseCount>
+	bool millerRabin(
+		Word n,
+		const uint32_t (&bases)[baseCount],
+		Counters& counters
+		)
+	{
+		// Write n - 1 = d * 2^s with d odd:
+		Word d = n - 1;
+		uint32_t s = 0;
+		while ((d & 1) == 0)
+		{
+			d >>= 1;
+			++s;
+		}
+
+		factor_algorithms::Montgomery<Word> mont(n);
+		const Word one = mont.one();
+		const Word minusOne = mont.toMontgomery(n - 1);
+
+		for (auto base : bases)
+		{
+			Word a = static_cast<Word>(base % n);
+			if (a == 0) continue;
+			counters.countMillerRabinRounds(1);
+
+			Word x = mont.power(mont.toMontgomery(a), d);
+			if ((x == one) || (x == minusOne)) continue;
+
+			bool witness = true;
+			for (uint32_t r = 1; r < s; ++r)
+			{
+				x = mont.multiply(x, x);
+				if (x == minusOne)
+				{
+					witness = false;
+					break;
+				}
+			}
+			if (witness) return false;
+		}
+
+		return true;
+	}
+
+	// Trial-division loop at any width (see factor_algorithms::trialDivide):
+	template <typename Word, typename Counters>
+	bool trialDivideKernel(
+		Word& number,
+		Word& candidate,
+		Word bound,
+		std::vector<uint64_t>& factors,
+		factor_algorithms::BudgetTracker& tracker,
+		Counters& counters
+		)
+	{
+		for (; (candidate <= bound) && (candidate <= number / candidate); candidate += 2)
+		{
+			if (!tracker.spend()) return false;
+			counters.countTrialDivisions(1);
+
+			while ((number % candidate) == 0)
+			{
+				factors.push_back(candidate);
+				number /= candidate;
+			}
+		}
+
+		return true;
+	}
+
+	// Pollard-Brent rho at any width (see factor_algorithms::pollardRho):
+	template <typename Word, typename Counters>
+	Word pollardRhoKernel(
+		Word n,
+		factor_algorithms::BudgetTracker& tracker,
+		Counters& counters
+		)
+	{
+		const Word batchSize = 128;
+		factor_algorithms::Montgomery<Word> mont(n);
+
+		// Each c gives a different pseudo-random walk x -> x^2 + c; a walk fails only when it finds n itself:
+		for (Word c = 1; c < n; ++c)
+		{
+			const Word cMont = mont.toMontgomery(c);
+			Word y = mont.toMontgomery(2);
+			Word x = y, saved = y;
+			Word q = mont.one();
+			Word factor = 1;
+
+			for (Word r = 1; factor == 1; r <<= 1)
+			{
+				x = y;
+				for (Word i = 0; i < r; ++i) y = mont.add(mont.multiply(y, y), cMont);
+
+				for (Word k = 0; (k < r) && (factor == 1); k += batchSize)
+				{
+					Word steps = (r - k < batchSize) ? r - k : batchSize;
+					if (!tracker.spend(steps)) return 0;
+					counters.countRhoSteps(steps);
+
+					// Accumulate |x - y| products so one gcd covers the whole batch:
+					saved = y;
+					for (Word i = 0; i < steps; ++i)
+					{
+						y = mont.add(mont.multiply(y, y), cMont);
+						q = mont.multiply(q, (x > y) ? x - y : y - x);
+					}
+					factor = binaryGcd(q, n);
+					counters.countGcds(1);
+				}
+			}
+
+			// The batch overshot (q hit 0 mod n), redo it one step at a time:
+			if (factor == n)
+			{
+				do
+				{
+					if (!tracker.spend()) return 0;
+					counters.countRhoSteps(1);
+					saved = mont.add(mont.multiply(saved, saved), cMont);
+					factor = binaryGcd((x > saved) ? x - saved : saved - x, n);
+					counters.countGcds(1);
+				} while (factor == 1);
+			}
+
+			if (factor != n) return factor;
+		}
+
+		return 0;
+	}
+
+	// Largest value of a 32-bit word, where the narrow kernels take over:
+	const uint64_t narrowMax = std::numeric_limits<uint32_t>::max();
+
+} // namespace
+
+
+//
+// Main library namespace:
+//
+namespace factor_algorithms
+{
+
+	// Storage for static constants that are bound to references:
+	const uint64_t BudgetTracker::timeCheckInterval;
+	const uint32_t SmallestFactorTable::tableBits;
+
+	// Montgomery constructor:
+	template <typename Word>
+	Montgomery<Word>::Montgomery(
+		Word inModulus
+		) : modulus(inModulus)
+	{
+		// Newton iteration for modulus^-1 mod 2^w, each step doubles the number of correct bits (3 to start):
+		modulusInverse = modulus;
+		for (int i = 0; i < 5; ++i) modulusInverse *= Word(2) - modulus * modulusInverse;
+
+		// 2^w mod n, then double it w more times for 2^2w mod n:
+		rModN = Word(Word(0) - modulus) % modulus;
+		rSquared = rModN;
+		for (int i = 0; i < numeric_limits<Word>::digits; ++i)
+		{
+			rSquared = (rSquared >= modulus - rSquared) ? rSquared - (modulus - rSquared) : rSquared + rSquared;
+		}
+	}
+
+	// Montgomery reduction:
+	//	Note: The low halves of T and m * n cancel exactly so only the high halves need subtracting.
+	template <typename Word>
+	Word Montgomery<Word>::reduce(
+		Word hi,
+		Word lo
+		) const
+	{
+		Word m = lo * modulusInverse;
+		Word mnHigh = 0;
+		multiplyWide(m, modulus, mnHigh);
+		return (hi >= mnHigh) ? hi - mnHigh : hi - mnHigh + modulus;
+	}
+
+	// Montgomery product:
+	template <typename Word>
+	Word Montgomery<Word>::multiply(
+		Word a,
+		Word b
+		) const
+	{
+		Word hi = 0;
+		Word lo = multiplyWide(a, b, hi);
+		return reduce(hi, lo);
+	}
+
+	// Montgomery power (square and multiply):
+	template <typename Word>
+	Word Montgomery<Word>::power(
+		Word base,
+		Word exponent
+		) const
+	{
+		Word result = rModN;
+		while (exponent != 0)
+		{
+			if (exponent & 1) result = multiply(result, base);
+			base = multiply(base, base);
+			exponent >>= 1;
+		}
+		return result;
+	}
+
+	// The two widths the library uses:
+	template class Montgomery<uint32_t>;
+	template class Montgomery<uint64_t>;
+
+
+	// Smallest-prime-factor table of this thread's node:
+	const SmallestFactorTable& SmallestFactorTable::instance()
+	{
+		static const unsigned nodes = numa::nodeCount();
+		return instance((nodes > 1) ? numa::currentNode() : 0);
+	}
+
+	// Smallest-prime-factor table of a node:
+	//	Note: The replica is built by the first thread asking from that node, so its pages land in that node's memory.
+	const SmallestFactorTable& SmallestFactorTable::instance(
+		unsigned node
+		)
+	{
+		static const unsigned nodes = numa::nodeCount();
+		static unique_ptr<once_flag[]> built(new once_flag[nodes]);
+		static unique_ptr<unique_ptr<const SmallestFactorTable>[]> replicas(new unique_ptr<const SmallestFactorTable>[nodes]);
+
+		if (node >= nodes) node = nodes - 1;
+		call_once(built[node], [node] { replicas[node].reset(new SmallestFactorTable()); });
+		return *replicas[node];
+	}
+
+	// SmallestFactorTable constructor (sieve of Eratosthenes recording the first prime to strike each entry):
+	SmallestFactorTable::SmallestFactorTable() : buffer(sizeof(uint16_t) << tableBits), table(static_cast<uint16_t*>(buffer.data()))
+	{
+		// The buffer starts out zeroed:
+		const uint32_t tableSize = uint32_t(1) << tableBits;
+		for (uint32_t p = 2; p * p < tableSize; ++p)
+		{
+			if (table[p] != 0) continue;
+			for (uint32_t multiple = p * p; multiple < tableSize; multiple += p)
+			{
+				if (table[multiple] == 0) table[multiple] = static_cast<uint16_t>(p);
+			}
+		}
+	}
+
+	// Factor using table:
+	void SmallestFactorTable::factor(
+		uint64_t number,
+		vector<uint64_t>& factors
+		) const
+	{
+		while (number > 1)
+		{
+			uint64_t p = smallestFactor(number);
+			factors.push_back(p);
+			number /= p;
+		}
+	}
+
+
+	// Bit length:
+	uint32_t bitLength(
+		uint64_t n
+		)
+	{
+		uint32_t bits = 0;
+		while (n != 0)
+		{
+			++bits;
+			n >>= 1;
+		}
+		return bits;
+	}
+
+	// Binary gcd:
+	uint64_t gcd(
+		uint64_t a,
+		uint64_t b
+		)
+	{
+		if ((a <= narrowMax) && (b <= narrowMax)) return binaryGcd<uint32_t>(static_cast<uint32_t>(a), static_cast<uint32_t>(b));
+		return binaryGcd<uint64_t>(a, b);
+	}
+
+	// Miller-Rabin:
+	bool isPrime(
+		uint64_t n
+		)
+	{
+		utils::NoCounters counters;
+		return isPrime(n, counters);
+	}
+
+	// Miller-Rabin, counted:
+	template <typename Counters>
+	bool isPrime(
+		uint64_t n,
+		Counters& counters
+		)
+	{
+		// Small primes and their multiples first, this also guarantees n is odd below:
+		static const uint64_t smallPrimes[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+		if (n < 2) return false;
+		for (auto p : smallPrimes)
+		{
+			if (n == p) return true;
+			if ((n % p) == 0) return false;
+		}
+		if (n < 37 * 37) return true;
+
+		// Three bases are enough below 2^32, seven cover the rest:
+		static const uint32_t narrowBases[] = { 2, 7, 61 };
+		static const uint32_t bases[] = { 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+		if (n <= narrowMax) return millerRabin<uint32_t>(static_cast<uint32_t>(n), narrowBases, counters);
+		return millerRabin<uint64_t>(n, bases, counters);
+	}
+
+	// Trial division:
+	bool trialDivide(
+		uint64_t& number,
+		uint64_t& candidate,
+		uint64_t bound,
+		vector<uint64_t>& factors,
+		BudgetTracker& tracker
+		)
+	{
+		utils::NoCounters counters;
+		return trialDivide(number, candidate, bound, factors, tracker, counters);
+	}
+
+	// Trial division, counted:
+	template <typename Counters>
+	bool trialDivide(
+		uint64_t& number,
+		uint64_t& candidate,
+		uint64_t bound,
+		vector<uint64_t>& factors,
+		BudgetTracker& tracker,
+		Counters& counters
+		)
+	{
+		// Going no further than sqrt(number) since going further would lead to a number bigger than number
+		//	when squared. The comparison is done as candidate <= number / candidate to stay exact in 64 bits.
+		//	Full-width divisions are only used while the cofactor needs them.
+		for (; number > narrowMax; candidate += 2)
+		{
+			if ((candidate > bound) || (candidate > number / candidate)) return true;
+			if (!tracker.spend()) return false;
+			counters.countTrialDivisions(1);
+
+			// While candidate divides n, save candidate and divide n:
+			while ((number % candidate) == 0)
+			{
+				factors.push_back(candidate);
+				number /= candidate;
+			}
+		}
+
+		// The cofactor fits in 32 bits now, so does any candidate up to its square root:
+		if ((candidate > bound) || (candidate > number / candidate)) return true;
+		uint32_t narrowNumber = static_cast<uint32_t>(number);
+		uint32_t narrowCandidate = static_cast<uint32_t>(candidate);
+		bool finished = trialDivideKernel<uint32_t>(narrowNumber, narrowCandidate, static_cast<uint32_t>(min(bound, narrowMax)), factors, tracker, counters);
+		number = narrowNumber;
+		candidate = narrowCandidate;
+		return finished;
+	}
+
+	// Pollard-Brent rho:
+	uint64_t pollardRho(
+		uint64_t n,
+		BudgetTracker& tracker
+		)
+	{
+		utils::NoCounters counters;
+		return pollardRho(n, tracker, counters);
+	}
+
+	// Pollard-Brent rho, counted:
+	template <typename Counters>
+	uint64_t pollardRho(
+		uint64_t n,
+		BudgetTracker& tracker,
+		Counters& counters
+		)
+	{
+		if (n <= narrowMax) return pollardRhoKernel<uint32_t>(static_cast<uint32_t>(n), tracker, counters);
+		return pollardRhoKernel<uint64_t>(n, tracker, counters);
+	}
+
+	// Both counter policies:
+	template bool isPrime<utils::NoCounters>(uint64_t, utils::NoCounters&);
+	template bool isPrime<utils::FactorCounters>(uint64_t, utils::FactorCounters&);
+	template bool trialDivide<utils::NoCounters>(uint64_t&, uint64_t&, uint64_t, vector<uint64_t>&, BudgetTracker&, utils::NoCounters&);
+	template bool trialDivide<utils::FactorCounters>(uint64_t&, uint64_t&, uint64_t, vector<uint64_t>&, BudgetTracker&, utils::FactorCounters&);
+	template uint64_t pollardRho<utils::NoCounters>(uint64_t, BudgetTracker&, utils::NoCounters&);
+	template uint64_t pollardRho<utils::FactorCounters>(uint64_t, BudgetTracker&, utils::FactorCounters&);
+
+} // namespace factor_algorithms
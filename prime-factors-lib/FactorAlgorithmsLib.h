@@ -0,0 +1,312 @@
+///////////////////////////////////////
+///
+///	\file		FactorAlgorithmsLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		FactorAlgorithmsLib library header
+///
+///	\notes
+///		1. Building blocks for factoring 64-bit numbers: a smallest-prime-factor lookup table, trial division,
+///			deterministic Miller-Rabin and Pollard-Brent rho. Choosing between them is left to FactorDispatchLib.
+///		2. Every routine that can run for a long time charges its work to a BudgetTracker so callers can cut
+///			a factorization short (see utils::FactorBudget).
+///		3. The arithmetic core (Montgomery form, Miller-Rabin, rho and the trial-division loop) is written once over
+///			the word width and instantiated for uint32_t and uint64_t. The 64-bit entry points drop to the 32-bit
+///			instantiation as soon as the number, or the cofactor left by trial division, fits in 32 bits, where
+///			divisions and products are several times cheaper.
+///		4. isPrime(), trialDivide() and pollardRho() also come as templates over a counter policy (utils::NoCounters
+///			or utils::FactorCounters) that is told about every trial division, rho step, gcd and Miller-Rabin round.
+///			The plain functions are the NoCounters instantiation, so they pay nothing for the hooks.
+///		5. SmallestFactorTable is kept once per NUMA node and backed by huge pages (see NumaLib.h), so threads on
+///			every socket look it up in local memory and its 2 MiB fit one TLB entry.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef FACTOR_ALGORITHMS_LIB_H
+#define	FACTOR_ALGORITHMS_LIB_H
+
+
+//
+// Local includes:
+//
+#include "NumaLib.h"
+#include "UtilsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <chrono>
+#include <stdint.h>
+#include <vector>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace factor_algorithms
+{
+
+	/// Tracks work spent against a utils::FactorBudget.
+	class BudgetTracker
+	{
+	public:
+
+		/// Default constructor:
+		BudgetTracker() = delete;
+
+		/// Custom constructor, the wall-clock budget starts counting here:
+		explicit BudgetTracker(
+			const utils::FactorBudget& inBudget			///< Limits to enforce
+			) : budget(inBudget), iterations(0), nextTimeCheck(timeCheckInterval), deadline(deadlineAfter(inBudget.maxMilliseconds)) {}
+
+
+		//
+		// Member functions:
+		//
+
+		/// Charge inIterations units of work. Returns false once the budget is spent.
+		///	Note: Reading the clock costs far more than a division, so the deadline is only checked every
+		///		   timeCheckInterval iterations.
+		bool spend(
+			uint64_t inIterations = 1					///< Units of work (trial divisions, rho steps) to charge
+			)
+		{
+			if (budget.isUnlimited()) return true;
+
+			iterations += inIterations;
+			if ((budget.maxIterations != 0) && (iterations > budget.maxIterations)) return false;
+			if ((budget.maxMilliseconds != 0) && (iterations >= nextTimeCheck))
+			{
+				nextTimeCheck = iterations + timeCheckInterval;
+				if (std::chrono::steady_clock::now() >= deadline) return false;
+			}
+
+			return true;
+		}
+
+		/// Get number of iterations charged so far.
+		uint64_t getIterations() const { return iterations; }
+
+	private:
+
+		//
+		// Member variables:
+		//
+		static const uint64_t timeCheckInterval = 1024;
+		const utils::FactorBudget budget;
+		uint64_t iterations;
+		uint64_t nextTimeCheck;
+		const std::chrono::steady_clock::time_point deadline;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Now plus inMilliseconds, saturated to the latest time point instead of overflowing for huge budgets.
+		static std::chrono::steady_clock::time_point deadlineAfter(
+			uint64_t inMilliseconds						///< Time allowed
+			)
+		{
+			typedef std::chrono::steady_clock clock;
+			clock::time_point now = clock::now();
+			clock::duration left = clock::time_point::max() - now;
+			if (inMilliseconds >= uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(left).count())) return clock::time_point::max();
+			return now + std::chrono::milliseconds(inMilliseconds);
+		}
+
+	};
+
+
+	/// Arithmetic in Montgomery form modulo an odd modulus of type Word (uint32_t or uint64_t).
+	template <typename Word>
+	class Montgomery
+	{
+	public:
+
+		/// Default constructor:
+		Montgomery() = delete;
+
+		/// Custom constructor:
+		explicit Montgomery(
+			Word inModulus								///< Odd modulus
+			);
+
+
+		//
+		// Member functions:
+		//
+
+		/// Get modulus.
+		Word getModulus() const { return modulus; }
+
+		/// Convert a (< modulus) to Montgomery form.
+		Word toMontgomery(Word a) const { return multiply(a, rSquared); }
+
+		/// Convert a out of Montgomery form.
+		Word fromMontgomery(Word a) const { return reduce(0, a); }
+
+		/// Montgomery form of 1.
+		Word one() const { return rModN; }
+
+		/// Product of two numbers in Montgomery form.
+		Word multiply(Word a, Word b) const;
+
+		/// Sum of two numbers in Montgomery form.
+		Word add(Word a, Word b) const { return (a >= modulus - b) ? a - (modulus - b) : a + b; }
+
+		/// Power of a number in Montgomery form.
+		Word power(Word base, Word exponent) const;
+
+	private:
+
+		//
+		// Member variables:
+		//
+		Word modulus;
+		Word modulusInverse;						///< modulus^-1 mod 2^w (w = bits in Word)
+		Word rModN;									///< 2^w mod modulus
+		Word rSquared;								///< 2^2w mod modulus
+
+
+		//
+		// Member functions:
+		//
+
+		/// Montgomery reduction of the double-width value hi:lo (< modulus * 2^w).
+		Word reduce(Word hi, Word lo) const;
+
+	};
+
+	/// Instantiations provided by the library:
+	typedef Montgomery<uint32_t> Montgomery32;
+	typedef Montgomery<uint64_t> Montgomery64;
+
+
+	/// Read-only smallest-prime-factor table for every n < 2^tableBits, built once per NUMA node on first use there.
+	class SmallestFactorTable
+	{
+	public:
+
+		/// Number of bits covered by the table.
+		static const uint32_t tableBits = 20;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Get the table of the calling thread's node.
+		static const SmallestFactorTable& instance();
+
+		/// Get the table of node inNode (the last node's if there are fewer).
+		static const SmallestFactorTable& instance(
+			unsigned inNode								///< Node, see numa::currentNode()
+			);
+
+		/// True if n is covered by the table.
+		bool covers(uint64_t n) const { return n < (uint64_t(1) << tableBits); }
+
+		/// Smallest prime factor of n (n itself if n is prime). n must be covered and >= 2.
+		uint64_t smallestFactor(uint64_t n) const { return (table[n] != 0) ? table[n] : n; }
+
+		/// Append all prime factors of n in ascending order. n must be covered.
+		void factor(
+			uint64_t inNumber,							///< Number to factor
+			std::vector<uint64_t>& outFactors			///< Factors are appended here
+			) const;
+
+	private:
+
+		/// Only instance() builds tables:
+		SmallestFactorTable();
+
+		/// No copies, table points into buffer:
+		SmallestFactorTable(const SmallestFactorTable&) = delete;
+		SmallestFactorTable& operator=(const SmallestFactorTable&) = delete;
+
+		//
+		// Member variables:
+		//
+		numa::LargePageBuffer buffer;
+		uint16_t* table;							///< Smallest prime factor, 0 for primes (all fit in 16 bits)
+
+	};
+
+
+	/// Number of significant bits in n (0 for 0).
+	uint32_t bitLength(
+		uint64_t n									///< Number to measure
+		);
+
+
+	/// Greatest common divisor.
+	uint64_t gcd(
+		uint64_t a,									///< First number
+		uint64_t b									///< Second number
+		);
+
+
+	/// Deterministic Miller-Rabin primality test, exact for every 64-bit n.
+	bool isPrime(
+		uint64_t n									///< Number to test
+		);
+
+	/// isPrime() reporting the rounds it ran to ioCounters.
+	template <typename Counters>
+	bool isPrime(
+		uint64_t n,									///< Number to test
+		Counters& ioCounters						///< Counter policy
+		);
+
+
+	/// Divide all odd candidates d, starting at ioCandidate, out of ioNumber while d <= inBound and d * d <= ioNumber.
+	///	Returns false if the budget ran out, ioCandidate then holds the next candidate to try.
+	bool trialDivide(
+		uint64_t& ioNumber,							///< Odd number to reduce, the cofactor is left here
+		uint64_t& ioCandidate,						///< Odd candidate to start at, next untried candidate on return
+		uint64_t inBound,							///< Largest candidate to try
+		std::vector<uint64_t>& outFactors,			///< Factors found are appended here, ascending
+		BudgetTracker& ioTracker					///< Budget to charge one iteration per candidate to
+		);
+
+	/// trialDivide() reporting the candidates it tried to ioCounters.
+	template <typename Counters>
+	bool trialDivide(
+		uint64_t& ioNumber,							///< Odd number to reduce, the cofactor is left here
+		uint64_t& ioCandidate,						///< Odd candidate to start at, next untried candidate on return
+		uint64_t inBound,							///< Largest candidate to try
+		std::vector<uint64_t>& outFactors,			///< Factors found are appended here, ascending
+		BudgetTracker& ioTracker,					///< Budget to charge one iteration per candidate to
+		Counters& ioCounters						///< Counter policy
+		);
+
+
+	/// Pollard-Brent rho. Returns a nontrivial factor of the odd composite n, or 0 if the budget ran out.
+	uint64_t pollardRho(
+		uint64_t n,									///< Odd composite to split
+		BudgetTracker& ioTracker					///< Budget to charge one iteration per rho step to
+		);
+
+	/// pollardRho() reporting its steps and gcds to ioCounters.
+	template <typename Counters>
+	uint64_t pollardRho(
+		uint64_t n,									///< Odd composite to split
+		BudgetTracker& ioTracker,					///< Budget to charge one iteration per rho step to
+		Counters& ioCounters						///< Counter policy
+		);
+
+} // namespace factor_algorithms
+
+#endif // FACTOR_ALGORITHMS_LIB_H
@@ -0,0 +1,215 @@
+///////////////////////////////////////
+///
+///	\file		FactorCacheLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for FactorCacheLib.h
+///
+///	\notes
+///		1. The clock hand sweeps each shard's slots; referenced slots get their bit cleared and a second chance,
+///			unreferenced ones are evicted. Two full sweeps always free a slot.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "FactorCacheLib.h"
+
+
+//
+// Compiler includes:
+//
+//...
+
+
+//
+// Namespaces:
+//
+using namespace std;
+namespace u = utils;
+
+
+//
+// Main library namespace:
+//
+namespace factor_cache
+{
+
+	// FactorCache constructor:
+	FactorCache::FactorCache(
+		size_t inMaxBytes,
+		chrono::nanoseconds inAdmissionThreshold,
+		size_t inShardCount
+		) : shardMaxBytes(inMaxBytes / (inShardCount > 0 ? inShardCount : 1)), admissionThreshold(inAdmissionThreshold)
+	{
+		for (size_t i = 0; i < (inShardCount > 0 ? inShardCount : 1); ++i)
+		{
+			unique_ptr<Shard> shard(new Shard());
+			shard->hand = 0;
+			shard->bytesUsed = 0;
+			shard->statistics = CacheStatistics();
+			shards.push_back(move(shard));
+		}
+	}
+
+	// Find cached result:
+	bool FactorCache::find(
+		uint64_t number,
+		u::FactorResult& result
+		)
+	{
+		Shard& shard = shardFor(number);
+		lock_guard<mutex> lock(shard.shardMutex);
+
+		auto entry = shard.index.find(number);
+		if (entry == shard.index.end())
+		{
+			++shard.statistics.misses;
+			return false;
+		}
+
+		Slot& slot = shard.slots[entry->second];
+		slot.referenced = true;
+		result = slot.result;
+		++shard.statistics.hits;
+		return true;
+	}
+
+	// Offer result to the cache:
+	void FactorCache::offer(
+		uint64_t number,
+		const u::FactorResult& result,
+		chrono::nanoseconds computeTime
+		)
+	{
+		Shard& shard = shardFor(number);
+		size_t newBytes = entryBytes(result);
+
+		// Admission policy:
+		if ((result.status != u::FactorStatus::complete) || (computeTime < admissionThreshold) || (newBytes > shardMaxBytes))
+		{
+			lock_guard<mutex> lock(shard.shardMutex);
+			++shard.statistics.rejections;
+			return;
+		}
+
+		lock_guard<mutex> lock(shard.shardMutex);
+		if (shard.index.count(number) != 0) return;
+
+		// Run the clock until there is room:
+		while ((shard.bytesUsed + newBytes > shardMaxBytes) && !shard.slots.empty())
+		{
+			Slot& slot = shard.slots[shard.hand];
+			if (slot.occupied && slot.referenced)
+			{
+				slot.referenced = false;
+			}
+			else if (slot.occupied)
+			{
+				shard.bytesUsed -= entryBytes(slot.result);
+				shard.index.erase(slot.number);
+				slot.occupied = false;
+				slot.result = u::FactorResult();
+				shard.freeSlots.push_back(shard.hand);
+				++shard.statistics.evictions;
+			}
+			shard.hand = (shard.hand + 1) % shard.slots.size();
+		}
+
+		// Reuse an evicted slot if there is one, otherwise grow the ring:
+		size_t slotIndex = shard.slots.size();
+		if (!shard.freeSlots.empty())
+		{
+			slotIndex = shard.freeSlots.back();
+			shard.freeSlots.pop_back();
+		}
+		else
+		{
+			shard.slots.push_back(Slot());
+		}
+
+		Slot& slot = shard.slots[slotIndex];
+		slot.number = number;
+		slot.result = result;
+		slot.referenced = false;
+		slot.occupied = true;
+		shard.index[number] = slotIndex;
+		shard.bytesUsed += newBytes;
+		++shard.statistics.insertions;
+	}
+
+	// Factor through cache:
+	u::FactorResult FactorCache::factor(
+		uint64_t number,
+		const u::FactorBudget& budget
+		)
+	{
+		u::FactorResult result;
+		if (find(number, result)) return result;
+
+		auto start = chrono::steady_clock::now();
+		result = u::calculatePrimeFactors(number, budget);
+		offer(number, result, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start));
+
+		return result;
+	}
+
+	// Factor through cache with dispatcher:
+	u::FactorResult FactorCache::factor(
+		uint64_t number,
+		const factor_dispatch::Dispatcher& dispatcher,
+		const u::FactorBudget& budget
+		)
+	{
+		u::FactorResult result;
+		if (find(number, result)) return result;
+
+		auto start = chrono::steady_clock::now();
+		result = dispatcher.factor(number, budget);
+		offer(number, result, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start));
+
+		return result;
+	}
+
+	// Sum statistics:
+	CacheStatistics FactorCache::getStatistics() const
+	{
+		CacheStatistics total = CacheStatistics();
+		for (auto& shard : shards)
+		{
+			lock_guard<mutex> lock(shard->shardMutex);
+			total.hits += shard->statistics.hits;
+			total.misses += shard->statistics.misses;
+			total.insertions += shard->statistics.insertions;
+			total.rejections += shard->statistics.rejections;
+			total.evictions += shard->statistics.evictions;
+			total.bytesUsed += shard->bytesUsed;
+		}
+		return total;
+	}
+
+	// Shard for number:
+	//	Note: Mixed with the splitmix64 finalizer so that runs of nearby numbers spread over all shards.
+	FactorCache::Shard& FactorCache::shardFor(
+		uint64_t number
+		)
+	{
+		uint64_t h = number;
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+		h = h ^ (h >> 31);
+		return *shards[h % shards.size()];
+	}
+
+	// Estimate entry size:
+	size_t FactorCache::entryBytes(
+		const u::FactorResult& result
+		)
+	{
+		// The result lives in its ring slot, the map's value is the slot index:
+		return u::factorEntryBytes(result, sizeof(Slot) + sizeof(size_t));
+	}
+
+} // namespace factor_cache
@@ -0,0 +1,171 @@
+///////////////////////////////////////
+///
+///	\file		FactorCacheLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		FactorCacheLib library header
+///
+///	\notes
+///		1. Thread-safe cache of factorizations meant to live across many calls (daemons, batch drivers). The
+///			cache is split into shards, each with its own lock, so concurrent callers rarely contend.
+///		2. Each shard evicts with the CLOCK algorithm (second chance): a hit only sets a reference bit, so
+///			lookups never reorder anything.
+///		3. Only complete factorizations that took at least the admission threshold to compute are stored.
+///			Cheap numbers are faster to recompute than to cache, and budget-cut results depend on the budget.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef FACTOR_CACHE_LIB_H
+#define	FACTOR_CACHE_LIB_H
+
+
+//
+// Local includes:
+//
+#include "UtilsLib.h"
+#include "FactorDispatchLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace factor_cache
+{
+
+	/// Counters for sizing a cache.
+	struct CacheStatistics
+	{
+		uint64_t hits;								///< Lookups that found a result
+		uint64_t misses;							///< Lookups that did not
+		uint64_t insertions;						///< Results stored
+		uint64_t rejections;						///< Results not admitted (too cheap or incomplete)
+		uint64_t evictions;							///< Results dropped to stay under the memory cap
+		std::size_t bytesUsed;						///< Approximate memory in use
+	};
+
+
+	/// Sharded CLOCK cache from number to complete factorization.
+	class FactorCache
+	{
+	public:
+
+		/// Default constructor:
+		FactorCache() = delete;
+
+		/// Custom constructor:
+		explicit FactorCache(
+			std::size_t inMaxBytes,										///< Approximate memory cap over all shards
+			std::chrono::nanoseconds inAdmissionThreshold = std::chrono::nanoseconds(0),	///< Minimum compute time to be cached
+			std::size_t inShardCount = 16								///< Number of independently locked shards
+			);
+
+		/// No copies, shards own mutexes:
+		FactorCache(const FactorCache&) = delete;
+		FactorCache& operator=(const FactorCache&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Copy the cached result for inNumber into outResult. Returns false on a miss.
+		bool find(
+			uint64_t inNumber,							///< Number to look up
+			utils::FactorResult& outResult				///< Cached result on a hit
+			);
+
+		/// Offer a freshly computed result, it is stored only if it passes the admission policy.
+		void offer(
+			uint64_t inNumber,							///< Number that was factored
+			const utils::FactorResult& inResult,		///< Its factorization
+			std::chrono::nanoseconds inComputeTime		///< How long it took to compute
+			);
+
+		/// Factor through the cache with utils::calculatePrimeFactors.
+		utils::FactorResult factor(
+			uint64_t inNumber,							///< Number to calculate prime factors of
+			const utils::FactorBudget& inBudget			///< Work limits on a miss
+			);
+
+		/// Factor through the cache with a specific dispatcher.
+		utils::FactorResult factor(
+			uint64_t inNumber,							///< Number to calculate prime factors of
+			const factor_dispatch::Dispatcher& inDispatcher,	///< Dispatcher to use on a miss
+			const utils::FactorBudget& inBudget			///< Work limits on a miss
+			);
+
+		/// Get counters summed over all shards.
+		CacheStatistics getStatistics() const;
+
+	private:
+
+		/// One CLOCK slot:
+		struct Slot
+		{
+			uint64_t number;
+			utils::FactorResult result;
+			bool referenced;
+			bool occupied;
+		};
+
+		/// One independently locked part of the cache:
+		struct Shard
+		{
+			mutable std::mutex shardMutex;
+			std::vector<Slot> slots;
+			std::vector<std::size_t> freeSlots;
+			std::unordered_map<uint64_t, std::size_t> index;
+			std::size_t hand;
+			std::size_t bytesUsed;
+			CacheStatistics statistics;
+		};
+
+		//
+		// Member variables:
+		//
+		const std::size_t shardMaxBytes;
+		const std::chrono::nanoseconds admissionThreshold;
+		std::vector<std::unique_ptr<Shard>> shards;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Shard owning inNumber.
+		Shard& shardFor(
+			uint64_t inNumber							///< Number to place
+			);
+
+		/// Approximate memory used by one entry.
+		static std::size_t entryBytes(
+			const utils::FactorResult& inResult			///< Entry to measure
+			);
+
+	};
+
+} // namespace factor_cache
+
+#endif // FACTOR_CACHE_LIB_H
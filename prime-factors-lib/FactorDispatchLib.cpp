@@ -0,0 +1,448 @@
+///////////////////////////////////////
+///
+///	\file		FactorDispatchLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for FactorDispatchLib.h
+///
+///	\notes
+///		1. Calibration times each method on synthetic worst cases for the method that would otherwise be
+///			chosen (primes and balanced semiprimes with no small factors) and keeps the crossover points.
+///			It uses a fixed seed so repeated runs on the same machine measure the same inputs.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "FactorDispatchLib.h"
+#include "FactorAlgorithmsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+
+//
+// Namespaces:
+//
+using namespace std;
+namespace u = utils;
+namespace fa = factor_algorithms;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	// Finish a factorization cut short by the budget, cofactor is whatever is left of the number:
+	//	Note: Miller-Rabin is cheap compared to what was already spent, so the cofactor is always classified.
+	template <typename Counters>
+	void finishPartial(
+		u::FactorResult& result,
+		uint64_t cofactor,
+		Counters& counters
+		)
+	{
+		if (fa::isPrime(cofactor, counters))
+		{
+			result.primeFactors.push_back(cofactor);
+		}
+		else
+		{
+			result.cofactor = cofactor;
+			result.status = u::FactorStatus::compositeUnfactored;
+		}
+	}
+
+	// Split n completely with Miller-Rabin and rho, returns the product of everything left unsplit (1 if done):
+	//	Note: At most 63 odd factors can be pending at once, so a fixed-size stack is enough.
+	template <typename Counters>
+	uint64_t factorWithRho(
+		uint64_t n,
+		vector<uint64_t>& factors,
+		fa::BudgetTracker& tracker,
+		Counters& counters
+		)
+	{
+		uint64_t pending[64];
+		size_t pendingCount = 0;
+		pending[pendingCount++] = n;
+
+		while (pendingCount != 0)
+		{
+			uint64_t m = pending[--pendingCount];
+			if (fa::isPrime(m, counters))
+			{
+				factors.push_back(m);
+				continue;
+			}
+
+			uint64_t d = fa::pollardRho(m, tracker, counters);
+			if (d == 0)
+			{
+				// Out of budget, keep the primes we can still recognize and hand back the rest:
+				uint64_t unfactored = m;
+				while (pendingCount != 0)
+				{
+					uint64_t rest = pending[--pendingCount];
+					if (fa::isPrime(rest, counters)) factors.push_back(rest);
+					else unfactored *= rest;
+				}
+				return unfactored;
+			}
+
+			pending[pendingCount++] = d;
+			pending[pendingCount++] = m / d;
+		}
+
+		return 1;
+	}
+
+	// Random odd number with exactly the given number of bits (>= 2):
+	uint64_t randomOddWithBits(
+		mt19937_64& rng,
+		uint32_t bits
+		)
+	{
+		uint64_t topBit = uint64_t(1) << (bits - 1);
+		return (rng() & (topBit - 1)) | topBit | 1;
+	}
+
+	// Random prime with exactly the given number of bits (>= 3):
+	uint64_t randomPrimeWithBits(
+		mt19937_64& rng,
+		uint32_t bits
+		)
+	{
+		uint64_t candidate = randomOddWithBits(rng, bits);
+		while (!fa::isPrime(candidate)) candidate = randomOddWithBits(rng, bits);
+		return candidate;
+	}
+
+	// Average nanoseconds per number for a dispatcher over a sample set:
+	double timePerNumber(
+		const factor_dispatch::Dispatcher& dispatcher,
+		const vector<uint64_t>& samples
+		)
+	{
+		const u::FactorBudget unlimited;
+		uint64_t checksum = 0;
+
+		auto start = chrono::steady_clock::now();
+		for (auto n : samples) checksum += dispatcher.factor(n, unlimited).primeFactors.size();
+		auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+
+		// Keep the work observable so it cannot be optimized away:
+		if (checksum == 0) return 0.0;
+		return static_cast<double>(elapsed.count()) / static_cast<double>(samples.size());
+	}
+
+	// Trim whitespace from both ends of a string:
+	string trim(
+		const string& str
+		)
+	{
+		size_t first = str.find_first_not_of(" \t\r");
+		if (first == string::npos) return string();
+		size_t last = str.find_last_not_of(" \t\r");
+		return str.substr(first, last - first + 1);
+	}
+
+} // namespace
+
+
+//
+// Main library namespace:
+//
+namespace factor_dispatch
+{
+
+	// Default thresholds (a typical x86-64 calibration):
+	DispatchThresholds defaultThresholds()
+	{
+		DispatchThresholds thresholds;
+		thresholds.lookupTableMaxBits = fa::SmallestFactorTable::tableBits;
+		thresholds.preTrialBound = 128;
+		thresholds.trialDivisionMaxBits = 20;
+		return thresholds;
+	}
+
+	// Load thresholds:
+	DispatchThresholds loadThresholds(
+		const string& fileName
+		)
+	{
+		ifstream file(fileName);
+		if (!file.is_open())
+		{
+			throw runtime_error(string("Error: Problem(s) occured while trying to open the file: '") + fileName + string("'; aborting."));
+		}
+
+		DispatchThresholds thresholds = defaultThresholds();
+		string line;
+		uint64_t lineNumber = 0;
+		while (getline(file, line))
+		{
+			++lineNumber;
+
+			// Skip blank lines and comments:
+			line = trim(line);
+			if (line.empty() || (line[0] == '#')) continue;
+
+			// Every other line is 'key = value':
+			size_t equals = line.find('=');
+			string key = (equals == string::npos) ? line : trim(line.substr(0, equals));
+			string valueStr = (equals == string::npos) ? string() : trim(line.substr(equals + 1));
+
+			// Parse value (convertStrToLL treats 0 as a failure, but 0 is a valid threshold):
+			char* valueEnd = nullptr;
+			int64_t value = strtoll(valueStr.c_str(), &valueEnd, 10);
+			if (valueStr.empty() || (*valueEnd != '\0') || (value < 0))
+			{
+				throw runtime_error(string("Error: Invalid value on line ") + to_string(lineNumber) + string(" of '") + fileName + string("'; aborting."));
+			}
+
+			if (key == "lookupTableMaxBits") thresholds.lookupTableMaxBits = static_cast<uint32_t>(min<int64_t>(value, fa::SmallestFactorTable::tableBits));
+			else if (key == "preTrialBound") thresholds.preTrialBound = static_cast<uint64_t>(max<int64_t>(value, 3));
+			else if (key == "trialDivisionMaxBits") thresholds.trialDivisionMaxBits = static_cast<uint32_t>(min<int64_t>(value, 64));
+			else
+			{
+				throw runtime_error(string("Error: Unknown key '") + key + string("' on line ") + to_string(lineNumber) + string(" of '") + fileName + string("'; aborting."));
+			}
+		}
+
+		return thresholds;
+	}
+
+	// Save thresholds:
+	void saveThresholds(
+		const DispatchThresholds& thresholds,
+		const string& fileName
+		)
+	{
+		ofstream file(fileName);
+		if (!file.is_open())
+		{
+			throw runtime_error(string("Error: Problem(s) occured while trying to open the file: '") + fileName + string("'; aborting."));
+		}
+
+		file << "# prime-factors dispatch thresholds" << endl
+			 << "lookupTableMaxBits = " << thresholds.lookupTableMaxBits << endl
+			 << "preTrialBound = " << thresholds.preTrialBound << endl
+			 << "trialDivisionMaxBits = " << thresholds.trialDivisionMaxBits << endl;
+
+		if (!file)
+		{
+			throw runtime_error(string("Error: Problem(s) occured while writing the file: '") + fileName + string("'; aborting."));
+		}
+	}
+
+	// Calibrate thresholds:
+	DispatchThresholds calibrateThresholds()
+	{
+		DispatchThresholds thresholds = defaultThresholds();
+		mt19937_64 rng(20150211);
+		const size_t sampleCount = 256;
+
+		// Dispatchers that force one method on everything past the pre-pass:
+		DispatchThresholds trialOnly = thresholds;
+		trialOnly.lookupTableMaxBits = 0;
+		trialOnly.trialDivisionMaxBits = 64;
+		DispatchThresholds rhoOnly = trialOnly;
+		rhoOnly.trialDivisionMaxBits = 0;
+		DispatchThresholds tableOnly = trialOnly;
+		tableOnly.lookupTableMaxBits = fa::SmallestFactorTable::tableBits;
+
+		// 1. Lookup table against trial division for tiny numbers (the table itself is built before timing):
+		fa::SmallestFactorTable::instance();
+		thresholds.lookupTableMaxBits = 0;
+		for (uint32_t bits = 4; bits <= fa::SmallestFactorTable::tableBits; ++bits)
+		{
+			vector<uint64_t> samples;
+			for (size_t i = 0; i < sampleCount; ++i) samples.push_back(randomOddWithBits(rng, bits) - (rng() & 1));
+
+			if (timePerNumber(Dispatcher(tableOnly), samples) <= timePerNumber(Dispatcher(trialOnly), samples))
+			{
+				thresholds.lookupTableMaxBits = bits;
+			}
+		}
+
+		// 2. Trial division against Miller-Rabin + rho for residuals with no small factors (primes and balanced
+		//		semiprimes are the worst case for trial division). Once trial division is far behind it only gets
+		//		worse with size, so stop measuring there.
+		thresholds.trialDivisionMaxBits = 0;
+		for (uint32_t bits = 16; bits <= 64; bits += 2)
+		{
+			vector<uint64_t> samples;
+			for (size_t i = 0; i < sampleCount; ++i)
+			{
+				samples.push_back((i & 1) ? randomPrimeWithBits(rng, bits)
+										  : randomPrimeWithBits(rng, bits / 2) * randomPrimeWithBits(rng, bits - bits / 2));
+			}
+
+			double trialTime = timePerNumber(Dispatcher(trialOnly), samples);
+			double rhoTime = timePerNumber(Dispatcher(rhoOnly), samples);
+			if (trialTime <= rhoTime) thresholds.trialDivisionMaxBits = bits;
+			if (trialTime > 4 * rhoTime) break;
+		}
+
+		// 3. Pre-pass bound that is fastest over uniformly random 64-bit numbers:
+		vector<uint64_t> samples;
+		for (size_t i = 0; i < 4 * sampleCount; ++i) samples.push_back(rng() >> 1);
+
+		double bestTime = 0.0;
+		const uint64_t bounds[] = { 32, 64, 128, 256, 512, 1024, 2048 };
+		for (auto bound : bounds)
+		{
+			DispatchThresholds candidate = thresholds;
+			candidate.preTrialBound = bound;
+
+			double time = timePerNumber(Dispatcher(candidate), samples);
+			if ((bestTime == 0.0) || (time < bestTime))
+			{
+				bestTime = time;
+				thresholds.preTrialBound = bound;
+			}
+		}
+
+		return thresholds;
+	}
+
+
+	// Dispatcher default constructor:
+	Dispatcher::Dispatcher() : thresholds(defaultThresholds())
+	{
+	}
+
+	// Dispatcher constructor:
+	Dispatcher::Dispatcher(
+		const DispatchThresholds& inThresholds
+		) : thresholds(inThresholds)
+	{
+		// The table only covers so many bits:
+		thresholds.lookupTableMaxBits = min(thresholds.lookupTableMaxBits, fa::SmallestFactorTable::tableBits);
+		thresholds.preTrialBound = max<uint64_t>(thresholds.preTrialBound, 3);
+	}
+
+	// Choose method:
+	Method Dispatcher::chooseMethod(
+		uint64_t number
+		) const
+	{
+		uint32_t bits = fa::bitLength(number);
+
+		if (bits <= thresholds.lookupTableMaxBits) return Method::lookupTable;
+		if (bits <= thresholds.trialDivisionMaxBits) return Method::trialDivision;
+		return Method::millerRabinRho;
+	}
+
+	// Dispatch factorization:
+	u::FactorResult Dispatcher::factor(
+		uint64_t numberToFactor,
+		const u::FactorBudget& budget
+		) const
+	{
+		u::NoCounters counters;
+		return factor(numberToFactor, budget, counters);
+	}
+
+	// Factor, counted:
+	template <typename Counters>
+	u::FactorResult Dispatcher::factor(
+		uint64_t numberToFactor,
+		const u::FactorBudget& budget,
+		Counters& counters
+		) const
+	{
+		// Result to hold our prime factors in, assume we finish until the budget says otherwise:
+		u::FactorResult result;
+		result.cofactor = 1;
+		result.status = u::FactorStatus::complete;
+
+		// 0 and 1 have no prime factors:
+		if (numberToFactor < 2) return result;
+
+		// Tiny numbers are a single table walk:
+		if (chooseMethod(numberToFactor) == Method::lookupTable)
+		{
+			fa::SmallestFactorTable::instance().factor(numberToFactor, result.primeFactors);
+			return result;
+		}
+
+		// Save the number of 2s that divide n:
+		while ((numberToFactor & 1) == 0)
+		{
+			result.primeFactors.push_back(2);
+			numberToFactor >>= 1;
+		}
+
+		// Trial-division pre-pass strips small factors from everything:
+		fa::BudgetTracker tracker(budget);
+		uint64_t candidate = 3;
+		if (!fa::trialDivide(numberToFactor, candidate, thresholds.preTrialBound, result.primeFactors, tracker, counters))
+		{
+			finishPartial(result, numberToFactor, counters);
+			return result;
+		}
+		if (numberToFactor == 1) return result;
+
+		// Nothing up to sqrt(n) divides the residual so it is prime:
+		if (candidate > numberToFactor / candidate)
+		{
+			result.primeFactors.push_back(numberToFactor);
+			return result;
+		}
+
+		// Residual decides the rest:
+		switch (chooseMethod(numberToFactor))
+		{
+		case Method::lookupTable:
+			fa::SmallestFactorTable::instance().factor(numberToFactor, result.primeFactors);
+			break;
+
+		case Method::trialDivision:
+			if (!fa::trialDivide(numberToFactor, candidate, numeric_limits<uint64_t>::max(), result.primeFactors, tracker, counters))
+			{
+				finishPartial(result, numberToFactor, counters);
+				return result;
+			}
+			if (numberToFactor > 1) result.primeFactors.push_back(numberToFactor);
+			break;
+
+		case Method::millerRabinRho:
+			{
+				// Rho finds factors in no particular order, everything it adds is above the pre-pass bound:
+				size_t sortFrom = result.primeFactors.size();
+				uint64_t unfactored = factorWithRho(numberToFactor, result.primeFactors, tracker, counters);
+				sort(result.primeFactors.begin() + sortFrom, result.primeFactors.end());
+
+				if (unfactored != 1)
+				{
+					result.cofactor = unfactored;
+					result.status = u::FactorStatus::compositeUnfactored;
+				}
+			}
+			break;
+		}
+
+		return result;
+	}
+
+	// Both counter policies:
+	template u::FactorResult Dispatcher::factor<u::NoCounters>(uint64_t, const u::FactorBudget&, u::NoCounters&) const;
+	template u::FactorResult Dispatcher::factor<u::FactorCounters>(uint64_t, const u::FactorBudget&, u::FactorCounters&) const;
+
+} // namespace factor_dispatch
@@ -0,0 +1,140 @@
+///////////////////////////////////////
+///
+///	\file		FactorDispatchLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		FactorDispatchLib library header
+///
+///	\notes
+///		1. Picks the factoring method for each number from its bit length and from the residual left after a
+///			short trial-division pre-pass: the lookup table for tiny numbers, trial division for small residuals and
+///			Miller-Rabin followed by Pollard-Brent rho for everything larger.
+///		2. The crossover points live in DispatchThresholds. calibrateThresholds() measures them on the host and
+///			saveThresholds()/loadThresholds() keep them in a plain 'key = value' config file.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef FACTOR_DISPATCH_LIB_H
+#define	FACTOR_DISPATCH_LIB_H
+
+
+//
+// Local includes:
+//
+#include "UtilsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <stdint.h>
+#include <string>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace factor_dispatch
+{
+
+	/// Factoring methods the dispatcher can choose from.
+	enum class Method
+	{
+		lookupTable,								///< Smallest-prime-factor table
+		trialDivision,								///< Trial division up to sqrt(n)
+		millerRabinRho								///< Miller-Rabin, then Pollard-Brent rho on composites
+	};
+
+
+	/// Crossover points between methods.
+	struct DispatchThresholds
+	{
+		uint32_t lookupTableMaxBits;				///< Numbers with at most this many bits use the lookup table
+		uint64_t preTrialBound;						///< Largest trial divisor of the pre-pass
+		uint32_t trialDivisionMaxBits;				///< Residuals with at most this many bits finish with trial division
+	};
+
+
+	/// Thresholds used when no calibration is available.
+	DispatchThresholds defaultThresholds();
+
+
+	/// Load thresholds from a config file written by saveThresholds(). Missing keys keep their default.
+	DispatchThresholds loadThresholds(
+		const std::string& inFileName				///< Config file to read
+		);
+
+
+	/// Save thresholds to a config file.
+	void saveThresholds(
+		const DispatchThresholds& inThresholds,		///< Thresholds to save
+		const std::string& inFileName				///< Config file to write
+		);
+
+
+	/// Measure the crossover points between methods on this machine.
+	DispatchThresholds calibrateThresholds();
+
+
+	/// Picks and runs the fastest method for each number.
+	class Dispatcher
+	{
+	public:
+
+		/// Default constructor (default thresholds):
+		Dispatcher();
+
+		/// Custom constructor:
+		explicit Dispatcher(
+			const DispatchThresholds& inThresholds	///< Crossover points to use
+			);
+
+
+		//
+		// Member functions:
+		//
+
+		/// Get thresholds in use.
+		const DispatchThresholds& getThresholds() const { return thresholds; }
+
+		/// Method used for a number (or pre-pass residual) of this size.
+		Method chooseMethod(
+			uint64_t inNumber						///< Number or residual to classify
+			) const;
+
+		/// Factor a number within a budget, factors are returned in ascending order.
+		utils::FactorResult factor(
+			uint64_t inNumberToFactor,				///< Number to calculate prime factors of
+			const utils::FactorBudget& inBudget		///< Work limits for this number
+			) const;
+
+		/// factor() reporting its work to a counter policy (utils::NoCounters or utils::FactorCounters).
+		template <typename Counters>
+		utils::FactorResult factor(
+			uint64_t inNumberToFactor,				///< Number to calculate prime factors of
+			const utils::FactorBudget& inBudget,	///< Work limits for this number
+			Counters& ioCounters					///< Counts of the work done are added here
+			) const;
+
+	private:
+
+		//
+		// Member variables:
+		//
+		DispatchThresholds thresholds;
+
+	};
+
+} // namespace factor_dispatch
+
+#endif // FACTOR_DISPATCH_LIB_H
@@ -0,0 +1,246 @@
+///////////////////////////////////////
+///
+///	\file		FactorGeneratorLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for FactorGeneratorLib.h
+///
+///	\notes
+///		1. Each call to next() resumes the stage it stopped in, so trial division continues from the last
+///			candidate instead of starting over.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "FactorGeneratorLib.h"
+#include "FactorAlgorithmsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+
+//
+// Namespaces:
+//
+using namespace std;
+namespace fa = factor_algorithms;
+namespace fd = factor_dispatch;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	// Dispatcher with default thresholds shared by generators that are not given one:
+	const fd::Dispatcher& defaultDispatcher()
+	{
+		static const fd::Dispatcher sharedDispatcher;
+		return sharedDispatcher;
+	}
+
+} // namespace
+
+
+//
+// Main library namespace:
+//
+namespace factor_generator
+{
+
+	// FactorGenerator constructor:
+	FactorGenerator::FactorGenerator(
+		uint64_t inNumber
+		) : FactorGenerator(inNumber, defaultDispatcher())
+	{
+	}
+
+	// FactorGenerator constructor:
+	FactorGenerator::FactorGenerator(
+		uint64_t inNumber,
+		const fd::Dispatcher& inDispatcher
+		) : dispatcher(inDispatcher), remaining(inNumber), candidate(3), stage(Stage::start), pendingCount(0), pendingNext(0)
+	{
+	}
+
+	// Next factor:
+	bool FactorGenerator::next(
+		uint64_t& outFactor
+		)
+	{
+		for (;;)
+		{
+			switch (stage)
+			{
+			case Stage::start:
+				if (remaining < 2) stage = Stage::done;
+				else stage = (dispatcher.chooseMethod(remaining) == fd::Method::lookupTable) ? Stage::table : Stage::twos;
+				break;
+
+			case Stage::table:
+				if (remaining == 1)
+				{
+					stage = Stage::done;
+					break;
+				}
+				outFactor = fa::SmallestFactorTable::instance().smallestFactor(remaining);
+				remaining /= outFactor;
+				return true;
+
+			case Stage::twos:
+				if ((remaining & 1) == 0)
+				{
+					remaining >>= 1;
+					outFactor = 2;
+					return true;
+				}
+				stage = Stage::preTrial;
+				break;
+
+			case Stage::preTrial:
+				if (trialStep(dispatcher.getThresholds().preTrialBound, outFactor)) return true;
+				if (stage == Stage::preTrial) stage = Stage::residual;
+				break;
+
+			case Stage::residual:
+				switch (dispatcher.chooseMethod(remaining))
+				{
+				case fd::Method::lookupTable:
+					stage = Stage::table;
+					break;
+
+				case fd::Method::trialDivision:
+					stage = Stage::trial;
+					break;
+
+				case fd::Method::millerRabinRho:
+					splitWithRho();
+					stage = Stage::pending;
+					break;
+				}
+				break;
+
+			case Stage::trial:
+				if (trialStep(numeric_limits<uint64_t>::max(), outFactor)) return true;
+				break;
+
+			case Stage::pending:
+				if (pendingNext == pendingCount)
+				{
+					stage = Stage::done;
+					break;
+				}
+				outFactor = pendingFactors[pendingNext++];
+				remaining /= outFactor;
+				return true;
+
+			case Stage::done:
+				return false;
+			}
+		}
+	}
+
+	// Trial step:
+	//	Note: Once no candidate up to sqrt(remaining) is left, remaining itself is prime and is handed out last.
+	bool FactorGenerator::trialStep(
+		uint64_t inBound,
+		uint64_t& outFactor
+		)
+	{
+		if (remaining == 1)
+		{
+			stage = Stage::done;
+			return false;
+		}
+
+		for (; (candidate <= inBound) && (candidate <= remaining / candidate); candidate += 2)
+		{
+			if ((remaining % candidate) == 0)
+			{
+				remaining /= candidate;
+				outFactor = candidate;
+				return true;
+			}
+		}
+
+		if (candidate > remaining / candidate)
+		{
+			outFactor = remaining;
+			remaining = 1;
+			stage = Stage::done;
+			return true;
+		}
+
+		return false;
+	}
+
+	// Split with rho:
+	void FactorGenerator::splitWithRho()
+	{
+		fa::BudgetTracker tracker((utils::FactorBudget()));
+
+		uint64_t stack[64];
+		size_t stackCount = 0;
+		stack[stackCount++] = remaining;
+		while (stackCount != 0)
+		{
+			uint64_t m = stack[--stackCount];
+			if (fa::isPrime(m))
+			{
+				pendingFactors[pendingCount++] = m;
+				continue;
+			}
+
+			// Rho gives up (0) once every walk has failed, the budget is unlimited so nothing else stops it:
+			uint64_t d = fa::pollardRho(m, tracker);
+			if ((d == 0) || (d == m))
+			{
+				throw runtime_error(string("Error: Could not split the composite '") + to_string(m) + string("'; aborting."));
+			}
+			stack[stackCount++] = d;
+			stack[stackCount++] = m / d;
+		}
+
+		sort(pendingFactors, pendingFactors + pendingCount);
+	}
+
+
+	// Smallest prime factor:
+	uint64_t smallestPrimeFactor(
+		uint64_t n
+		)
+	{
+		uint64_t factor = 0;
+		FactorGenerator generator(n);
+		return generator.next(factor) ? factor : 0;
+	}
+
+	// Smoothness test:
+	//	Note: Anything left that is no larger than the bound cannot have a larger prime factor, so we stop there.
+	bool isSmooth(
+		uint64_t n,
+		uint64_t inBound
+		)
+	{
+		uint64_t factor = 0;
+		FactorGenerator generator(n);
+		while (generator.getRemaining() > inBound)
+		{
+			if (!generator.next(factor)) return true;
+			if (factor > inBound) return false;
+		}
+
+		return true;
+	}
+
+} // namespace factor_generator
@@ -0,0 +1,141 @@
+///////////////////////////////////////
+///
+///	\file		FactorGeneratorLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		FactorGeneratorLib library header
+///
+///	\notes
+///		1. FactorGenerator hands out prime factors one at a time and only does the work needed for the next one,
+///			so callers that stop early (smallest factor, smoothness tests) never pay for the full factorization.
+///		2. It walks the same methods as factor_dispatch::Dispatcher. The table, the trial-division stages and the
+///			final prime come out in ascending order for free; a residual that needs rho is split completely first
+///			and its factors sorted, which keeps the whole sequence ascending.
+///		3. No allocations: every bit of state, rho's pending factors included, lives inside the generator.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef FACTOR_GENERATOR_LIB_H
+#define	FACTOR_GENERATOR_LIB_H
+
+
+//
+// Local includes:
+//
+#include "FactorDispatchLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <cstddef>
+#include <stdint.h>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace factor_generator
+{
+
+	/// Lazy, ascending sequence of the prime factors of one number (with multiplicity).
+	class FactorGenerator
+	{
+	public:
+
+		/// Default constructor:
+		FactorGenerator() = delete;
+
+		/// Custom constructor, uses a shared dispatcher with default thresholds:
+		explicit FactorGenerator(
+			uint64_t inNumber							///< Number to factor
+			);
+
+		/// Custom constructor:
+		FactorGenerator(
+			uint64_t inNumber,							///< Number to factor
+			const factor_dispatch::Dispatcher& inDispatcher	///< Picks the methods, must outlive the generator
+			);
+
+
+		//
+		// Member functions:
+		//
+
+		/// Get the next prime factor. Returns false once every factor has been handed out. Throws if rho cannot
+		///	split a composite (every walk failed), rather than hand out a factor that is not prime.
+		bool next(
+			uint64_t& outFactor							///< Next prime factor, never smaller than the previous one
+			);
+
+		/// Product of the factors not handed out yet (1 once done).
+		uint64_t getRemaining() const { return remaining; }
+
+	private:
+
+		/// Where the generator is in the factorization:
+		enum class Stage
+		{
+			start,									///< Nothing done yet
+			table,									///< Remaining is covered by the lookup table
+			twos,									///< Dividing out 2s
+			preTrial,								///< Trial division up to the pre-pass bound
+			residual,								///< Picking the method for what the pre-pass left
+			trial,									///< Trial division up to sqrt(remaining)
+			pending,								///< Handing out the sorted factors rho found
+			done									///< Nothing left
+		};
+
+		//
+		// Member variables:
+		//
+		const factor_dispatch::Dispatcher& dispatcher;
+		uint64_t remaining;
+		uint64_t candidate;							///< Next odd trial divisor
+		Stage stage;
+		uint64_t pendingFactors[64];				///< A 64-bit number has fewer than 64 prime factors
+		std::size_t pendingCount;
+		std::size_t pendingNext;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Try odd candidates up to inBound (and sqrt(remaining)). Returns true with the first one that divides.
+		bool trialStep(
+			uint64_t inBound,							///< Largest candidate to try
+			uint64_t& outFactor							///< Divisor found
+			);
+
+		/// Split remaining completely with Miller-Rabin and rho into the sorted pending factors. Throws if rho gives up.
+		void splitWithRho();
+
+	};
+
+
+	/// Smallest prime factor of n, 0 for n < 2. Throws like FactorGenerator::next().
+	uint64_t smallestPrimeFactor(
+		uint64_t n									///< Number to inspect
+		);
+
+
+	/// True if no prime factor of n is larger than inBound (0 and 1 count as smooth). Throws like FactorGenerator::next().
+	bool isSmooth(
+		uint64_t n,									///< Number to inspect
+		uint64_t inBound							///< Largest allowed prime factor
+		);
+
+} // namespace factor_generator
+
+#endif // FACTOR_GENERATOR_LIB_H
@@ -0,0 +1,379 @@
+///////////////////////////////////////
+///
+///	\file		FactorStoreLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for FactorStoreLib.h
+///
+///	\notes
+///		1. Log layout: 8-byte magic, then records of uint64 number, uint32 factor count, uint64 factors[count].
+///		2. Index layout: 8-byte magic, uint64 entry count, uint64 log bytes covered, then IndexEntry[count]
+///			sorted by number. The 24-byte header keeps the entries 8-byte aligned in the mapping.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "FactorStoreLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#if !defined(WIN32) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+//
+// Namespaces:
+//
+using namespace std;
+namespace u = utils;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	// File format constants:
+	const char logMagic[8] = { 'P', 'F', 'L', 'O', 'G', '0', '0', '1' };
+	const char indexMagic[8] = { 'P', 'F', 'I', 'D', 'X', '0', '0', '1' };
+	const uint64_t logHeaderBytes = sizeof(logMagic);
+	const uint64_t indexHeaderBytes = sizeof(indexMagic) + 2 * sizeof(uint64_t);
+	const uint64_t recordHeaderBytes = sizeof(uint64_t) + sizeof(uint32_t);
+	const uint32_t maxFactorsPerRecord = 64;
+
+	// Unaligned read of a plain value from a byte buffer:
+	template <typename T>
+	T readValue(
+		const char* bytes
+		)
+	{
+		T value;
+		memcpy(&value, bytes, sizeof(T));
+		return value;
+	}
+
+} // namespace
+
+
+//
+// Main library namespace:
+//
+namespace factor_store
+{
+
+	// MappedFile default constructor:
+	MappedFile::MappedFile() : mappedData(nullptr), mappedSize(0), isMapped(false)
+	{
+	}
+
+	// MappedFile constructor:
+	MappedFile::MappedFile(
+		const string& fileName
+		) : mappedData(nullptr), mappedSize(0), isMapped(false)
+	{
+#if defined(WIN32) || defined(_WIN32)
+		// No mapping here, read the whole file instead:
+		ifstream file(fileName, ios::binary | ios::ate);
+		if (!file.is_open()) return;
+
+		fallbackData.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		if (!fallbackData.empty() && !file.read(&fallbackData[0], fallbackData.size()))
+		{
+			throw runtime_error(string("Error: Problem(s) occured while reading the file: '") + fileName + string("'; aborting."));
+		}
+		mappedData = fallbackData.empty() ? nullptr : &fallbackData[0];
+		mappedSize = fallbackData.size();
+#else
+		int fd = open(fileName.c_str(), O_RDONLY);
+		if (fd == -1) return;
+
+		struct stat fileStat;
+		size_t fileSize = (fstat(fd, &fileStat) == 0) ? static_cast<size_t>(fileStat.st_size) : 0;
+		if (fileSize > 0)
+		{
+			void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+			if (mapping != MAP_FAILED)
+			{
+				mappedData = static_cast<const char*>(mapping);
+				mappedSize = fileSize;
+				isMapped = true;
+			}
+		}
+		::close(fd);
+
+		if ((fileSize > 0) && !isMapped)
+		{
+			throw runtime_error(string("Error: Problem(s) occured while mapping the file: '") + fileName + string("'; aborting."));
+		}
+#endif
+	}
+
+	// MappedFile destructor:
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	// Release view:
+	void MappedFile::close()
+	{
+#if !defined(WIN32) && !defined(_WIN32)
+		if (isMapped) munmap(const_cast<char*>(mappedData), mappedSize);
+#endif
+		fallbackData.clear();
+		mappedData = nullptr;
+		mappedSize = 0;
+		isMapped = false;
+	}
+
+
+	// FactorStore constructor:
+	FactorStore::FactorStore(
+		const string& inPath
+		) : logPath(inPath), indexPath(inPath + ".idx"), logView(logPath), indexView(indexPath),
+			indexEntries(nullptr), indexCount(0), logBytes(0), mappedLogBytes(0), indexDirty(false), isOpen(true)
+	{
+		// Make sure an existing log really is one of ours before appending to it:
+		bool newLog = (logView.size() == 0);
+		if (!newLog && ((logView.size() < logHeaderBytes) || (memcmp(logView.data(), logMagic, sizeof(logMagic)) != 0)))
+		{
+			throw runtime_error(string("Error: '") + logPath + string("' is not a prime-factors store; aborting."));
+		}
+
+		// Use the index only if it is whole and agrees with the log, otherwise the log is rescanned:
+		uint64_t indexedLogBytes = logHeaderBytes;
+		if ((indexView.size() >= indexHeaderBytes) && (memcmp(indexView.data(), indexMagic, sizeof(indexMagic)) == 0))
+		{
+			uint64_t count = readValue<uint64_t>(indexView.data() + sizeof(indexMagic));
+			uint64_t covered = readValue<uint64_t>(indexView.data() + sizeof(indexMagic) + sizeof(uint64_t));
+			if ((indexView.size() == indexHeaderBytes + count * sizeof(IndexEntry)) && (covered <= logView.size()) && (covered >= logHeaderBytes))
+			{
+				indexEntries = reinterpret_cast<const IndexEntry*>(indexView.data() + indexHeaderBytes);
+				indexCount = static_cast<size_t>(count);
+				indexedLogBytes = covered;
+			}
+		}
+		if ((indexEntries == nullptr) && !newLog) indexDirty = true;
+
+		// Pick up records the index does not cover and drop a torn record at the end:
+		logBytes = newLog ? logHeaderBytes : scanLog(indexedLogBytes);
+		if (!newLog && (logBytes < logView.size())) u::truncateFile(logPath, logBytes);
+
+		// Pages of the mapping past the truncated end no longer exist, lookups stay below it:
+		mappedLogBytes = newLog ? 0 : logBytes;
+		if (!unindexed.empty()) indexDirty = true;
+
+		// Open log for appending:
+		logOut.open(logPath, ios::binary | ios::app);
+		if (!logOut.is_open())
+		{
+			throw runtime_error(string("Error: Problem(s) occured while trying to open the file: '") + logPath + string("'; aborting."));
+		}
+		if (newLog) logOut.write(logMagic, sizeof(logMagic));
+	}
+
+	// FactorStore destructor:
+	FactorStore::~FactorStore()
+	{
+		// Destructors must not throw, so errors are only reported through close():
+		try
+		{
+			close();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	// Find stored result:
+	bool FactorStore::find(
+		uint64_t number,
+		u::FactorResult& result
+		)
+	{
+		if (!isOpen) throw logic_error("Error: find() called on a closed FactorStore; aborting.");
+
+		// In the mapped log, which does not change until close() so needs no lock:
+		if (!readMapped(number, result.primeFactors))
+		{
+			// Added during this run:
+			lock_guard<mutex> lock(storeMutex);
+			auto addedRecord = added.find(number);
+			if (addedRecord == added.end()) return false;
+			result.primeFactors = addedRecord->second.primeFactors;
+		}
+		result.cofactor = 1;
+		result.status = u::FactorStatus::complete;
+		return true;
+	}
+
+	// Append result:
+	void FactorStore::add(
+		uint64_t number,
+		const u::FactorResult& result
+		)
+	{
+		if ((result.status != u::FactorStatus::complete) || (result.primeFactors.size() > maxFactorsPerRecord)) return;
+
+		lock_guard<mutex> lock(storeMutex);
+		if (!isOpen) throw logic_error("Error: add() called on a closed FactorStore; aborting.");
+		if ((added.count(number) != 0) || (findMapped(number) != 0)) return;
+
+		// Record header then factors:
+		uint32_t count = static_cast<uint32_t>(result.primeFactors.size());
+		logOut.write(reinterpret_cast<const char*>(&number), sizeof(number));
+		logOut.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		logOut.write(reinterpret_cast<const char*>(result.primeFactors.data()), count * sizeof(uint64_t));
+		if (!logOut)
+		{
+			throw runtime_error(string("Error: Problem(s) occured while writing the file: '") + logPath + string("'; aborting."));
+		}
+
+		AddedRecord record;
+		record.logOffset = logBytes;
+		record.primeFactors = result.primeFactors;
+		added.insert(make_pair(number, record));
+		logBytes += recordHeaderBytes + count * sizeof(uint64_t);
+		indexDirty = true;
+	}
+
+	// Number of stored numbers:
+	size_t FactorStore::size()
+	{
+		lock_guard<mutex> lock(storeMutex);
+		return indexCount + unindexed.size() + added.size();
+	}
+
+	// Flush and write index:
+	void FactorStore::close()
+	{
+		lock_guard<mutex> lock(storeMutex);
+		if (!isOpen) return;
+		isOpen = false;
+
+		logOut.close();
+		if (logOut.fail())
+		{
+			throw runtime_error(string("Error: Problem(s) occured while writing the file: '") + logPath + string("'; aborting."));
+		}
+		if (!indexDirty) return;
+
+		// Merge the old (sorted) index with everything it does not cover yet:
+		vector<IndexEntry> entries(indexEntries, indexEntries + indexCount);
+		size_t oldCount = entries.size();
+		for (auto& record : unindexed)
+		{
+			IndexEntry entry = { record.first, record.second };
+			entries.push_back(entry);
+		}
+		for (auto& record : added)
+		{
+			IndexEntry entry = { record.first, record.second.logOffset };
+			entries.push_back(entry);
+		}
+		auto byNumber = [](const IndexEntry& a, const IndexEntry& b) { return a.number < b.number; };
+		sort(entries.begin() + oldCount, entries.end(), byNumber);
+		inplace_merge(entries.begin(), entries.begin() + oldCount, entries.end(), byNumber);
+
+		// Write the new index next to the old one:
+		string tempPath = indexPath + ".tmp";
+		{
+			ofstream indexOut(tempPath, ios::binary | ios::trunc);
+			uint64_t count = entries.size();
+			indexOut.write(indexMagic, sizeof(indexMagic));
+			indexOut.write(reinterpret_cast<const char*>(&count), sizeof(count));
+			indexOut.write(reinterpret_cast<const char*>(&logBytes), sizeof(logBytes));
+			if (!entries.empty()) indexOut.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(IndexEntry));
+			indexOut.close();
+			if (indexOut.fail())
+			{
+				throw runtime_error(string("Error: Problem(s) occured while writing the file: '") + tempPath + string("'; aborting."));
+			}
+		}
+
+		// Swap it in, the old index has to be released (and on Windows removed) first:
+		indexEntries = nullptr;
+		indexCount = 0;
+		indexView.close();
+		logView.close();
+#if defined(WIN32) || defined(_WIN32)
+		remove(indexPath.c_str());
+#endif
+		if (rename(tempPath.c_str(), indexPath.c_str()) != 0)
+		{
+			throw runtime_error(string("Error: Problem(s) occured while replacing the file: '") + indexPath + string("'; aborting."));
+		}
+	}
+
+	// Find in mapped log:
+	uint64_t FactorStore::findMapped(
+		uint64_t number
+		) const
+	{
+		auto record = unindexed.find(number);
+		if (record != unindexed.end()) return record->second;
+
+		const IndexEntry* end = indexEntries + indexCount;
+		const IndexEntry* entry = lower_bound(indexEntries, end, number,
+			[](const IndexEntry& e, uint64_t n) { return e.number < n; });
+		return ((entry != end) && (entry->number == number)) ? entry->logOffset : 0;
+	}
+
+	// Read record from mapped log:
+	bool FactorStore::readMapped(
+		uint64_t number,
+		vector<uint64_t>& factors
+		) const
+	{
+		uint64_t offset = findMapped(number);
+		if (offset == 0) return false;
+
+		// The offset comes from the index file, which may not match a log cut short or damaged since:
+		const uint64_t size = mappedLogBytes;
+		if ((offset < logHeaderBytes) || (offset > size) || (size - offset < recordHeaderBytes)) return false;
+		uint32_t count = readValue<uint32_t>(logView.data() + offset + sizeof(uint64_t));
+		if ((count > maxFactorsPerRecord) || (size - offset - recordHeaderBytes < uint64_t(count) * sizeof(uint64_t))) return false;
+		if (readValue<uint64_t>(logView.data() + offset) != number) return false;
+
+		const char* factorBytes = logView.data() + offset + recordHeaderBytes;
+		factors.resize(count);
+		for (uint32_t i = 0; i < count; ++i) factors[i] = readValue<uint64_t>(factorBytes + i * sizeof(uint64_t));
+		return true;
+	}
+
+	// Scan log records:
+	uint64_t FactorStore::scanLog(
+		uint64_t offset
+		)
+	{
+		const uint64_t size = logView.size();
+		while (offset + recordHeaderBytes <= size)
+		{
+			uint64_t number = readValue<uint64_t>(logView.data() + offset);
+			uint32_t count = readValue<uint32_t>(logView.data() + offset + sizeof(uint64_t));
+			uint64_t recordBytes = recordHeaderBytes + uint64_t(count) * sizeof(uint64_t);
+			if ((count > maxFactorsPerRecord) || (offset + recordBytes > size)) break;
+
+			unindexed[number] = offset;
+			offset += recordBytes;
+		}
+		return offset;
+	}
+
+} // namespace factor_store
@@ -0,0 +1,214 @@
+///////////////////////////////////////
+///
+///	\file		FactorStoreLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		FactorStoreLib library header
+///
+///	\notes
+///		1. Persistent store of complete factorizations shared between runs. It is made of two files:
+///			- '<path>': append-only log of records (number, factor count, factors).
+///			- '<path>.idx': sorted array of (number, log offset) pairs plus how much of the log it covers.
+///		2. Both files are memory-mapped read-only when the store is opened, so a lookup is a binary search over
+///			the index and a read straight out of the mapped log. Results added during the run are appended to
+///			the log immediately and kept in memory; close() merges them into a new index which replaces the old
+///			one with a rename, so a crash never leaves a half-written index behind.
+///		3. Log records past the end of the index (a run that died before close()) are picked up again on open,
+///			and a torn record at the very end of the log is cut off.
+///		4. Files are in native byte order; they are meant to be shared between runs on the same machine.
+///		5. The mappings, the index and the records found past it do not change between opening and close(), so
+///			lookups in them take no lock and any number of threads can search them at once. Only the records added
+///			during the run and the appends share a mutex. A record whose offset points outside the mapped log, or
+///			at a record for another number, is treated as not stored.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef FACTOR_STORE_LIB_H
+#define	FACTOR_STORE_LIB_H
+
+
+//
+// Local includes:
+//
+#include "UtilsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace factor_store
+{
+
+	/// RAII read-only view of a whole file, memory-mapped where the platform allows it.
+	class MappedFile
+	{
+	public:
+
+		/// Default constructor (empty view):
+		MappedFile();
+
+		/// Custom constructor, a missing or empty file gives an empty view:
+		explicit MappedFile(
+			const std::string& inFileName				///< File to map
+			);
+
+		/// Destructor:
+		~MappedFile();
+
+		/// No copies, the mapping is owned:
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Start of the file contents.
+		const char* data() const { return mappedData; }
+
+		/// Size of the file contents.
+		std::size_t size() const { return mappedSize; }
+
+		/// Release the view (needed before the file can be replaced on some platforms).
+		void close();
+
+	private:
+
+		//
+		// Member variables:
+		//
+		const char* mappedData;
+		std::size_t mappedSize;
+		bool isMapped;
+		std::vector<char> fallbackData;				///< Copy of the file where mapping is not available
+
+	};
+
+
+	/// RAII persistent factorization store.
+	class FactorStore
+	{
+	public:
+
+		/// Default constructor:
+		FactorStore() = delete;
+
+		/// Custom constructor, creates the store if it does not exist:
+		explicit FactorStore(
+			const std::string& inPath					///< Path of the log file, the index is '<path>.idx'
+			);
+
+		/// Destructor (closes the store, errors are only reported through close()):
+		~FactorStore();
+
+		/// No copies, the files are owned:
+		FactorStore(const FactorStore&) = delete;
+		FactorStore& operator=(const FactorStore&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Copy the stored factorization of inNumber into outResult. Returns false if it is not stored.
+		bool find(
+			uint64_t inNumber,							///< Number to look up
+			utils::FactorResult& outResult				///< Stored result when found
+			);
+
+		/// Append a factorization. Only complete results are kept, numbers already stored are skipped.
+		void add(
+			uint64_t inNumber,							///< Number that was factored
+			const utils::FactorResult& inResult			///< Its factorization
+			);
+
+		/// Number of distinct numbers stored.
+		std::size_t size();
+
+		/// Flush the log and write the merged index. Throws on I/O errors. No other thread may still be using the store.
+		void close();
+
+	private:
+
+		/// One index entry, exactly as laid out in the index file:
+		struct IndexEntry
+		{
+			uint64_t number;
+			uint64_t logOffset;
+		};
+
+		/// Record appended during this run:
+		struct AddedRecord
+		{
+			uint64_t logOffset;
+			std::vector<uint64_t> primeFactors;
+		};
+
+		//
+		// Member variables:
+		//
+		const std::string logPath;
+		const std::string indexPath;
+		std::mutex storeMutex;						///< Guards added, logOut, logBytes and indexDirty
+		MappedFile logView;
+		MappedFile indexView;
+		const IndexEntry* indexEntries;
+		std::size_t indexCount;
+		std::map<uint64_t, uint64_t> unindexed;		///< Number -> log offset of mapped records not in the index yet
+		std::map<uint64_t, AddedRecord> added;		///< Records appended since opening (not in the mapping)
+		std::ofstream logOut;
+		uint64_t logBytes;
+		uint64_t mappedLogBytes;					///< Bytes of logView still in the log, which may have been cut short under the mapping
+		bool indexDirty;
+		std::atomic<bool> isOpen;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Log offset of inNumber's record in the mapped log, or 0 if it is not there.
+		uint64_t findMapped(
+			uint64_t inNumber							///< Number to look up
+			) const;
+
+		/// Copy the factors of inNumber's record in the mapped log. Returns false if it is not there or is out of bounds.
+		bool readMapped(
+			uint64_t inNumber,							///< Number to look up
+			std::vector<uint64_t>& outFactors			///< Stored factors when found
+			) const;
+
+		/// Scan mapped log records from inOffset into unindexed, returns the end of the last whole record.
+		uint64_t scanLog(
+			uint64_t inOffset							///< First record to scan
+			);
+
+	};
+
+} // namespace factor_store
+
+#endif // FACTOR_STORE_LIB_H
@@ -7,7 +7,7 @@
 ///
 ///	\notes
 ///		1. RAII guarantees that when the FileParser object goes out of scope, the destructor will be called
-///			which will close the files the object controls.
+///			which will close the files the object controls (through compressed_input::InputFile).
 ///
 ///////////////////////////////////////
 
@@ -21,6 +21,7 @@
 //
 // Compiler includes:
 //
+#include <algorithm>
 #include <stdexcept>
 
 
@@ -36,10 +37,32 @@ using namespace std;
 namespace file_parser
 {
 
+	// Assign text to arena:
+	void LineArena::assign(
+		vector<char>&& inText
+		)
+	{
+		text = move(inText);
+		offsets.clear();
+
+		// A missing final newline is added so every line ends the same way:
+		if (!text.empty() && (text.back() != '\n')) text.push_back('\n');
+
+		// Count first so the offsets are allocated once:
+		offsets.reserve(count(text.begin(), text.end(), '\n') + 1);
+		offsets.push_back(0);
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			if (text[i] == '\n') offsets.push_back(i + 1);
+		}
+	}
+
+
 	// FileParser constructor:
 	FileParser::FileParser(
-		const string& inFileName
-		) : fileName(inFileName)
+		const string& inFileName,
+		unsigned inDecompressThreads
+		) : file(inFileName, inDecompressThreads), fileName(inFileName)
 	{
 		// Parse file:
 		this->parseFile();
@@ -48,27 +71,37 @@ namespace file_parser
 	// FileParse destructor:
 	FileParser::~FileParser()
 	{
-		file.close();
 	}
 
 	// Parse file contents:
 	void FileParser::parseFile()
 	{
-		// Open file:
-		file.open(fileName);
+		istream& stream = file.getStream();
+		vector<char> text;
 
-		// Check is file was opened incorrectly:
-		if (!file.is_open())
+		// Read a plain file in one go, with room for a final newline:
+		//	Note: The file is in text mode so line endings are translated, gcount() gives what actually arrived.
+		uint64_t fileSize = file.getFileSize();
+		if (fileSize > 0)
 		{
-			throw runtime_error(string("Error: Problem(s) occured while trying to open the file: '") + fileName + string("'; aborting."));
+			text.reserve(static_cast<size_t>(fileSize) + 1);
+			text.resize(static_cast<size_t>(fileSize));
+			stream.read(text.data(), static_cast<streamsize>(fileSize));
+			text.resize(static_cast<size_t>(stream.gcount()));
 		}
 
-		// Read file line by line until end:
-		string line = "";
-		while (getline(file, line))
+		// Compressed files and pipes have no size up front, they are read in chunks:
+		const size_t chunkSize = 1 << 20;
+		while ((fileSize == 0) && stream)
 		{
-			contents.push_back(line);
+			size_t oldSize = text.size();
+			text.resize(oldSize + chunkSize);
+			stream.read(text.data() + oldSize, chunkSize);
+			text.resize(oldSize + static_cast<size_t>(stream.gcount()));
 		}
+
+		// Split into lines:
+		contents.assign(move(text));
 	}
 
 } // namespace file_parser
\ No newline at end of file
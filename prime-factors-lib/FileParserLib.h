@@ -7,6 +7,10 @@
 ///
 ///	\notes
 ///		1. FileParser helper library for RAII file IO classes.
+///		2. Lines are kept in a LineArena: the whole file is read into one character buffer and each line is found
+///			through an offsets array, so loading a file costs two allocations whatever its line count and
+///			freeing it is just as cheap. Lines are handed out as LineViews pointing into that buffer.
+///		3. gzip and zstd files are decompressed while they are read (see CompressedInputLib.h).
 ///
 ///////////////////////////////////////
 
@@ -21,12 +25,13 @@
 //
 // Local includes:
 //
-//...
+#include "CompressedInputLib.h"
 
 
 //
 // Compiler includes:
 //
+#include <cstddef>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -45,6 +50,108 @@
 namespace file_parser
 {
 
+	/// Non-owning view of one line, valid for as long as the LineArena it came from.
+	class LineView
+	{
+	public:
+
+		/// Default constructor (empty line):
+		LineView() : first(nullptr), length(0) {}
+
+		/// Custom constructor:
+		LineView(
+			const char* inFirst,						///< First character of the line
+			std::size_t inLength						///< Number of characters, without the newline
+			) : first(inFirst), length(inLength) {}
+
+
+		//
+		// Member functions:
+		//
+
+		/// First character of the line (not null-terminated).
+		const char* data() const { return first; }
+
+		/// Number of characters in the line.
+		std::size_t size() const { return length; }
+
+		/// True if the line has no characters.
+		bool empty() const { return length == 0; }
+
+		/// Iteration over the characters.
+		const char* begin() const { return first; }
+		const char* end() const { return first + length; }
+
+		/// Copy of the line as a string.
+		std::string str() const { return std::string(first, length); }
+
+	private:
+
+		//
+		// Member variables:
+		//
+		const char* first;
+		std::size_t length;
+
+	};
+
+
+	/// Monotonic line storage: one character buffer holding every line plus the offset where each one starts.
+	class LineArena
+	{
+	public:
+
+		/// Forward iterator handing out LineViews by value.
+		class const_iterator
+		{
+		public:
+			const_iterator(const LineArena* inArena, std::size_t inIndex) : arena(inArena), index(inIndex) {}
+			LineView operator*() const { return (*arena)[index]; }
+			const_iterator& operator++() { ++index; return *this; }
+			bool operator==(const const_iterator& other) const { return index == other.index; }
+			bool operator!=(const const_iterator& other) const { return index != other.index; }
+		private:
+			const LineArena* arena;
+			std::size_t index;
+		};
+
+		/// Default constructor (no lines):
+		LineArena() {}
+
+
+		//
+		// Member functions:
+		//
+
+		/// Take over raw text and index its lines. Lines end at '\n' like std::getline, a last line without one counts.
+		void assign(
+			std::vector<char>&& inText					///< Text to split into lines
+			);
+
+		/// Number of lines.
+		std::size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+		/// True if there are no lines.
+		bool empty() const { return size() == 0; }
+
+		/// Line i, without its newline.
+		LineView operator[](std::size_t i) const { return LineView(text.data() + offsets[i], offsets[i + 1] - offsets[i] - 1); }
+
+		/// Iteration over all lines in order.
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, size()); }
+
+	private:
+
+		//
+		// Member variables:
+		//
+		std::vector<char> text;						///< Every line, each followed by its '\n'
+		std::vector<std::size_t> offsets;			///< Start of each line, then one past the last '\n'
+
+	};
+
+
 	/// RAII FileParser class:
 	class FileParser
 	{
@@ -55,7 +162,8 @@ namespace file_parser
 
 		/// Custom constructor:
 		explicit FileParser(
-			const std::string& inFileName		///< File name of file to open
+			const std::string& inFileName,		///< File name of file to open
+			unsigned inDecompressThreads = 1	///< Worker threads for compressed formats that allow it
 			);
 
 		// Destructor:
@@ -69,17 +177,17 @@ namespace file_parser
 		/// Get name of file.
 		std::string getFileName() { return fileName; }
 
-		/// Get the contents of the file stored in a vector, (each entry is a line).
-		std::vector<std::string> getContents() { return contents; }
+		/// Get the contents of the file, (each entry is a line).
+		const LineArena& getContents() const { return contents; }
 
 	private:
 
 		//
 		// Member variables:
 		//
-		std::ifstream file;
+		compressed_input::InputFile file;
 		const std::string fileName;
-		std::vector<std::string> contents;
+		LineArena contents;
 
 
 		//
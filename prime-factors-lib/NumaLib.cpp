@@ -0,0 +1,366 @@
+///////////////////////////////////////
+///
+///	\file		NumaLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for NumaLib.h
+///
+///	\notes
+///		1. Node ids in sysfs may have gaps (and nodes may have memory but no CPUs), Topology numbers the nodes that
+///			have CPUs this process may use from 0 instead so they can index arrays of replicas.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "NumaLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <thread>
+#include <utility>
+
+#if !defined(WIN32) && !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+
+//
+// Namespaces:
+//
+using namespace std;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	// Size of the huge pages used for transparent huge pages (x86-64 and most other 64-bit Linux targets):
+	const size_t hugePageSize = size_t(2) << 20;
+
+	// Node of this thread, -1 until pinned or asked:
+	thread_local int threadNode = -1;
+
+	// Read the topology from sysfs, one node of every CPU where that is not possible:
+	numa::Topology readSystemTopology()
+	{
+		numa::Topology topology;
+
+#if defined(__linux__)
+		// CPUs this process may use:
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		bool haveMask = (sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+
+		// Nodes are listed in ascending order, CPUs of each node are kept if the mask allows them:
+		try
+		{
+			ifstream onlineFile("/sys/devices/system/node/online");
+			string onlineNodes;
+			if (getline(onlineFile, onlineNodes))
+			{
+				for (unsigned node : numa::parseCpuList(onlineNodes))
+				{
+					ifstream cpuListFile("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+					string cpuList;
+					if (!getline(cpuListFile, cpuList)) continue;
+
+					vector<unsigned> cpus;
+					for (unsigned cpu : numa::parseCpuList(cpuList))
+					{
+						if (!haveMask || ((cpu < CPU_SETSIZE) && CPU_ISSET(cpu, &allowed))) cpus.push_back(cpu);
+					}
+					if (cpus.empty()) continue;
+
+					// Cores first, then their second threads (a CPU without a siblings list is its own core):
+					vector<vector<unsigned>> siblings;
+					for (unsigned cpu : cpus)
+					{
+						ifstream siblingsFile("/sys/devices/system/cpu/cpu" + to_string(cpu) + "/topology/thread_siblings_list");
+						string siblingsList;
+						siblings.push_back(getline(siblingsFile, siblingsList) ? numa::parseCpuList(siblingsList) : vector<unsigned>(1, cpu));
+					}
+					topology.nodeCpus.push_back(numa::orderByCore(cpus, siblings));
+				}
+			}
+		}
+		catch (const runtime_error&)
+		{
+			// Unreadable sysfs is treated like none:
+			topology.nodeCpus.clear();
+		}
+
+		// No sysfs, one node of the CPUs in the mask:
+		if (topology.nodeCpus.empty() && haveMask)
+		{
+			vector<unsigned> cpus;
+			for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+			{
+				if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+			}
+			if (!cpus.empty()) topology.nodeCpus.push_back(cpus);
+		}
+#endif
+
+		// Elsewhere, one node of every CPU:
+		if (topology.nodeCpus.empty())
+		{
+			unsigned cpuCount = thread::hardware_concurrency();
+			topology.nodeCpus.push_back(vector<unsigned>());
+			for (unsigned cpu = 0; cpu < ((cpuCount > 0) ? cpuCount : 1); ++cpu) topology.nodeCpus[0].push_back(cpu);
+		}
+
+		// Reverse lookup, CPUs outside nodeCpus are put on node 0:
+		for (unsigned node = 0; node < topology.nodeCpus.size(); ++node)
+		{
+			for (unsigned cpu : topology.nodeCpus[node])
+			{
+				if (cpu >= topology.cpuNodes.size()) topology.cpuNodes.resize(cpu + 1, 0);
+				topology.cpuNodes[cpu] = node;
+			}
+		}
+		return topology;
+	}
+
+} // namespace
+
+
+//
+// Main library namespace:
+//
+namespace numa
+{
+
+	// Parse CPU list:
+	vector<unsigned> parseCpuList(
+		const string& inList
+		)
+	{
+		vector<unsigned> cpus;
+		size_t position = 0;
+
+		// Read a decimal number at position:
+		auto readNumber = [&]() -> unsigned
+		{
+			if ((position >= inList.size()) || !isdigit(static_cast<unsigned char>(inList[position])))
+			{
+				throw runtime_error(string("Error: Invalid CPU list: '") + inList + string("'; aborting."));
+			}
+			unsigned long value = 0;
+			while ((position < inList.size()) && isdigit(static_cast<unsigned char>(inList[position])))
+			{
+				value = value * 10 + static_cast<unsigned long>(inList[position++] - '0');
+				if (value > 1000000)
+				{
+					throw runtime_error(string("Error: Invalid CPU list: '") + inList + string("'; aborting."));
+				}
+			}
+			return static_cast<unsigned>(value);
+		};
+
+		// Ranges separated by commas, an empty list (a node without CPUs) has none:
+		size_t end = inList.find_last_not_of(" \r\n");
+		if (end == string::npos) return cpus;
+		while (position <= end)
+		{
+			unsigned first = readNumber();
+			unsigned last = first;
+			if ((position <= end) && (inList[position] == '-'))
+			{
+				++position;
+				last = readNumber();
+			}
+			if (last < first)
+			{
+				throw runtime_error(string("Error: Invalid CPU list: '") + inList + string("'; aborting."));
+			}
+			for (unsigned cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+
+			if (position > end) break;
+			if ((inList[position] != ',') || (position == end))
+			{
+				throw runtime_error(string("Error: Invalid CPU list: '") + inList + string("'; aborting."));
+			}
+			++position;
+		}
+		return cpus;
+	}
+
+	// Order CPUs by core:
+	vector<unsigned> orderByCore(
+		const vector<unsigned>& inCpus,
+		const vector<vector<unsigned>>& inSiblings
+		)
+	{
+		// Rank of each CPU among the siblings of its core that are in the list:
+		vector<pair<size_t, size_t>> ranks;
+		for (size_t i = 0; i < inCpus.size(); ++i)
+		{
+			size_t rank = 0;
+			for (unsigned sibling : inSiblings[i])
+			{
+				if (sibling == inCpus[i]) break;
+				if (find(inCpus.begin(), inCpus.end(), sibling) != inCpus.end()) ++rank;
+			}
+			ranks.push_back(make_pair(rank, i));
+		}
+		sort(ranks.begin(), ranks.end());
+
+		vector<unsigned> ordered;
+		for (auto& rank : ranks) ordered.push_back(inCpus[rank.second]);
+		return ordered;
+	}
+
+	// Machine topology:
+	//	Note: Function-local statics are initialized exactly once, even with concurrent callers.
+	const Topology& systemTopology()
+	{
+		static const Topology topology = readSystemTopology();
+		return topology;
+	}
+
+	// Node count:
+	unsigned nodeCount()
+	{
+		return static_cast<unsigned>(systemTopology().nodeCpus.size());
+	}
+
+	// Place worker:
+	Placement placeWorker(
+		const Topology& inTopology,
+		unsigned inWorker
+		)
+	{
+		Placement placement;
+		unsigned nodes = static_cast<unsigned>(inTopology.nodeCpus.size());
+		placement.node = inWorker % nodes;
+
+		const vector<unsigned>& cpus = inTopology.nodeCpus[placement.node];
+		placement.cpu = cpus[(inWorker / nodes) % cpus.size()];
+		return placement;
+	}
+
+	// Pin worker:
+	bool pinWorker(
+		unsigned inWorker
+		)
+	{
+#if defined(__linux__)
+		Placement placement = placeWorker(systemTopology(), inWorker);
+		if (placement.cpu >= CPU_SETSIZE) return false;
+
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(placement.cpu, &cpus);
+		if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) return false;
+
+		threadNode = static_cast<int>(placement.node);
+		return true;
+#else
+		(void)inWorker;
+		return false;
+#endif
+	}
+
+	// Current node:
+	unsigned currentNode()
+	{
+		if (threadNode < 0)
+		{
+			unsigned node = 0;
+#if defined(__linux__)
+			const Topology& topology = systemTopology();
+			int cpu = sched_getcpu();
+			if ((cpu >= 0) && (static_cast<size_t>(cpu) < topology.cpuNodes.size())) node = topology.cpuNodes[cpu];
+#endif
+			threadNode = static_cast<int>(node);
+		}
+		return static_cast<unsigned>(threadNode);
+	}
+
+
+	// LargePageBuffer constructor:
+	LargePageBuffer::LargePageBuffer(
+		size_t inBytes
+		) : bufferData(nullptr), bufferSize(inBytes), mappedSize(0), pages(Pages::normal)
+	{
+#if defined(WIN32) || defined(_WIN32)
+		// No mapping here, plain zeroed memory instead:
+		fallbackData.resize((inBytes > 0) ? inBytes : 1);
+		bufferData = &fallbackData[0];
+#else
+		const int protection = PROT_READ | PROT_WRITE;
+		const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+		// Huge pages only pay off for at least one of them:
+		if (inBytes >= hugePageSize)
+		{
+			size_t rounded = (inBytes + hugePageSize - 1) / hugePageSize * hugePageSize;
+
+#if defined(MAP_HUGETLB)
+			// Explicit huge pages, only there if the administrator reserved some:
+			void* hugeMapping = mmap(nullptr, rounded, protection, flags | MAP_HUGETLB, -1, 0);
+			if (hugeMapping != MAP_FAILED)
+			{
+				bufferData = hugeMapping;
+				mappedSize = rounded;
+				pages = Pages::huge;
+				return;
+			}
+#endif
+
+#if defined(MADV_HUGEPAGE)
+			// Transparent huge pages need aligned addresses, map one huge page more and trim both ends:
+			size_t span = rounded + hugePageSize;
+			void* spanMapping = mmap(nullptr, span, protection, flags, -1, 0);
+			if (spanMapping != MAP_FAILED)
+			{
+				char* start = static_cast<char*>(spanMapping);
+				char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(start) + hugePageSize - 1) & ~uintptr_t(hugePageSize - 1));
+				if (aligned > start) munmap(start, aligned - start);
+				munmap(aligned + rounded, (start + span) - (aligned + rounded));
+
+				bufferData = aligned;
+				mappedSize = rounded;
+				pages = (madvise(aligned, rounded, MADV_HUGEPAGE) == 0) ? Pages::transparentHuge : Pages::normal;
+				return;
+			}
+#endif
+		}
+
+		// Plain pages:
+		size_t length = (inBytes > 0) ? inBytes : 1;
+		void* mapping = mmap(nullptr, length, protection, flags, -1, 0);
+		if (mapping == MAP_FAILED)
+		{
+			throw runtime_error(string("Error: Problem(s) occured while allocating ") + to_string(inBytes) + string(" bytes; aborting."));
+		}
+		bufferData = mapping;
+		mappedSize = length;
+#endif
+	}
+
+	// LargePageBuffer destructor:
+	LargePageBuffer::~LargePageBuffer()
+	{
+#if !defined(WIN32) && !defined(_WIN32)
+		if (mappedSize > 0) munmap(bufferData, mappedSize);
+#endif
+	}
+
+} // namespace numa
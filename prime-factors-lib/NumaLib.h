@@ -0,0 +1,172 @@
+///////////////////////////////////////
+///
+///	\file		NumaLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		NumaLib library header
+///
+///	\notes
+///		1. The CPUs this process may run on, grouped by NUMA node. On Linux they come from
+///			/sys/devices/system/node and are limited to the process's affinity mask (taskset, cgroups). Anywhere
+///			else, or without sysfs, every CPU is taken to be on one node.
+///		2. Workers can be pinned to CPUs. Worker i goes to node i % nodes, so a run uses the memory bandwidth
+///			and caches of every socket even with few threads. Within a node the CPUs are ordered by core using
+///			each CPU's topology/thread_siblings_list: the first hardware thread of every core comes before the
+///			second thread of any, so workers only share a core once every core has one.
+///		3. Read-only tables can be replicated per node (see factor_algorithms::SmallestFactorTable). A replica is
+///			built by the first thread that asks for it from that node, and Linux places pages on the node of the
+///			thread that first writes them, so each replica ends up in its own node's memory without libnuma.
+///		4. LargePageBuffer backs large tables with huge pages so lookups scattered over them take fewer TLB
+///			misses: explicit huge pages (MAP_HUGETLB) when the system has some reserved, otherwise memory aligned
+///			for and advised as transparent huge pages (MADV_HUGEPAGE). Where neither exists it is plain memory.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef NUMA_LIB_H
+#define	NUMA_LIB_H
+
+
+//
+// Local includes:
+//
+//...
+
+
+//
+// Compiler includes:
+//
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace numa
+{
+
+	/// CPUs this process may run on, by NUMA node.
+	struct Topology
+	{
+		std::vector<std::vector<unsigned>> nodeCpus;	///< CPUs of each node that has any, nodes numbered from 0 without gaps, see orderByCore()
+		std::vector<unsigned> cpuNodes;				///< Node of each CPU in nodeCpus, indexed by CPU number
+	};
+
+
+	/// Where a worker is pinned.
+	struct Placement
+	{
+		unsigned node;								///< Node, an index into Topology::nodeCpus
+		unsigned cpu;								///< CPU number
+	};
+
+
+	/// Parse a Linux CPU list such as "0-3,8,10-11". Throws on invalid input.
+	std::vector<unsigned> parseCpuList(
+		const std::string& inList					///< List to parse (a trailing newline is allowed)
+		);
+
+
+	/// Order a node's CPUs so every core appears once before any core appears again (first hardware threads,
+	///	then second ones, ...), otherwise keeping their order. Siblings missing from inCpus are not counted.
+	std::vector<unsigned> orderByCore(
+		const std::vector<unsigned>& inCpus,		///< CPUs of one node
+		const std::vector<std::vector<unsigned>>& inSiblings	///< Hardware threads of the core of each CPU in inCpus
+		);
+
+
+	/// Get the topology of this machine (read once).
+	const Topology& systemTopology();
+
+
+	/// Number of nodes in systemTopology(), at least 1.
+	unsigned nodeCount();
+
+
+	/// CPU for worker inWorker: round robin over the nodes, then over the CPUs within each node.
+	Placement placeWorker(
+		const Topology& inTopology,					///< Topology with at least one CPU
+		unsigned inWorker							///< Index of the worker
+		);
+
+
+	/// Pin the calling thread to placeWorker(systemTopology(), inWorker). Returns false where the platform
+	///	does not support pinning or refused it, the thread then runs where the scheduler puts it.
+	bool pinWorker(
+		unsigned inWorker							///< Index of the worker
+		);
+
+
+	/// Node of the calling thread: the node it was pinned to, otherwise the node it ran on when it first asked.
+	unsigned currentNode();
+
+
+	/// RAII zero-filled memory for large tables, backed by huge pages where possible.
+	class LargePageBuffer
+	{
+	public:
+
+		/// How the buffer is backed.
+		enum class Pages
+		{
+			normal,									///< Plain pages
+			transparentHuge,						///< Aligned and advised for transparent huge pages (the kernel may still decline)
+			huge									///< Explicit huge pages
+		};
+
+		/// Default constructor:
+		LargePageBuffer() = delete;
+
+		/// Custom constructor:
+		explicit LargePageBuffer(
+			std::size_t inBytes							///< Bytes needed
+			);
+
+		/// Destructor:
+		~LargePageBuffer();
+
+		/// No copies, the memory is owned:
+		LargePageBuffer(const LargePageBuffer&) = delete;
+		LargePageBuffer& operator=(const LargePageBuffer&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Start of the buffer.
+		void* data() const { return bufferData; }
+
+		/// Bytes asked for (the mapping may be rounded up to whole huge pages).
+		std::size_t size() const { return bufferSize; }
+
+		/// Get how the buffer is backed.
+		Pages getPages() const { return pages; }
+
+	private:
+
+		//
+		// Member variables:
+		//
+		void* bufferData;
+		std::size_t bufferSize;
+		std::size_t mappedSize;						///< 0 unless the buffer is mapped
+		Pages pages;
+		std::vector<char> fallbackData;				///< Memory where mapping is not available
+
+	};
+
+} // namespace numa
+
+#endif // NUMA_LIB_H
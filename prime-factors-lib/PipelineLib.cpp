@@ -0,0 +1,338 @@
+///////////////////////////////////////
+///
+///	\file		PipelineLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for PipelineLib.h
+///
+///	\notes
+///		1. The feeder takes an in-flight slot before reading a unit and collect() gives it back, so the limit
+///			covers units being read, queued, worked on, finished and waiting in the reorder buffer alike.
+///		2. Errors on the feeder or a worker close both queues so every thread winds down, and are rethrown
+///			from the next collect().
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "PipelineLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <algorithm>
+#include <utility>
+
+
+//
+// Namespaces:
+//
+using namespace std;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	// Approximate heap bytes held by a unit's input lines:
+	size_t inputBytes(
+		const pipeline::WorkUnit& unit
+		)
+	{
+		size_t bytes = unit.block.lines.capacity() * sizeof(string);
+		for (auto& line : unit.block.lines) bytes += line.capacity();
+		return bytes;
+	}
+
+} // namespace
+
+
+//
+// Main library namespace:
+//
+namespace pipeline
+{
+
+	// Acquire budget:
+	bool MemoryBudget::acquire(
+		size_t inBytes
+		)
+	{
+		unique_lock<mutex> lock(budgetMutex);
+		roomFree.wait(lock, [&] { return (maxBytes == 0) || (bytesUsed == 0) || (bytesUsed + inBytes <= maxBytes) || cancelled; });
+		if (cancelled) return false;
+
+		bytesUsed += inBytes;
+		peakBytes = max(peakBytes, bytesUsed);
+		return true;
+	}
+
+	// Charge budget:
+	void MemoryBudget::charge(
+		size_t inBytes
+		)
+	{
+		lock_guard<mutex> lock(budgetMutex);
+		bytesUsed += inBytes;
+		peakBytes = max(peakBytes, bytesUsed);
+	}
+
+	// Release budget:
+	void MemoryBudget::release(
+		size_t inBytes
+		)
+	{
+		{
+			lock_guard<mutex> lock(budgetMutex);
+			bytesUsed -= min(inBytes, bytesUsed);
+		}
+		roomFree.notify_all();
+	}
+
+	// Cancel budget:
+	void MemoryBudget::cancel()
+	{
+		{
+			lock_guard<mutex> lock(budgetMutex);
+			cancelled = true;
+		}
+		roomFree.notify_all();
+	}
+
+	// Get bytes used:
+	size_t MemoryBudget::getBytesUsed() const
+	{
+		lock_guard<mutex> lock(budgetMutex);
+		return bytesUsed;
+	}
+
+	// Get peak bytes:
+	size_t MemoryBudget::getPeakBytes() const
+	{
+		lock_guard<mutex> lock(budgetMutex);
+		return peakBytes;
+	}
+
+
+	// Pipeline constructor:
+	//	Note: Four units per worker keeps every worker busy while the next units are read and the last ones written.
+	Pipeline::Pipeline(
+		unsigned inThreadCount,
+		bool inOrdered,
+		const Source& inSource,
+		const Work& inWork,
+		MemoryBudget* inMemoryBudget,
+		const WorkerStart& inWorkerStart
+		) : ordered(inOrdered), maxInFlight(4 * size_t(inThreadCount > 0 ? inThreadCount : 1)), source(inSource), work(inWork),
+			memoryBudget(inMemoryBudget), workerStart(inWorkerStart),
+			pendingUnits(maxInFlight), finishedUnits(maxInFlight), nextSequence(0),
+			inFlight(0), runningWorkers(inThreadCount > 0 ? inThreadCount : 1), stopping(false)
+	{
+		// Threads that did start must be joined if a later one cannot be:
+		try
+		{
+			for (unsigned worker = 0; worker < runningWorkers; ++worker)
+			{
+				workerThreads.push_back(thread(&Pipeline::workLoop, this, worker));
+			}
+			feederThread = thread(&Pipeline::feedLoop, this);
+		}
+		catch (...)
+		{
+			stop();
+			throw;
+		}
+	}
+
+	// Pipeline destructor:
+	Pipeline::~Pipeline()
+	{
+		stop();
+	}
+
+	// Collect next unit:
+	bool Pipeline::collect(
+		WorkUnit& outUnit
+		)
+	{
+		while (true)
+		{
+			{
+				lock_guard<mutex> lock(stateMutex);
+				if (firstError) rethrow_exception(firstError);
+			}
+
+			// The next unit in line may already be waiting:
+			if (ordered)
+			{
+				auto waiting = reorderBuffer.find(nextSequence);
+				if (waiting != reorderBuffer.end())
+				{
+					outUnit = move(waiting->second);
+					reorderBuffer.erase(waiting);
+					++nextSequence;
+					break;
+				}
+			}
+
+			WorkUnit unit;
+			if (!finishedUnits.pop(unit))
+			{
+				lock_guard<mutex> lock(stateMutex);
+				if (firstError) rethrow_exception(firstError);
+				return false;
+			}
+
+			if (!ordered)
+			{
+				outUnit = move(unit);
+				break;
+			}
+			uint64_t sequence = unit.sequence;
+			reorderBuffer.insert(make_pair(sequence, move(unit)));
+		}
+
+		// Unit leaves the pipeline, its slot can be fed again:
+		{
+			lock_guard<mutex> lock(stateMutex);
+			--inFlight;
+		}
+		slotFree.notify_one();
+
+		return true;
+	}
+
+	// Feeder thread:
+	void Pipeline::feedLoop()
+	{
+		try
+		{
+			uint64_t sequence = 0;
+			uint64_t nextLineNumber = 1;
+			while (true)
+			{
+				// Wait for a free slot:
+				{
+					unique_lock<mutex> lock(stateMutex);
+					slotFree.wait(lock, [this] { return (inFlight < maxInFlight) || stopping; });
+					if (stopping) break;
+					++inFlight;
+				}
+
+				WorkUnit unit;
+				if (!source(unit.block))
+				{
+					lock_guard<mutex> lock(stateMutex);
+					--inFlight;
+					break;
+				}
+
+				unit.sequence = sequence++;
+				unit.firstLineNumber = nextLineNumber;
+				nextLineNumber += unit.block.lines.size();
+
+				// Wait for room before the unit joins the queues, this is what holds a fast reader back:
+				unit.chargedBytes = 0;
+				if (memoryBudget != nullptr)
+				{
+					unit.chargedBytes = inputBytes(unit);
+					if (!memoryBudget->acquire(unit.chargedBytes)) break;
+				}
+
+				if (!pendingUnits.push(unit))
+				{
+					if (memoryBudget != nullptr) memoryBudget->release(unit.chargedBytes);
+					break;
+				}
+			}
+		}
+		catch (...)
+		{
+			fail(current_exception());
+		}
+
+		// No more units, workers finish what is queued:
+		pendingUnits.close();
+	}
+
+	// Worker thread:
+	void Pipeline::workLoop(
+		unsigned inWorker
+		)
+	{
+		try
+		{
+			if (workerStart) workerStart(inWorker);
+
+			WorkUnit unit;
+			while (pendingUnits.pop(unit))
+			{
+				work(inWorker, unit);
+
+				// Output is charged without waiting, a worker stuck here could never free anything:
+				if (memoryBudget != nullptr)
+				{
+					memoryBudget->charge(unit.output.capacity());
+					unit.chargedBytes += unit.output.capacity();
+				}
+
+				if (!finishedUnits.push(unit)) break;
+			}
+		}
+		catch (...)
+		{
+			fail(current_exception());
+		}
+
+		// The last worker out tells collect() nothing else is coming:
+		bool lastWorker = false;
+		{
+			lock_guard<mutex> lock(stateMutex);
+			lastWorker = (--runningWorkers == 0);
+		}
+		if (lastWorker) finishedUnits.close();
+	}
+
+	// Fail:
+	void Pipeline::fail(
+		exception_ptr inError
+		)
+	{
+		{
+			lock_guard<mutex> lock(stateMutex);
+			if (!firstError) firstError = inError;
+			stopping = true;
+		}
+		slotFree.notify_all();
+		if (memoryBudget != nullptr) memoryBudget->cancel();
+
+		pendingUnits.close();
+		finishedUnits.close();
+	}
+
+	// Stop:
+	void Pipeline::stop()
+	{
+		{
+			lock_guard<mutex> lock(stateMutex);
+			stopping = true;
+		}
+		slotFree.notify_all();
+		if (memoryBudget != nullptr) memoryBudget->cancel();
+
+		pendingUnits.close();
+		finishedUnits.close();
+
+		if (feederThread.joinable()) feederThread.join();
+		for (auto& worker : workerThreads)
+		{
+			if (worker.joinable()) worker.join();
+		}
+	}
+
+} // namespace pipeline
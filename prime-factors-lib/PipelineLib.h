@@ -0,0 +1,307 @@
+///////////////////////////////////////
+///
+///	\file		PipelineLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		PipelineLib library header
+///
+///	\notes
+///		1. Spreads the work of the main loop over worker threads. A feeder thread pulls blocks of lines from a
+///			source (normally async_io::BlockReader) and tags each one with its position and first line number, the
+///			workers turn them into output, and the calling thread collects the finished units.
+///		2. In ordered mode collect() hands units back in input order, holding early finishers in a reorder
+///			buffer. In unordered mode they come back as soon as a worker is done, so one slow unit does not hold
+///			up the ones behind it.
+///		3. At most a fixed number of units are in flight (fed but not yet collected). This bounds the queues
+///			and the reorder buffer, and stalls the feeder instead of reading ahead without limit.
+///		4. Optionally the units are also charged in bytes to a MemoryBudget: the feeder waits for room before
+///			queueing a unit, the workers add what their output costs, and the caller releases the charge once
+///			the unit is written. Only the feeder ever waits, so a full budget slows the input down but can
+///			never deadlock the stages that free memory.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef PIPELINE_LIB_H
+#define	PIPELINE_LIB_H
+
+
+//
+// Local includes:
+//
+#include "AsyncIOLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace pipeline
+{
+
+	/// Consecutive input lines handed to one worker, and the output it produced for them.
+	struct WorkUnit
+	{
+		uint64_t sequence;							///< Position of the unit in the input, 0 for the first
+		uint64_t firstLineNumber;					///< 1-based input line number of the first line
+		async_io::LineBlock block;					///< Input lines
+		std::string output;							///< Output for the whole unit, filled by the worker
+		std::size_t chargedBytes;					///< Bytes charged to the pipeline's MemoryBudget for this unit
+	};
+
+
+	/// Byte budget shared by the stages of a pipeline. Producers wait for room, consumers give it back.
+	class MemoryBudget
+	{
+	public:
+
+		/// Default constructor:
+		MemoryBudget() = delete;
+
+		/// Custom constructor:
+		explicit MemoryBudget(
+			std::size_t inMaxBytes						///< Limit, 0 for none
+			) : maxBytes(inMaxBytes), bytesUsed(0), peakBytes(0), cancelled(false) {}
+
+
+		//
+		// Member functions:
+		//
+
+		/// Take inBytes, waiting while that would go over the limit. Returns false once cancelled.
+		///	Note: A request is always granted when nothing is held, so one item larger than the limit still passes.
+		bool acquire(
+			std::size_t inBytes							///< Bytes to take
+			);
+
+		/// Take inBytes without waiting, for stages that must not block (may go over the limit).
+		void charge(
+			std::size_t inBytes							///< Bytes to take
+			);
+
+		/// Give back bytes taken earlier.
+		void release(
+			std::size_t inBytes							///< Bytes to give back
+			);
+
+		/// Wake every waiting acquire() and make later ones fail.
+		void cancel();
+
+		/// Get bytes currently held.
+		std::size_t getBytesUsed() const;
+
+		/// Get the most bytes ever held at once.
+		std::size_t getPeakBytes() const;
+
+	private:
+
+		//
+		// Member variables:
+		//
+		const std::size_t maxBytes;
+		mutable std::mutex budgetMutex;
+		std::condition_variable roomFree;
+		std::size_t bytesUsed;
+		std::size_t peakBytes;
+		bool cancelled;
+
+	};
+
+
+	/// Blocking FIFO with a fixed capacity, for any number of producer and consumer threads.
+	template <typename T>
+	class BoundedQueue
+	{
+	public:
+
+		/// Default constructor:
+		BoundedQueue() = delete;
+
+		/// Custom constructor:
+		explicit BoundedQueue(
+			std::size_t inCapacity						///< Most items held at once (at least 1)
+			) : capacity(inCapacity > 0 ? inCapacity : 1), closed(false) {}
+
+
+		//
+		// Member functions:
+		//
+
+		/// Append an item, waiting while the queue is full. Returns false (item untouched) once closed.
+		bool push(
+			T& ioItem									///< Item to move in
+			)
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			notFull.wait(lock, [this] { return (items.size() < capacity) || closed; });
+			if (closed) return false;
+
+			items.push_back(std::move(ioItem));
+			lock.unlock();
+			notEmpty.notify_one();
+			return true;
+		}
+
+		/// Take the oldest item, waiting while the queue is empty. Returns false once closed and drained.
+		bool pop(
+			T& outItem									///< Item moved out
+			)
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+			if (items.empty()) return false;
+
+			outItem = std::move(items.front());
+			items.pop_front();
+			lock.unlock();
+			notFull.notify_one();
+			return true;
+		}
+
+		/// Refuse further pushes and wake every waiting thread. Items already queued can still be popped.
+		void close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				closed = true;
+			}
+			notFull.notify_all();
+			notEmpty.notify_all();
+		}
+
+	private:
+
+		//
+		// Member variables:
+		//
+		const std::size_t capacity;
+		std::mutex queueMutex;
+		std::condition_variable notFull;
+		std::condition_variable notEmpty;
+		std::deque<T> items;
+		bool closed;
+
+	};
+
+
+	/// RAII feeder, worker pool and collector for WorkUnits.
+	class Pipeline
+	{
+	public:
+
+		/// Fills the block of the next unit, returns false once the input is exhausted. Runs on the feeder thread.
+		typedef std::function<bool(async_io::LineBlock&)> Source;
+
+		/// Turns a unit's lines into its output. Runs on worker inWorker (0 .. thread count - 1).
+		typedef std::function<void(unsigned inWorker, WorkUnit&)> Work;
+
+		/// Prepares worker inWorker (pinning it to a CPU, say). Runs once on the worker before its first unit.
+		typedef std::function<void(unsigned inWorker)> WorkerStart;
+
+		/// Default constructor:
+		Pipeline() = delete;
+
+		/// Custom constructor, starts the feeder and the workers:
+		Pipeline(
+			unsigned inThreadCount,						///< Worker threads (at least 1)
+			bool inOrdered,								///< Collect units in input order
+			const Source& inSource,						///< Where units come from
+			const Work& inWork,							///< What the workers do to each unit
+			MemoryBudget* inMemoryBudget = nullptr,		///< Budget units are charged to (caller releases chargedBytes), none if null
+			const WorkerStart& inWorkerStart = WorkerStart()	///< What each worker does first, nothing if empty
+			);
+
+		/// Destructor (stops and joins every thread, units still in flight are dropped):
+		~Pipeline();
+
+		/// No copies, the threads hold a pointer to this object:
+		Pipeline(const Pipeline&) = delete;
+		Pipeline& operator=(const Pipeline&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Get the next finished unit. Returns false once every unit was collected, rethrows feeder and worker errors.
+		bool collect(
+			WorkUnit& outUnit							///< Finished unit
+			);
+
+	private:
+
+		//
+		// Member variables:
+		//
+		const bool ordered;
+		const std::size_t maxInFlight;
+		Source source;
+		Work work;
+		MemoryBudget* memoryBudget;
+		WorkerStart workerStart;
+
+		BoundedQueue<WorkUnit> pendingUnits;		///< Fed, waiting for a worker
+		BoundedQueue<WorkUnit> finishedUnits;		///< Done, waiting for collect()
+		std::map<uint64_t, WorkUnit> reorderBuffer;	///< Finished ahead of their turn (ordered mode)
+		uint64_t nextSequence;						///< Next unit collect() hands out in ordered mode
+
+		std::mutex stateMutex;
+		std::condition_variable slotFree;
+		std::size_t inFlight;
+		unsigned runningWorkers;
+		bool stopping;
+		std::exception_ptr firstError;
+
+		std::thread feederThread;
+		std::vector<std::thread> workerThreads;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Feeder thread body:
+		void feedLoop();
+
+		/// Worker thread body:
+		void workLoop(
+			unsigned inWorker							///< Index of this worker
+			);
+
+		/// Record the first error and shut the queues so every thread winds down:
+		void fail(
+			std::exception_ptr inError					///< Error to report from collect()
+			);
+
+		/// Close the queues and join every thread.
+		void stop();
+
+	};
+
+} // namespace pipeline
+
+#endif // PIPELINE_LIB_H
@@ -0,0 +1,264 @@
+///////////////////////////////////////
+///
+///	\file		ProgressLib.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		Implementation for ProgressLib.h
+///
+///	\notes
+///		1. The reporter wakes every 100ms to check for requests from the signal handler, which cannot notify a
+///			condition variable. Periodic reports and stop() wake it right away.
+///		2. The stats file is opened for every report, so it can be truncated or rotated while the run goes on.
+///
+///////////////////////////////////////
+
+
+//
+// Local includes:
+//
+#include "ProgressLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#if !defined(WIN32) && !defined(_WIN32)
+#include <signal.h>
+#endif
+
+
+//
+// Namespaces:
+//
+using namespace std;
+
+
+//
+// Helpers local to this file:
+//
+namespace
+{
+
+	// Set by the SIGUSR1 handler, taken by the reporter:
+	volatile sig_atomic_t signalReportRequested = 0;
+
+	// How often the reporter looks at signalReportRequested:
+	const chrono::milliseconds signalPollInterval(100);
+
+#if !defined(WIN32) && !defined(_WIN32)
+	// SIGUSR1 handler, only async-signal-safe work here:
+	extern "C" void onReportSignal(
+		int
+		)
+	{
+		signalReportRequested = 1;
+	}
+#endif
+
+	// Format seconds as H:MM:SS:
+	string formatDuration(
+		double inSeconds
+		)
+	{
+		uint64_t seconds = static_cast<uint64_t>(inSeconds + 0.5);
+
+		ostringstream text;
+		text << seconds / 3600 << ':';
+		text << char('0' + (seconds / 600) % 6) << char('0' + (seconds / 60) % 10) << ':';
+		text << char('0' + (seconds % 60) / 10) << char('0' + seconds % 10);
+		return text.str();
+	}
+
+} // namespace
+
+
+//
+// Main library namespace:
+//
+namespace progress
+{
+
+	// Format progress report:
+	string formatProgress(
+		const ProgressSample& inLast,
+		const ProgressSample& inNow,
+		uint64_t inTotalBytes,
+		const ProgressSample& inStart
+		)
+	{
+		// Current rate over the time since the last report, average over this run:
+		double sinceLast = inNow.seconds - inLast.seconds;
+		double currentRate = ((sinceLast > 0) && (inNow.lines >= inLast.lines)) ? double(inNow.lines - inLast.lines) / sinceLast : 0;
+		double averageRate = ((inNow.seconds > 0) && (inNow.lines >= inStart.lines)) ? double(inNow.lines - inStart.lines) / inNow.seconds : 0;
+
+		ostringstream text;
+		text << "progress: " << inNow.lines << " lines, ";
+
+		if (inTotalBytes > 0)
+		{
+			uint64_t bytes = inNow.bytes;
+			text.setf(ios::fixed);
+			text.precision(1);
+			text << 100.0 * double(bytes) / double(inTotalBytes) << "% of " << inTotalBytes << " bytes, ";
+			text.precision(0);
+			text << currentRate << " lines/s now, " << averageRate << " lines/s average, ";
+
+			// Time left at the average byte rate of this run:
+			if ((bytes > inStart.bytes) && (inNow.seconds > 0))
+			{
+				text << formatDuration(double(inTotalBytes - bytes) * inNow.seconds / double(bytes - inStart.bytes)) << " left";
+			}
+			else
+			{
+				text << "time left unknown";
+			}
+		}
+		else
+		{
+			text.setf(ios::fixed);
+			text.precision(0);
+			text << inNow.bytes << " bytes, " << currentRate << " lines/s now, " << averageRate << " lines/s average";
+		}
+
+		return text.str();
+	}
+
+	// Install report signal:
+	void installReportSignal()
+	{
+#if !defined(WIN32) && !defined(_WIN32)
+		// SA_RESTART so the I/O threads do not see EINTR from reads and writes:
+		struct sigaction action;
+		action.sa_handler = onReportSignal;
+		sigemptyset(&action.sa_mask);
+		action.sa_flags = SA_RESTART;
+		sigaction(SIGUSR1, &action, nullptr);
+#endif
+	}
+
+
+	// ProgressReporter constructor:
+	ProgressReporter::ProgressReporter(
+		const ProgressCounters& inCounters,
+		uint64_t inTotalBytes,
+		chrono::milliseconds inInterval,
+		const string& inStatsFileName
+		) : counters(inCounters), totalBytes(inTotalBytes), interval(inInterval), statsFileName(inStatsFileName),
+			startTime(chrono::steady_clock::now()), reportRequested(false), stopping(false)
+	{
+		// Rates count from here, a resumed run has its earlier work in the counters already:
+		startSample.lines = counters.getLines();
+		startSample.bytes = counters.getBytes();
+		startSample.seconds = 0;
+		lastSample = startSample;
+
+		// Fail now rather than lose every report later:
+		if (!statsFileName.empty())
+		{
+			ofstream statsFile(statsFileName, ios::app);
+			if (!statsFile.is_open())
+			{
+				throw runtime_error(string("Error: Problem(s) occured while trying to open the stats file: '") + statsFileName + string("'; aborting."));
+			}
+		}
+
+		reportThread = thread(&ProgressReporter::reportLoop, this);
+	}
+
+	// ProgressReporter destructor:
+	ProgressReporter::~ProgressReporter()
+	{
+		stop();
+	}
+
+	// Request report:
+	void ProgressReporter::requestReport()
+	{
+		{
+			lock_guard<mutex> lock(reportMutex);
+			reportRequested = true;
+		}
+		reportCondition.notify_all();
+	}
+
+	// Stop:
+	void ProgressReporter::stop()
+	{
+		{
+			lock_guard<mutex> lock(reportMutex);
+			stopping = true;
+		}
+		reportCondition.notify_all();
+
+		if (reportThread.joinable()) reportThread.join();
+	}
+
+	// Reporter thread:
+	void ProgressReporter::reportLoop()
+	{
+		auto nextReport = startTime + interval;
+		while (true)
+		{
+			bool due = false;
+			{
+				unique_lock<mutex> lock(reportMutex);
+				auto wakeTime = chrono::steady_clock::now() + signalPollInterval;
+				if ((interval.count() > 0) && (nextReport < wakeTime)) wakeTime = nextReport;
+				reportCondition.wait_until(lock, wakeTime, [this] { return reportRequested || stopping; });
+
+				if (stopping) break;
+				due = reportRequested;
+				reportRequested = false;
+			}
+
+			if (signalReportRequested != 0)
+			{
+				signalReportRequested = 0;
+				due = true;
+			}
+
+			// Periodic reports keep their schedule, a slow report does not make them drift:
+			auto now = chrono::steady_clock::now();
+			if ((interval.count() > 0) && (now >= nextReport))
+			{
+				due = true;
+				while (nextReport <= now) nextReport += interval;
+			}
+
+			if (due) report();
+		}
+
+		// Periodic reports end with the final count:
+		if (interval.count() > 0) report();
+	}
+
+	// Report:
+	void ProgressReporter::report()
+	{
+		ProgressSample sample;
+		sample.lines = counters.getLines();
+		sample.bytes = counters.getBytes();
+		sample.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+		string line = formatProgress(lastSample, sample, totalBytes, startSample);
+		lastSample = sample;
+
+		// Reports are best effort, a full disk must not stop the run:
+		if (statsFileName.empty())
+		{
+			cerr << line << endl;
+		}
+		else
+		{
+			ofstream statsFile(statsFileName, ios::app);
+			statsFile << line << '\n';
+		}
+	}
+
+} // namespace progress
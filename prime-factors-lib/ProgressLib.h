@@ -0,0 +1,189 @@
+///////////////////////////////////////
+///
+///	\file		ProgressLib.h
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		ProgressLib library header
+///
+///	\notes
+///		1. Progress of long runs: the main loop adds the lines and input bytes it finished to ProgressCounters,
+///			and a ProgressReporter thread turns them into a one-line report (lines done, share of the input file,
+///			current and average lines per second, time left) at a fixed interval and whenever one is asked for.
+///		2. The counters are relaxed atomics updated once per block of lines, so the loop never waits on the
+///			reporter and pays nothing measurable. Reports only need a consistent-enough view, not an exact one.
+///		3. On POSIX systems SIGUSR1 asks for a report (see installReportSignal()). The handler only sets a flag,
+///			the reporter polls it, so all formatting and I/O happens outside of the signal handler.
+///
+///////////////////////////////////////
+
+
+//
+// Include guards:
+//
+#ifndef PROGRESS_LIB_H
+#define	PROGRESS_LIB_H
+
+
+//
+// Local includes:
+//
+//...
+
+
+//
+// Compiler includes:
+//
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+
+//
+// Namespaces:
+//
+//...
+
+
+//
+// Main library namespace:
+//
+namespace progress
+{
+
+	/// Work finished so far, shared by the main loop (writer) and the reporter (reader).
+	class ProgressCounters
+	{
+	public:
+
+		/// Default constructor:
+		ProgressCounters() : lines(0), bytes(0) {}
+
+
+		//
+		// Member functions:
+		//
+
+		/// Add finished lines and the input bytes they came from.
+		void add(
+			uint64_t inLines,							///< Lines finished
+			uint64_t inBytes							///< Input bytes of those lines
+			)
+		{
+			lines.fetch_add(inLines, std::memory_order_relaxed);
+			bytes.fetch_add(inBytes, std::memory_order_relaxed);
+		}
+
+		/// Get lines finished.
+		uint64_t getLines() const { return lines.load(std::memory_order_relaxed); }
+
+		/// Get input bytes finished.
+		uint64_t getBytes() const { return bytes.load(std::memory_order_relaxed); }
+
+	private:
+
+		//
+		// Member variables:
+		//
+		std::atomic<uint64_t> lines;
+		std::atomic<uint64_t> bytes;
+
+	};
+
+
+	/// Counters read at some point of the run.
+	struct ProgressSample
+	{
+		uint64_t lines;								///< Lines finished
+		uint64_t bytes;								///< Input bytes finished
+		double seconds;								///< Seconds since the run started
+	};
+
+
+	/// Format a report line (no newline) for inNow, with the current rate measured since inLast and the average
+	///	rate and time left measured since inStart.
+	///	Note: inTotalBytes of 0 means the input size is unknown, the share and time left are then left out.
+	std::string formatProgress(
+		const ProgressSample& inLast,				///< Sample of the previous report (inStart for the first)
+		const ProgressSample& inNow,				///< Sample to report
+		uint64_t inTotalBytes,						///< Size of the input
+		const ProgressSample& inStart = ProgressSample()	///< Counters when the run started (done before a resume), at 0 seconds
+		);
+
+
+	/// Make SIGUSR1 ask the running ProgressReporter for a report. Does nothing where there is no SIGUSR1.
+	void installReportSignal();
+
+
+	/// RAII thread that writes progress reports to stderr or appends them to a stats file.
+	class ProgressReporter
+	{
+	public:
+
+		/// Default constructor:
+		ProgressReporter() = delete;
+
+		/// Custom constructor, starts the reporter thread. Work already in inCounters (a resumed run) counts
+		///	towards the share of the input but not towards the rates.
+		ProgressReporter(
+			const ProgressCounters& inCounters,			///< Counters to report, must outlive the reporter
+			uint64_t inTotalBytes,						///< Size of the input, 0 if unknown
+			std::chrono::milliseconds inInterval,		///< Time between reports, 0 for on request only
+			const std::string& inStatsFileName = ""		///< File to append reports to, stderr if empty
+			);
+
+		/// Destructor (stops the thread, see stop()):
+		~ProgressReporter();
+
+		/// No copies, the thread holds a pointer to this object:
+		ProgressReporter(const ProgressReporter&) = delete;
+		ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Ask for a report as soon as possible.
+		void requestReport();
+
+		/// Stop the thread, writing a last report if reports are periodic.
+		void stop();
+
+	private:
+
+		//
+		// Member variables:
+		//
+		const ProgressCounters& counters;
+		const uint64_t totalBytes;
+		const std::chrono::milliseconds interval;
+		const std::string statsFileName;
+		const std::chrono::steady_clock::time_point startTime;
+		ProgressSample startSample;
+		ProgressSample lastSample;
+		std::mutex reportMutex;
+		std::condition_variable reportCondition;
+		bool reportRequested;
+		bool stopping;
+		std::thread reportThread;
+
+
+		//
+		// Member functions:
+		//
+
+		/// Reporter thread body:
+		void reportLoop();
+
+		/// Sample the counters and write one report.
+		void report();
+
+	};
+
+} // namespace progress
+
+#endif // PROGRESS_LIB_H
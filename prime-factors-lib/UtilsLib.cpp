@@ -6,7 +6,7 @@
 ///	\brief		Implementation for UtilLib.h
 ///
 ///	\notes
-///		1. Prime factors routine modified from: http://www.geeksforgeeks.org/print-all-prime-factors-of-a-given-number/
+///		1. Prime factors are calculated by factor_dispatch::Dispatcher, see FactorDispatchLib.h.
 ///
 ///////////////////////////////////////
 
@@ -15,12 +15,24 @@
 // Local includes:
 //
 #include "UtilsLib.h"
+#include "FactorDispatchLib.h"
 
 
 //
 // Compiler includes:
 //
-#include <cmath>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+
+#if defined(WIN32) || defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
 
 
 //
@@ -52,70 +64,120 @@ namespace utils
 		const string& inStr
 		)
 	{
-		// Save current state of errno since it could have already been set:
-		auto saved_errno = errno;
+		return convertStrToLL(inStr.data(), inStr.size());
+	}
 
-		// Our return tuple is made up of two items, if the conversion failed and the converted value:
-		bool conversionFailed = false;
-		int64_t convertedNumber = 0;
+	// Convert characters to int64_t:
+	//	Note: Parses like strtoll() in base 10 (leading white space, an optional sign, then digits up to the first
+	//		   other character), which needs a null-terminated string, so lines in place cannot use it.
+	std::tuple<bool, int64_t> convertStrToLL(
+		const char* inFirst,
+		size_t inLength
+		)
+	{
+		const char* position = inFirst;
+		const char* end = inFirst + inLength;
 
-		// Convert string to int64_t (using base10):
-		convertedNumber = strtoll(inStr.c_str(), nullptr, 10);
+		// Skip white space, then the sign:
+		while ((position != end) && isspace(static_cast<unsigned char>(*position))) ++position;
+		bool negative = false;
+		if ((position != end) && ((*position == '+') || (*position == '-')))
+		{
+			negative = (*position == '-');
+			++position;
+		}
 
-		// If the above conversion is outside of the range for an int64_t, then errno will be set to ERANGE so we skip it.
-		//	Also, since there is not a good way to tell the difference between a failed conversion and converting
-		//	the number string "0" (or any variant of that string that reduces to "0"), we assume that a return 
-		//	convertedNumber == 0 means the conversion failed.
-		if ((errno == ERANGE) || (convertedNumber == 0)) conversionFailed = true;
+		// Digits, the magnitude of a negative number may be one more than the largest positive one:
+		const uint64_t limit = uint64_t(numeric_limits<int64_t>::max()) + (negative ? 1 : 0);
+		uint64_t magnitude = 0;
+		bool outOfRange = false;
+		for (; (position != end) && (*position >= '0') && (*position <= '9'); ++position)
+		{
+			uint64_t digit = static_cast<uint64_t>(*position - '0');
+			if (magnitude > (limit - digit) / 10) outOfRange = true;
+			else magnitude = magnitude * 10 + digit;
+		}
 
-		// Restore errno state to what it was before we started messing with it:
-		errno = saved_errno;
+		// Out of range numbers are skipped. Also, since there is not a good way to tell the difference between a
+		//	failed conversion and converting the number string "0" (or any variant of that string that reduces to
+		//	"0"), we assume that a convertedNumber == 0 means the conversion failed:
+		if (outOfRange) return make_tuple(true, negative ? numeric_limits<int64_t>::min() : numeric_limits<int64_t>::max());
+		int64_t convertedNumber = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+		return make_tuple(convertedNumber == 0, convertedNumber);
+	}
 
-		// Return tuple of needed values:
-		return make_tuple(conversionFailed, convertedNumber);
+
+	// Truncate file:
+	void truncateFile(
+		const string& inFileName,
+		uint64_t inSize
+		)
+	{
+#if defined(WIN32) || defined(_WIN32)
+		int fd = -1;
+		bool failed = (_sopen_s(&fd, inFileName.c_str(), _O_RDWR | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0)
+			|| (_chsize_s(fd, static_cast<__int64>(inSize)) != 0);
+		if (fd != -1) _close(fd);
+#else
+		bool failed = (truncate(inFileName.c_str(), static_cast<off_t>(inSize)) != 0);
+#endif
+		if (failed)
+		{
+			throw runtime_error(string("Error: Problem(s) occured while truncating the file: '") + inFileName + string("'; aborting."));
+		}
+	}
+
+
+	//
+	// Estimate table entry size:
+	//
+	size_t factorEntryBytes(
+		const FactorResult& inResult,
+		size_t inEntryBytes
+		)
+	{
+		const size_t nodeOverhead = 4 * sizeof(void*);
+		return sizeof(uint64_t) + nodeOverhead + inResult.primeFactors.size() * sizeof(uint64_t) + inEntryBytes;
 	}
 
 
 	//
 	// Calculate prime factors:
-	//	Note: Modified solution from http://www.geeksforgeeks.org/print-all-prime-factors-of-a-given-number/
 	//
 	vector<uint64_t> calculatePrimeFactors(
 		uint64_t numberToFactor
 		)
 	{
-		// Vector to hold our prime factors in:
-		vector<uint64_t> primeFactors;
+		// An unlimited budget always runs to completion so only the factors are interesting:
+		return calculatePrimeFactors(numberToFactor, FactorBudget()).primeFactors;
+	}
 
-		// Save the number of 2s that divide n:
-		while ((numberToFactor % 2) == 0)
-		{
-			primeFactors.push_back(2);
-			numberToFactor /= 2;
-		}
 
-		// n must be odd at this point. So we can skip one element per iteration, going no further than
-		//	sqrt(numberToFactor) since going further would lead to a number bigger than numberToFactor
-		//	when squared.
-		for (uint64_t i = 3; i <= sqrt(numberToFactor); i = i + 2)
-		{
-			// While i divides n, save i and divide n:
-			while ((numberToFactor % i) == 0)
-			{
-				primeFactors.push_back(i);
-				numberToFactor /= i;
-			}
-		}
+	//
+	// Calculate prime factors within a budget:
+	//
+	FactorResult calculatePrimeFactors(
+		uint64_t numberToFactor,
+		const FactorBudget& budget
+		)
+	{
+		// The dispatcher picks the method, a shared one with default thresholds is enough here:
+		static const factor_dispatch::Dispatcher dispatcher;
+		return dispatcher.factor(numberToFactor, budget);
+	}
 
-		// This condition is to handle the case whien n is a prime number greater than 2:
-		if (numberToFactor > 2)
-		{
-			primeFactors.push_back(numberToFactor);
-		}
 
-		// Give ownership of primeFactors vector back to calling scope:
-		//	Note: Modern compilers use RVO so no copy of this vector should happen.
-		return primeFactors;
+	//
+	// Calculate prime factors within a budget, counting the work:
+	//
+	FactorResult calculatePrimeFactors(
+		uint64_t numberToFactor,
+		const FactorBudget& budget,
+		FactorCounters& counters
+		)
+	{
+		static const factor_dispatch::Dispatcher dispatcher;
+		return dispatcher.factor(numberToFactor, budget, counters);
 	}
 
 } // namespace utils
\ No newline at end of file
@@ -27,6 +27,7 @@
 //
 // Compiler includes:
 //
+#include <cstddef>
 #include <stdint.h>
 #include <string>
 #include <tuple>
@@ -56,12 +57,122 @@ namespace utils
 		const std::string& inStr					///< String to convert to int64_t
 		);
 
+	/// Convert characters that need not be null-terminated to int64_t, exactly like the string overload.
+	std::tuple<bool, int64_t> convertStrToLL(
+		const char* inFirst,						///< First character
+		std::size_t inLength						///< Number of characters
+		);
+
+
+	/// Set the size of a file, cutting off (or zero-filling up to) inSize bytes. Throws if that fails.
+	void truncateFile(
+		const std::string& inFileName,				///< File to resize
+		uint64_t inSize								///< New size in bytes
+		);
+
+
+	/// Limits on the work spent factoring a single number. A limit of 0 means unlimited.
+	struct FactorBudget
+	{
+		uint64_t maxIterations;						///< Maximum number of trial divisions and rho steps
+		uint64_t maxMilliseconds;					///< Maximum wall-clock time in milliseconds
+
+		/// Custom constructor (defaults to an unlimited budget):
+		explicit FactorBudget(
+			uint64_t inMaxIterations = 0,			///< Maximum number of trial divisions and rho steps, 0 for unlimited
+			uint64_t inMaxMilliseconds = 0			///< Maximum wall-clock milliseconds, 0 for unlimited
+			) : maxIterations(inMaxIterations), maxMilliseconds(inMaxMilliseconds) {}
+
+		/// True if neither limit is set.
+		bool isUnlimited() const { return (maxIterations == 0) && (maxMilliseconds == 0); }
+	};
+
+
+	/// Counter policy of the factoring algorithms that counts nothing. Its hooks are empty and inline, so code
+	///	instantiated with it is the same as code without any hooks.
+	struct NoCounters
+	{
+		void countTrialDivisions(uint64_t) {}
+		void countRhoSteps(uint64_t) {}
+		void countGcds(uint64_t) {}
+		void countMillerRabinRounds(uint64_t) {}
+	};
+
+
+	/// Counter policy of the factoring algorithms that adds up the work they did, for tuning.
+	struct FactorCounters
+	{
+		uint64_t trialDivisions;					///< Trial divisors tried
+		uint64_t rhoSteps;							///< Pollard-Brent rho iterations
+		uint64_t gcds;								///< Gcds taken by rho
+		uint64_t millerRabinRounds;					///< Miller-Rabin bases tried
+
+		/// Default constructor (all zero):
+		FactorCounters() : trialDivisions(0), rhoSteps(0), gcds(0), millerRabinRounds(0) {}
+
+		void countTrialDivisions(uint64_t inCount) { trialDivisions += inCount; }
+		void countRhoSteps(uint64_t inCount) { rhoSteps += inCount; }
+		void countGcds(uint64_t inCount) { gcds += inCount; }
+		void countMillerRabinRounds(uint64_t inCount) { millerRabinRounds += inCount; }
+
+		/// Add the counts of another call or thread.
+		FactorCounters& operator+=(const FactorCounters& inOther)
+		{
+			trialDivisions += inOther.trialDivisions;
+			rhoSteps += inOther.rhoSteps;
+			gcds += inOther.gcds;
+			millerRabinRounds += inOther.millerRabinRounds;
+			return *this;
+		}
+	};
+
+
+	/// What is known about the cofactor left over by a factorization.
+	enum class FactorStatus
+	{
+		complete,									///< Fully factored, cofactor is 1
+		compositeUnfactored							///< Budget ran out, cofactor is known to be composite
+	};
+
+
+	/// Result of a factorization that may have been cut short by a FactorBudget.
+	struct FactorResult
+	{
+		std::vector<uint64_t> primeFactors;			///< Prime factors found so far, in ascending order
+		uint64_t cofactor;							///< Part of the number left unfactored (1 when complete)
+		FactorStatus status;						///< Classification of cofactor
+	};
+
+
+	/// Approximate memory of one entry of a table of results keyed by number, used to cap such tables. Counts the
+	///	unordered_map node (key, next pointer, cached hash and allocator overhead), its bucket pointer and the factor
+	///	storage, plus inEntryBytes for whatever else the table keeps per entry (the value, queue or ring slots).
+	std::size_t factorEntryBytes(
+		const FactorResult& inResult,				///< Entry to measure
+		std::size_t inEntryBytes					///< Other per-entry memory of the table
+		);
+
 
 	/// Calculate prime factors of given non-negative number.
 	std::vector<uint64_t> calculatePrimeFactors(
 		uint64_t inNumberToFactor					///< Number to calculate prime factors of
 		);
 
+
+	/// Calculate prime factors of given non-negative number, stopping early once inBudget is spent.
+	FactorResult calculatePrimeFactors(
+		uint64_t inNumberToFactor,					///< Number to calculate prime factors of
+		const FactorBudget& inBudget				///< Work limits for this number
+		);
+
+
+	/// Calculate prime factors of given non-negative number within a budget, adding the work done to ioCounters.
+	FactorResult calculatePrimeFactors(
+		uint64_t inNumberToFactor,					///< Number to calculate prime factors of
+		const FactorBudget& inBudget,				///< Work limits for this number
+		FactorCounters& ioCounters					///< Counts of the work done are added here
+		);
+
 } // namespace utils
 
 #endif // UTILS_LIB_H
\ No newline at end of file
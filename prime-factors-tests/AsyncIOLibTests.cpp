@@ -0,0 +1,215 @@
+///////////////////////////////////////
+///
+///	\file		AsyncIOLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		AsyncIOLib unit tests
+///
+///	\notes:
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// File system seperator:
+//
+#if defined(WIN32) || defined(_WIN32)
+const char PATH_SEPARATOR = '\\';
+#else
+const char PATH_SEPARATOR = '/';
+#endif
+
+
+//
+// Local includes:
+//
+#include "AsyncIOLib.h"
+#include "FileParserLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+namespace aio = async_io;
+namespace fp = file_parser;
+using namespace std;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(AsyncIOLibTests)
+	{
+	private:
+
+		//
+		// Variables to use in tests:
+		//
+		const string nonExistentFileName = "i_do_not_exist.awesome_ext";
+		const string realFileName = std::string("..") + PATH_SEPARATOR + std::string("prime-factors") + PATH_SEPARATOR + std::string("test-data.txt");
+
+	public:
+
+
+		//
+		// Test non-existent file:
+		//
+		TEST_METHOD(NonExisitentFile)
+		{
+			try
+			{
+				aio::BlockReader reader(nonExistentFileName);
+			}
+			catch (const std::exception& e)
+			{
+				// Correct exception, return.
+				return;
+			}
+			catch (...)
+			{
+				// Wrong exception type was thrown, test failure:
+				Assert::Fail(L"Exception thrown NOT derived from std::exception.", LINE_INFO());
+			}
+
+			// No exception was thrown, test failure:
+			Assert::Fail(L"No exception for non-existent file name.", LINE_INFO());
+		}
+
+
+		//
+		// Test a file that cannot be read (a directory) is an error from the reader, not an empty input:
+		//
+		TEST_METHOD(ReadErrorThrows)
+		{
+			try
+			{
+				// Where a directory opens at all, reading it fails:
+				aio::BlockReader reader("..");
+				aio::LineBlock block;
+				while (reader.nextBlock(block)) {}
+			}
+			catch (const runtime_error&)
+			{
+				return;
+			}
+			Assert::Fail(L"Reading a directory looked like the end of the file.", LINE_INFO());
+		}
+
+
+		//
+		// Test that blocks read back-to-back give the same lines as the in-memory parser:
+		//	Note: Small block size so the file spans many blocks.
+		//
+		TEST_METHOD(BlocksMatchFileParser)
+		{
+			fp::FileParser fileParser(realFileName);
+			auto& expectedLines = fileParser.getContents();
+
+			aio::BlockReader reader(realFileName, 7);
+			aio::LineBlock block;
+			vector<string> readLines;
+			while (reader.nextBlock(block))
+			{
+				Assert::IsTrue(block.lines.size() <= 7);
+				readLines.insert(readLines.end(), block.lines.begin(), block.lines.end());
+			}
+
+			// Make sure sizes are the same:
+			Assert::AreEqual(expectedLines.size(), readLines.size());
+
+			// Loop through and test all lines:
+			for (uint32_t i = 0; i < readLines.size(); ++i)
+			{
+				Assert::AreEqual(expectedLines[i].str(), readLines[i]);
+			}
+
+			// Reader stays exhausted:
+			Assert::IsFalse(reader.nextBlock(block));
+		}
+
+
+		//
+		// Test the block byte counts add up to the file size (the test file's last line has no line ending):
+		//
+		TEST_METHOD(BlockBytesCoverFile)
+		{
+			aio::BlockReader reader(realFileName, 5);
+			aio::LineBlock block;
+			uint64_t totalBytes = 0;
+			while (reader.nextBlock(block)) totalBytes += block.byteCount;
+
+			Assert::IsTrue(reader.getFileSize() > 0);
+			Assert::AreEqual(reader.getFileSize(), totalBytes);
+		}
+
+
+		//
+		// Test a reader started at the byte count of earlier blocks continues with the lines after them:
+		//
+		TEST_METHOD(StartOffsetSkipsBlocks)
+		{
+			aio::BlockReader reader(realFileName, 5);
+			aio::LineBlock block;
+			Assert::IsTrue(reader.nextBlock(block));
+			uint64_t skippedBytes = block.byteCount;
+
+			vector<string> remainingLines;
+			while (reader.nextBlock(block)) remainingLines.insert(remainingLines.end(), block.lines.begin(), block.lines.end());
+
+			aio::BlockReader resumedReader(realFileName, 5, 1, skippedBytes);
+			vector<string> resumedLines;
+			while (resumedReader.nextBlock(block)) resumedLines.insert(resumedLines.end(), block.lines.begin(), block.lines.end());
+
+			Assert::IsTrue(!resumedLines.empty());
+			Assert::IsTrue(remainingLines == resumedLines);
+		}
+
+
+		//
+		// Test writer keeps buffer order and hands back empty buffers:
+		//
+		TEST_METHOD(WriterKeepsOrder)
+		{
+			ostringstream out;
+			string expected;
+			{
+				aio::AsyncWriter writer(out);
+				string buffer;
+				for (uint32_t i = 0; i < 100; ++i)
+				{
+					buffer += to_string(i) + "\n";
+					expected += to_string(i) + "\n";
+					writer.write(buffer);
+					Assert::IsTrue(buffer.empty());
+				}
+				writer.close();
+				Assert::AreEqual(uint64_t(expected.size()), writer.getBytesWritten());
+			}
+
+			Assert::AreEqual(expected, out.str());
+		}
+
+	};
+}
@@ -0,0 +1,205 @@
+///////////////////////////////////////
+///
+///	\file		BatchGcdLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		BatchGcdLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "BatchGcdLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace bg = batch_gcd;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(BatchGcdLibTests)
+	{
+	private:
+
+		//
+		// Helper to build a number with many limbs from a simple pattern:
+		//
+		static bg::BigUnsigned makeNumber(size_t limbs, uint64_t seed)
+		{
+			bg::BigUnsigned number(1);
+			for (size_t i = 0; i < limbs; ++i)
+			{
+				seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+				number = bg::BigUnsigned::add(number.shiftLimbsLeft(1), bg::BigUnsigned(seed >> 32));
+			}
+			return number;
+		}
+
+	public:
+
+
+		//
+		// Test long division against a product built by hand:
+		//
+		TEST_METHOD(DivideModuloSmall)
+		{
+			// (2^64 - 1) * 1000003 + 999 divided by 1000003:
+			bg::BigUnsigned dividend = bg::BigUnsigned::add(bg::BigUnsigned::multiply(bg::BigUnsigned(~uint64_t(0)), bg::BigUnsigned(1000003)), bg::BigUnsigned(999));
+			bg::BigUnsigned quotient, remainder;
+			bg::BigUnsigned::divideModulo(dividend, bg::BigUnsigned(1000003), quotient, remainder);
+
+			Assert::AreEqual(~uint64_t(0), quotient.toUint64());
+			Assert::AreEqual(size_t(2), quotient.size());
+			Assert::AreEqual(uint64_t(999), remainder.toUint64());
+		}
+
+
+		//
+		// Test a * b + r comes back apart through Karatsuba, Barrett and long division:
+		//
+		TEST_METHOD(MultiplyModuloLarge)
+		{
+			bg::BigUnsigned a = makeNumber(700, 1), b = makeNumber(300, 2), r = makeNumber(250, 3);
+			bg::BigUnsigned dividend = bg::BigUnsigned::add(bg::BigUnsigned::multiply(a, b), r);
+
+			Assert::AreEqual(0, bg::BigUnsigned::compare(r, bg::BigUnsigned::modulo(dividend, b)));
+
+			bg::BigUnsigned quotient, remainder;
+			bg::BigUnsigned::divideModulo(dividend, b, quotient, remainder);
+			Assert::AreEqual(0, bg::BigUnsigned::compare(a, quotient));
+			Assert::AreEqual(0, bg::BigUnsigned::compare(r, remainder));
+		}
+
+
+		//
+		// Test the reciprocal is the exact floor:
+		//
+		TEST_METHOD(Reciprocal)
+		{
+			bg::BigUnsigned b = makeNumber(200, 4);
+			bg::BigUnsigned power = bg::BigUnsigned(1).shiftLimbsLeft(2 * b.size());
+			bg::BigUnsigned expected, remainder;
+			bg::BigUnsigned::divideModulo(power, b, expected, remainder);
+
+			Assert::AreEqual(0, bg::BigUnsigned::compare(expected, bg::BigUnsigned::reciprocal(b)));
+		}
+
+
+		//
+		// Test shared primes are found and split:
+		//
+		TEST_METHOD(FindSharedFactors)
+		{
+			// 1000003 is shared by the first two, 1000033 by the last two, 1000037 * 1000039 shares nothing:
+			vector<uint64_t> numbers = { 1000003ull * 1000007, 1000003ull * 1000033, 1000037ull * 1000039, 1000033ull * 1000081 };
+			auto shared = bg::findSharedFactors(numbers, 2);
+
+			Assert::AreEqual(size_t(3), shared.size());
+			for (auto& s : shared)
+			{
+				Assert::IsTrue(s.number != 1000037ull * 1000039);
+				Assert::IsTrue((s.sharedFactor > 1) && (s.sharedFactor < s.number));
+				Assert::AreEqual(uint64_t(0), s.number % s.sharedFactor);
+			}
+		}
+
+
+		//
+		// Test products above the NTT threshold agree with long division, on one thread and several:
+		//
+		TEST_METHOD(MultiplyNtt)
+		{
+			bg::BigUnsigned a = makeNumber(7000, 5), b = makeNumber(6500, 6), r = makeNumber(6000, 7);
+			bg::BigUnsigned product = bg::BigUnsigned::multiply(a, b);
+			Assert::AreEqual(0, bg::BigUnsigned::compare(product, bg::BigUnsigned::multiply(a, b, 4)));
+
+			bg::BigUnsigned quotient, remainder;
+			bg::BigUnsigned::divideModulo(bg::BigUnsigned::add(product, r), b, quotient, remainder);
+			Assert::AreEqual(0, bg::BigUnsigned::compare(a, quotient));
+			Assert::AreEqual(0, bg::BigUnsigned::compare(r, remainder));
+
+			// Squares take a shortcut:
+			bg::BigUnsigned square = bg::BigUnsigned::multiply(a, a, 4);
+			bg::BigUnsigned::divideModulo(square, a, quotient, remainder);
+			Assert::AreEqual(0, bg::BigUnsigned::compare(a, quotient));
+			Assert::IsTrue(remainder.isZero());
+		}
+
+
+		//
+		// Test a number whose primes are all shared, but with different inputs, is still split:
+		//
+		TEST_METHOD(FindSharedFactorsFullyShared)
+		{
+			vector<uint64_t> numbers = { 101 * 103, 101 * 107, 103 * 109, 113, 113, 1, 0 };
+			auto shared = bg::findSharedFactors(numbers);
+
+			// Both copies of 113 come first, sharing all of it:
+			Assert::AreEqual(size_t(5), shared.size());
+			for (size_t i = 0; i < 2; ++i)
+			{
+				Assert::AreEqual(uint64_t(113), shared[i].number);
+				Assert::AreEqual(uint64_t(113), shared[i].sharedFactor);
+			}
+			Assert::AreEqual(uint64_t(101 * 103), shared[2].number);
+			Assert::AreEqual(uint64_t(101), shared[2].sharedFactor);
+		}
+
+
+		//
+		// Test every copy of a repeated number is reported, split where another input allows:
+		//
+		TEST_METHOD(FindSharedFactorsRepeated)
+		{
+			const uint64_t modulus = 1000000016000000063ull;
+			vector<uint64_t> numbers = { modulus, 1000037ull * 1000039, modulus, 1000003ull * 1000007, 1000003ull * 1000033, 1000003ull * 1000007 };
+			auto shared = bg::findSharedFactors(numbers, 2);
+
+			// The repeated modulus shares all of itself, the other repeated number is split by 1000003 * 1000033:
+			Assert::AreEqual(size_t(5), shared.size());
+			size_t modulusCopies = 0;
+			for (auto& s : shared)
+			{
+				Assert::IsTrue(s.number != 1000037ull * 1000039);
+				if (s.number == modulus)
+				{
+					Assert::AreEqual(modulus, s.sharedFactor);
+					++modulusCopies;
+				}
+				else
+				{
+					Assert::AreEqual(uint64_t(1000003), s.sharedFactor);
+				}
+			}
+			Assert::AreEqual(size_t(2), modulusCopies);
+		}
+
+	};
+}
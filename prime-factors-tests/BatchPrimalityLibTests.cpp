@@ -0,0 +1,93 @@
+///////////////////////////////////////
+///
+///	\file		BatchPrimalityLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		BatchPrimalityLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "BatchPrimalityLib.h"
+#include "FactorAlgorithmsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <stdint.h>
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace bp = batch_primality;
+namespace fa = factor_algorithms;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(BatchPrimalityLibTests)
+	{
+	public:
+
+
+		//
+		// Test the kernel choice:
+		//
+		TEST_METHOD(BestKernelIsSupported)
+		{
+			Assert::IsTrue(bp::isSupported(bp::Kernel::scalar));
+			Assert::IsTrue(bp::isSupported(bp::bestKernel()));
+		}
+
+
+		//
+		// Test every supported kernel against isPrime, across the lane and limb edges and strong pseudoprimes:
+		//
+		TEST_METHOD(KernelsMatchIsPrime)
+		{
+			vector<uint64_t> numbers = { 0, 1, 2, 3, 4, 37, 1369, 1373, 2047, 3215031751ull, 4294967291ull, 4294967295ull,
+				4294967297ull, 4294967311ull, 3825123056546413051ull, 4503599627370449ull, 4503599627370496ull,
+				4503599627370517ull, 18446744073709551557ull, 18446744073709551615ull };
+
+			// Mixed batches of every size split into groups with leftover lanes:
+			for (uint64_t n = 1000003; n < 1000403; ++n) numbers.push_back(n);
+			for (uint64_t n = 18446744073709551615ull - 400; n != 0; ++n) numbers.push_back(n);
+
+			const bp::Kernel kernels[] = { bp::Kernel::scalar, bp::Kernel::avx2, bp::Kernel::avx512ifma };
+			for (bp::Kernel kernel : kernels)
+			{
+				if (!bp::isSupported(kernel)) continue;
+
+				vector<uint8_t> isPrime(numbers.size(), 2);
+				bp::isPrimeBatch(numbers.data(), numbers.size(), isPrime.data(), kernel);
+				for (size_t i = 0; i < numbers.size(); ++i)
+				{
+					Assert::AreEqual(fa::isPrime(numbers[i]) ? 1 : 0, int(isPrime[i]));
+				}
+			}
+		}
+
+	};
+}
@@ -0,0 +1,127 @@
+///////////////////////////////////////
+///
+///	\file		CApiLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		CApiLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "CApiLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <stdint.h>
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(CApiLibTests)
+	{
+	public:
+
+
+		//
+		// Test single numbers, including the top of the range and a buffer that is too small:
+		//
+		TEST_METHOD(FactorOne)
+		{
+			uint64_t factors[PF_MAX_FACTORS];
+			size_t count = 0;
+
+			Assert::AreEqual(PF_OK, pf_factor(18446744073709551615ull, factors, PF_MAX_FACTORS, &count));
+			vector<uint64_t> expected = { 3, 5, 17, 257, 641, 65537, 6700417 };
+			Assert::IsTrue(expected == vector<uint64_t>(factors, factors + count));
+
+			Assert::AreEqual(PF_OK, pf_factor(1, factors, PF_MAX_FACTORS, &count));
+			Assert::AreEqual(size_t(0), count);
+
+			// Size needed is reported back:
+			Assert::AreEqual(PF_ERROR_BUFFER_TOO_SMALL, pf_factor(1024, factors, 4, &count));
+			Assert::AreEqual(size_t(10), count);
+
+			Assert::AreEqual(PF_ERROR_NULL_ARGUMENT, pf_factor(12, factors, PF_MAX_FACTORS, nullptr));
+		}
+
+
+		//
+		// Test the packed batch, and that it can be resumed after running out of room:
+		//
+		TEST_METHOD(FactorBatchPacked)
+		{
+			const uint64_t numbers[] = { 12, 0, 97, 600851475143ull, 18446743979220271189ull };
+			uint64_t factors[6];
+			size_t offsets[6];
+			size_t done = 0;
+
+			// 12 and 0 fit, 97 does too, 600851475143 needs four more slots than are left:
+			Assert::AreEqual(PF_ERROR_BUFFER_TOO_SMALL, pf_factor_batch(numbers, 5, factors, 6, offsets, &done));
+			Assert::AreEqual(size_t(3), done);
+			Assert::AreEqual(size_t(3), offsets[1]);
+			Assert::AreEqual(size_t(3), offsets[2]);
+			Assert::AreEqual(size_t(4), offsets[3]);
+			Assert::AreEqual(uint64_t(97), factors[3]);
+
+			Assert::AreEqual(PF_OK, pf_factor_batch(numbers + done, 2, factors, 6, offsets, &done));
+			Assert::AreEqual(size_t(2), done);
+			vector<uint64_t> expected = { 71, 839, 1471, 6857, 4294967279ull, 4294967291ull };
+			Assert::IsTrue(expected == vector<uint64_t>(factors, factors + offsets[2]));
+		}
+
+
+		//
+		// Test the fixed-row batch and the per-number queries agree:
+		//
+		TEST_METHOD(FixedBatchAndQueries)
+		{
+			const uint64_t numbers[] = { 2, 91, 1, 4294967291ull };
+			vector<uint64_t> factors(4 * PF_MAX_FACTORS);
+			uint8_t counts[4];
+			uint64_t smallest[4];
+			uint8_t isPrime[4];
+
+			Assert::AreEqual(PF_OK, pf_factor_batch_fixed(numbers, 4, factors.data(), counts));
+			Assert::AreEqual(PF_OK, pf_smallest_factor_batch(numbers, 4, smallest));
+			Assert::AreEqual(PF_OK, pf_is_prime_batch(numbers, 4, isPrime));
+
+			Assert::AreEqual(uint8_t(2), counts[1]);
+			Assert::AreEqual(uint64_t(13), factors[PF_MAX_FACTORS + 1]);
+			Assert::AreEqual(uint8_t(0), counts[2]);
+			for (size_t i = 0; i < 4; ++i)
+			{
+				Assert::AreEqual(counts[i] > 0 ? factors[i * PF_MAX_FACTORS] : uint64_t(0), smallest[i]);
+				Assert::AreEqual(uint8_t(counts[i] == 1 ? 1 : 0), isPrime[i]);
+			}
+			Assert::AreEqual(uint32_t(PF_ABI_VERSION), pf_abi_version());
+		}
+
+	};
+}
@@ -0,0 +1,167 @@
+///////////////////////////////////////
+///
+///	\file		CheckpointLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		CheckpointLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "CheckpointLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdint.h>
+#include <string>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace ck = checkpoint;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(CheckpointLibTests)
+	{
+	private:
+
+		//
+		// Variables to use in tests:
+		//
+		const string checkpointFileName = "checkpoint-test.txt";
+		const string outputFileName = "checkpoint-test-output.txt";
+
+	public:
+
+
+		//
+		// Test a saved checkpoint loads back and leaves no temporary file:
+		//
+		TEST_METHOD(SaveAndLoad)
+		{
+			remove(checkpointFileName.c_str());
+			Assert::IsFalse(ck::hasCheckpoint(checkpointFileName));
+
+			ck::Position position;
+			position.inputBytes = 123456789012ull;
+			position.lines = 4096;
+			position.outputBytes = 987654321;
+			ck::saveCheckpoint(position, checkpointFileName);
+
+			Assert::IsTrue(ck::hasCheckpoint(checkpointFileName));
+			Assert::IsFalse(ifstream(checkpointFileName + ".tmp").is_open());
+
+			ck::Position loaded = ck::loadCheckpoint(checkpointFileName);
+			Assert::AreEqual(position.inputBytes, loaded.inputBytes);
+			Assert::AreEqual(position.lines, loaded.lines);
+			Assert::AreEqual(position.outputBytes, loaded.outputBytes);
+
+			remove(checkpointFileName.c_str());
+		}
+
+
+		//
+		// Test output is cut back to the checkpoint, and refused if it is shorter:
+		//
+		TEST_METHOD(RewindOutput)
+		{
+			{
+				ofstream output(outputFileName, ios::binary | ios::trunc);
+				output << string(100, 'x');
+			}
+
+			ck::Position position;
+			position.outputBytes = 60;
+			ck::rewindOutput(outputFileName, position);
+			Assert::AreEqual(int64_t(60), int64_t(ifstream(outputFileName, ios::binary | ios::ate).tellg()));
+
+			bool threw = false;
+			position.outputBytes = 61;
+			try
+			{
+				ck::rewindOutput(outputFileName, position);
+			}
+			catch (const std::exception&)
+			{
+				threw = true;
+			}
+			Assert::IsTrue(threw);
+
+			remove(outputFileName.c_str());
+		}
+
+
+		//
+		// Test only units whose output was written are saved, counted on from the start position:
+		//
+		TEST_METHOD(SavesOnlyWrittenUnits)
+		{
+			ck::Position start;
+			start.inputBytes = 100;
+			start.lines = 10;
+			start.outputBytes = 50;
+			atomic<uint64_t> written(0);
+
+			// An hour between saves, so only stop() saves:
+			{
+				ck::Checkpointer checkpointer(checkpointFileName, start, [&written] { return uint64_t(written); }, chrono::hours(1));
+				checkpointer.add(10, 1, 5);
+				checkpointer.add(20, 2, 7);
+				checkpointer.add(30, 3, 0);
+				written = 5;
+				checkpointer.stop();
+			}
+
+			ck::Position loaded = ck::loadCheckpoint(checkpointFileName);
+			Assert::AreEqual(uint64_t(110), loaded.inputBytes);
+			Assert::AreEqual(uint64_t(11), loaded.lines);
+			Assert::AreEqual(uint64_t(55), loaded.outputBytes);
+
+			// A unit without output is done as soon as the one before it is written:
+			{
+				ck::Checkpointer checkpointer(checkpointFileName, start, [&written] { return uint64_t(written); }, chrono::hours(1));
+				checkpointer.add(10, 1, 5);
+				checkpointer.add(20, 2, 7);
+				checkpointer.add(30, 3, 0);
+				written = 12;
+				checkpointer.stop();
+			}
+
+			loaded = ck::loadCheckpoint(checkpointFileName);
+			Assert::AreEqual(uint64_t(160), loaded.inputBytes);
+			Assert::AreEqual(uint64_t(16), loaded.lines);
+			Assert::AreEqual(uint64_t(62), loaded.outputBytes);
+
+			remove(checkpointFileName.c_str());
+		}
+
+	};
+}
@@ -0,0 +1,183 @@
+///////////////////////////////////////
+///
+///	\file		CompressedInputLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		CompressedInputLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "CompressedInputLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace ci = compressed_input;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(CompressedInputLibTests)
+	{
+	private:
+
+		//
+		// Variables to use in tests, each file holds "12\n35\n" and "-4\n1001\n" as two members/frames:
+		//
+		const string testFileName = "compressed-input-test.bin";
+		const string expectedText = "12\n35\n-4\n1001\n";
+
+		const vector<uint8_t> gzipBytes = {
+			0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x33, 0x34, 0xe2, 0x32, 0x36, 0xe5,
+			0x02, 0x00, 0x48, 0x0e, 0x71, 0xae, 0x06, 0x00, 0x00, 0x00, 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x02, 0x03, 0xd3, 0x35, 0xe1, 0x32, 0x34, 0x30, 0x30, 0xe4, 0x02, 0x00, 0x62, 0x68,
+			0x6f, 0x94, 0x08, 0x00, 0x00, 0x00 };
+
+		// BGZF, with the empty end-of-file block:
+		const vector<uint8_t> bgzfBytes = {
+			0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00,
+			0x21, 0x00, 0x33, 0x34, 0xe2, 0x32, 0x36, 0xe5, 0x02, 0x00, 0x48, 0x0e, 0x71, 0xae, 0x06, 0x00,
+			0x00, 0x00, 0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+			0x02, 0x00, 0x23, 0x00, 0xd3, 0x35, 0xe1, 0x32, 0x34, 0x30, 0x30, 0xe4, 0x02, 0x00, 0x62, 0x68,
+			0x6f, 0x94, 0x08, 0x00, 0x00, 0x00, 0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+			0x06, 0x00, 0x42, 0x43, 0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00 };
+
+		const vector<uint8_t> zstdBytes = {
+			0x28, 0xb5, 0x2f, 0xfd, 0x04, 0x58, 0x31, 0x00, 0x00, 0x31, 0x32, 0x0a, 0x33, 0x35, 0x0a, 0xc2,
+			0xf2, 0x9b, 0x12, 0x28, 0xb5, 0x2f, 0xfd, 0x04, 0x58, 0x41, 0x00, 0x00, 0x2d, 0x34, 0x0a, 0x31,
+			0x30, 0x30, 0x31, 0x0a, 0xf1, 0xce, 0xf2, 0xfd };
+
+
+		//
+		// Write bytes to the test file:
+		//
+		void writeTestFile(const vector<uint8_t>& bytes)
+		{
+			ofstream file(testFileName, ios::binary | ios::trunc);
+			file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		}
+
+		//
+		// Read the test file back through InputFile:
+		//
+		string readTestFile(unsigned decompressThreads)
+		{
+			ci::InputFile inputFile(testFileName, decompressThreads);
+			return string(istreambuf_iterator<char>(inputFile.getStream()), istreambuf_iterator<char>());
+		}
+
+	public:
+
+
+		//
+		// Test format detection from the first bytes:
+		//
+		TEST_METHOD(DetectFromMagic)
+		{
+			Assert::IsTrue(ci::Compression::gzip == ci::detectCompression("\x1f\x8b\x08\x00", 4));
+			Assert::IsTrue(ci::Compression::zstd == ci::detectCompression("\x28\xb5\x2f\xfd", 4));
+			Assert::IsTrue(ci::Compression::zstd == ci::detectCompression("\x50\x2a\x4d\x18", 4));
+			Assert::IsTrue(ci::Compression::none == ci::detectCompression("12\n3", 4));
+			Assert::IsTrue(ci::Compression::none == ci::detectCompression("\x28\xb5", 2));
+			Assert::IsTrue(ci::Compression::none == ci::detectCompression("", 0));
+		}
+
+
+		//
+		// Test every format reads back as the plain text, in order and in parallel:
+		//
+		TEST_METHOD(FormatsMatchPlainText)
+		{
+			const vector<uint8_t>* files[] = { &gzipBytes, &bgzfBytes, &zstdBytes };
+			const ci::Compression compressions[] = { ci::Compression::gzip, ci::Compression::gzip, ci::Compression::zstd };
+
+			for (size_t i = 0; i < 3; ++i)
+			{
+				writeTestFile(*files[i]);
+
+				// A build without the library refuses the file up front:
+				if (!ci::isSupported(compressions[i]))
+				{
+					bool threw = false;
+					try
+					{
+						ci::InputFile inputFile(testFileName);
+					}
+					catch (const std::exception&)
+					{
+						threw = true;
+					}
+					Assert::IsTrue(threw);
+					continue;
+				}
+
+				ci::InputFile inputFile(testFileName);
+				Assert::IsTrue(compressions[i] == inputFile.getCompression());
+				Assert::AreEqual(uint64_t(0), inputFile.getFileSize());
+
+				Assert::AreEqual(expectedText, readTestFile(1));
+				Assert::AreEqual(expectedText, readTestFile(3));
+			}
+
+			remove(testFileName.c_str());
+		}
+
+
+		//
+		// Test a file cut short in the middle of a member is an error, not a short read:
+		//
+		TEST_METHOD(CutShortThrows)
+		{
+			if (!ci::isSupported(ci::Compression::gzip)) return;
+
+			writeTestFile(vector<uint8_t>(gzipBytes.begin(), gzipBytes.begin() + 40));
+
+			bool threw = false;
+			try
+			{
+				readTestFile(1);
+			}
+			catch (const std::exception&)
+			{
+				threw = true;
+			}
+			Assert::IsTrue(threw);
+
+			remove(testFileName.c_str());
+		}
+
+	};
+}
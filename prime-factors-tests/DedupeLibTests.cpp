@@ -0,0 +1,146 @@
+///////////////////////////////////////
+///
+///	\file		DedupeLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		DedupeLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "DedupeLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <thread>
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace dd = dedupe;
+namespace u = utils;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(DedupeLibTests)
+	{
+	private:
+
+		//
+		// Helper to build a complete result:
+		//
+		static u::FactorResult makeResult(const vector<uint64_t>& primeFactors)
+		{
+			u::FactorResult result;
+			result.primeFactors = primeFactors;
+			result.cofactor = 1;
+			result.status = u::FactorStatus::complete;
+			return result;
+		}
+
+	public:
+
+
+		//
+		// Test stored results are found again:
+		//
+		TEST_METHOD(FindInserted)
+		{
+			dd::DedupeTable table(1 << 20);
+			u::FactorResult found;
+
+			Assert::IsFalse(table.find(455, found));
+			table.insert(455, makeResult({ 5, 7, 13 }));
+
+			Assert::IsTrue(table.find(455, found));
+			Assert::AreEqual(size_t(3), found.primeFactors.size());
+			Assert::AreEqual(uint64_t(13), found.primeFactors[2]);
+			Assert::AreEqual(uint64_t(1), table.getHits());
+			Assert::AreEqual(uint64_t(1), table.getMisses());
+		}
+
+
+		//
+		// Test the table stays under its cap by dropping the oldest entries:
+		//
+		TEST_METHOD(EvictsOldest)
+		{
+			dd::DedupeTable table(1024);
+			for (uint64_t n = 2; n < 1000; ++n)
+			{
+				table.insert(n, makeResult({ n }));
+				Assert::IsTrue(table.getBytesUsed() <= 1024);
+			}
+
+			u::FactorResult found;
+			Assert::IsFalse(table.find(2, found));
+			Assert::IsTrue(table.find(999, found));
+		}
+
+
+		//
+		// Test a zero cap disables the table:
+		//
+		TEST_METHOD(ZeroCapacity)
+		{
+			dd::DedupeTable table(0);
+			table.insert(455, makeResult({ 5, 7, 13 }));
+
+			u::FactorResult found;
+			Assert::IsFalse(table.find(455, found));
+			Assert::AreEqual(size_t(0), table.getBytesUsed());
+		}
+
+
+		//
+		// Test workers sharing one sharded table each find what the others stored, within the whole cap:
+		//
+		TEST_METHOD(SharedBetweenThreads)
+		{
+			dd::DedupeTable table(1 << 20, 8);
+			vector<thread> workers;
+			for (uint64_t t = 0; t < 4; ++t)
+			{
+				workers.push_back(thread([&table, t]
+				{
+					for (uint64_t n = 2 + t; n < 2000; n += 4) table.insert(n, makeResult({ n }));
+				}));
+			}
+			for (auto& worker : workers) worker.join();
+
+			u::FactorResult found;
+			for (uint64_t n = 2; n < 2000; ++n)
+			{
+				Assert::IsTrue(table.find(n, found));
+				Assert::AreEqual(n, found.primeFactors[0]);
+			}
+			Assert::AreEqual(uint64_t(1998), table.getHits());
+			Assert::IsTrue(table.getBytesUsed() <= (1 << 20));
+		}
+
+	};
+}
@@ -0,0 +1,247 @@
+///////////////////////////////////////
+///
+///	\file		FactorAlgorithmsLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		FactorAlgorithmsLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "FactorAlgorithmsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace fa = factor_algorithms;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(FactorAlgorithmsLibTests)
+	{
+	public:
+
+
+		//
+		// Test primality of small numbers against their definition:
+		//
+		TEST_METHOD(IsPrime_Small)
+		{
+			for (uint64_t n = 0; n < 2000; ++n)
+			{
+				bool expected = (n >= 2);
+				for (uint64_t d = 2; d * d <= n; ++d)
+				{
+					if ((n % d) == 0) expected = false;
+				}
+
+				Assert::AreEqual(expected, fa::isPrime(n));
+			}
+		}
+
+
+		//
+		// Test primality of large numbers, including strong pseudoprimes to small bases:
+		//
+		TEST_METHOD(IsPrime_Large)
+		{
+			Assert::IsTrue(fa::isPrime(5915587277));
+			Assert::IsTrue(fa::isPrime(9223372036854775783));
+			Assert::IsTrue(fa::isPrime(18446744073709551557ull));
+			Assert::IsFalse(fa::isPrime(3215031751));				// Strong pseudoprime to bases 2, 3, 5 and 7
+			Assert::IsFalse(fa::isPrime(3825123056546413051));		// Strong pseudoprime to bases 2 through 23
+			Assert::IsFalse(fa::isPrime(18446744030759878681ull));	// 4294967291^2
+		}
+
+
+		//
+		// Test smallest-factor table against trial division:
+		//
+		TEST_METHOD(SmallestFactorTable)
+		{
+			auto& table = fa::SmallestFactorTable::instance();
+
+			Assert::IsTrue(table.covers(1048575));
+			Assert::IsFalse(table.covers(1048576));
+			Assert::AreEqual(uint64_t(2), table.smallestFactor(1048574));
+			Assert::AreEqual(uint64_t(1048573), table.smallestFactor(1048573));	// prime
+			Assert::AreEqual(uint64_t(1021), table.smallestFactor(1021 * 1021));
+
+			vector<uint64_t> factors;
+			table.factor(360, factors);
+			vector<uint64_t> actualPrimeFactors = { 2, 2, 2, 3, 3, 5 };
+
+			// Make sure sizes are the same:
+			Assert::AreEqual(actualPrimeFactors.size(), factors.size());
+
+			// Loop through and test all factors:
+			for (uint32_t i = 0; i < factors.size(); ++i)
+			{
+				Assert::AreEqual(actualPrimeFactors[i], factors[i]);
+			}
+		}
+
+
+		//
+		// Test rho splits a balanced semiprime:
+		//
+		TEST_METHOD(PollardRho_Semiprime)
+		{
+			fa::BudgetTracker tracker((utils::FactorBudget()));
+			uint64_t factor = fa::pollardRho(4294967291ull * 4294967279ull, tracker);
+
+			Assert::IsTrue((factor == 4294967291ull) || (factor == 4294967279ull));
+		}
+
+
+		//
+		// Test rho gives up once its budget is spent:
+		//
+		TEST_METHOD(PollardRho_Budget)
+		{
+			fa::BudgetTracker tracker(utils::FactorBudget(1));
+			uint64_t factor = fa::pollardRho(4294967291ull * 4294967279ull, tracker);
+
+			Assert::AreEqual(uint64_t(0), factor);
+		}
+
+
+		//
+		// Test a time budget too large to add to the clock means no deadline instead of one in the past:
+		//
+		TEST_METHOD(BudgetTracker_HugeTime)
+		{
+			for (uint64_t milliseconds : { uint64_t(18446744073709551ull), uint64_t(9223372036854775807ull) })
+			{
+				fa::BudgetTracker tracker(utils::FactorBudget(0, milliseconds));
+				uint64_t factor = fa::pollardRho(4294967291ull * 4294967279ull, tracker);
+
+				Assert::IsTrue((factor == 4294967291ull) || (factor == 4294967279ull));
+			}
+		}
+
+
+		//
+		// Test trial division stops at its bound and leaves the next candidate:
+		//
+		TEST_METHOD(TrialDivide_Bound)
+		{
+			fa::BudgetTracker tracker((utils::FactorBudget()));
+			uint64_t number = 3 * 3 * 7 * 1000003;
+			uint64_t candidate = 3;
+			vector<uint64_t> factors;
+
+			Assert::IsTrue(fa::trialDivide(number, candidate, 11, factors, tracker));
+			Assert::AreEqual(uint64_t(13), candidate);
+			Assert::AreEqual(uint64_t(1000003), number);
+			Assert::AreEqual(size_t(3), factors.size());
+		}
+
+
+		//
+		// Test trial division carries on in 32 bits once the cofactor fits:
+		//
+		TEST_METHOD(TrialDivide_NarrowsCofactor)
+		{
+			fa::BudgetTracker tracker((utils::FactorBudget()));
+			uint64_t number = 3ull * 5 * 4294967291ull * 65521;
+			uint64_t candidate = 3;
+			vector<uint64_t> factors;
+
+			Assert::IsTrue(fa::trialDivide(number, candidate, 1 << 20, factors, tracker));
+			Assert::AreEqual(size_t(3), factors.size());
+			Assert::AreEqual(uint64_t(65521), factors[2]);
+			Assert::AreEqual(uint64_t(4294967291ull), number);
+		}
+
+
+		//
+		// Test 32-bit Montgomery arithmetic against plain 64-bit arithmetic:
+		//
+		TEST_METHOD(Montgomery32_Arithmetic)
+		{
+			const uint32_t modulus = 4294967291u;
+			fa::Montgomery32 mont(modulus);
+
+			uint32_t a = 3000000019u, b = 4000000007u;
+			uint32_t product = mont.fromMontgomery(mont.multiply(mont.toMontgomery(a), mont.toMontgomery(b)));
+			Assert::AreEqual(uint32_t((uint64_t(a) * b) % modulus), product);
+
+			uint32_t sum = mont.fromMontgomery(mont.add(mont.toMontgomery(a), mont.toMontgomery(b)));
+			Assert::AreEqual(uint32_t((uint64_t(a) + b) % modulus), sum);
+
+			// Fermat: a^(p - 1) = 1 mod p:
+			Assert::AreEqual(mont.one(), mont.power(mont.toMontgomery(a), modulus - 1));
+		}
+
+
+		//
+		// Test primality right around the 32-bit boundary where the narrow test takes over:
+		//
+		TEST_METHOD(IsPrime_Narrow)
+		{
+			Assert::IsTrue(fa::isPrime(4294967291ull));				// Largest 32-bit prime
+			Assert::IsFalse(fa::isPrime(4294967295ull));
+			Assert::IsFalse(fa::isPrime(4294967297ull));				// 641 * 6700417
+			Assert::IsTrue(fa::isPrime(4294967311ull));				// Smallest prime above 2^32
+			Assert::IsFalse(fa::isPrime(25326001));					// Strong pseudoprime to bases 2, 3 and 5
+			Assert::IsFalse(fa::isPrime(4759123141ull));				// Strong pseudoprime to bases 2, 7 and 61
+		}
+
+
+		//
+		// Test the counting policy sees the work of each algorithm:
+		//
+		TEST_METHOD(Counters_CountWork)
+		{
+			utils::FactorCounters counters;
+
+			// 2^61 - 1 is prime, all seven bases run:
+			Assert::IsTrue(fa::isPrime(2305843009213693951ull, counters));
+			Assert::AreEqual(uint64_t(7), counters.millerRabinRounds);
+
+			// Candidates 3, 5, ..., 19 are tried, then 21 * 21 > 23 stops the loop:
+			fa::BudgetTracker tracker((utils::FactorBudget()));
+			uint64_t number = 3 * 5 * 7 * 11 * 13 * 17 * 19 * 23;
+			uint64_t candidate = 3;
+			vector<uint64_t> factors;
+			Assert::IsTrue(fa::trialDivide(number, candidate, 100, factors, tracker, counters));
+			Assert::AreEqual(uint64_t(23), number);
+			Assert::AreEqual(uint64_t(9), counters.trialDivisions);
+
+			// Rho takes at least one step and one gcd, and the counters match the budget it charged:
+			fa::BudgetTracker rhoTracker((utils::FactorBudget(1000000)));
+			Assert::IsTrue(fa::pollardRho(1000036000099ull, rhoTracker, counters) != 0);
+			Assert::AreEqual(rhoTracker.getIterations(), counters.rhoSteps);
+			Assert::IsTrue(counters.gcds >= 1);
+		}
+
+	};
+}
@@ -0,0 +1,160 @@
+///////////////////////////////////////
+///
+///	\file		FactorCacheLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		FactorCacheLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "FactorCacheLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace fc = factor_cache;
+namespace u = utils;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(FactorCacheLibTests)
+	{
+	private:
+
+		//
+		// Variables to use in tests:
+		//
+		const u::FactorBudget unlimited;
+
+	public:
+
+
+		//
+		// Test second lookup of a number is a hit with the same factors:
+		//
+		TEST_METHOD(HitAfterMiss)
+		{
+			fc::FactorCache cache(1 << 20);
+
+			auto first = cache.factor(6000216000594, unlimited);
+			auto second = cache.factor(6000216000594, unlimited);
+			auto statistics = cache.getStatistics();
+
+			Assert::AreEqual(uint64_t(1), statistics.misses);
+			Assert::AreEqual(uint64_t(1), statistics.hits);
+			Assert::AreEqual(uint64_t(1), statistics.insertions);
+			Assert::AreEqual(first.primeFactors.size(), second.primeFactors.size());
+			for (uint32_t i = 0; i < first.primeFactors.size(); ++i)
+			{
+				Assert::AreEqual(first.primeFactors[i], second.primeFactors[i]);
+			}
+		}
+
+
+		//
+		// Test results cheaper than the admission threshold are not stored:
+		//
+		TEST_METHOD(AdmissionThreshold)
+		{
+			fc::FactorCache cache(1 << 20, chrono::seconds(60));
+
+			cache.factor(455, unlimited);
+			cache.factor(455, unlimited);
+			auto statistics = cache.getStatistics();
+
+			Assert::AreEqual(uint64_t(0), statistics.hits);
+			Assert::AreEqual(uint64_t(2), statistics.rejections);
+			Assert::AreEqual(size_t(0), statistics.bytesUsed);
+		}
+
+
+		//
+		// Test partial results are not stored:
+		//
+		TEST_METHOD(PartialNotAdmitted)
+		{
+			fc::FactorCache cache(1 << 20);
+
+			cache.factor(6000216000594, u::FactorBudget(10));
+			auto statistics = cache.getStatistics();
+
+			Assert::AreEqual(uint64_t(0), statistics.insertions);
+			Assert::AreEqual(uint64_t(1), statistics.rejections);
+		}
+
+
+		//
+		// Test the cache stays under its cap:
+		//
+		TEST_METHOD(EvictsUnderCap)
+		{
+			const size_t maxBytes = 4096;
+			fc::FactorCache cache(maxBytes, chrono::nanoseconds(0), 4);
+
+			for (uint64_t n = 2; n < 2000; ++n)
+			{
+				cache.factor(n, unlimited);
+				Assert::IsTrue(cache.getStatistics().bytesUsed <= maxBytes);
+			}
+			Assert::IsTrue(cache.getStatistics().evictions > 0);
+		}
+
+
+		//
+		// Test concurrent callers all get correct results:
+		//
+		TEST_METHOD(ConcurrentCallers)
+		{
+			fc::FactorCache cache(1 << 16, chrono::nanoseconds(0), 4);
+			vector<thread> threads;
+			vector<int> failures(4, 0);
+
+			for (int t = 0; t < 4; ++t)
+			{
+				threads.push_back(thread([&cache, &failures, t, this]()
+				{
+					for (uint64_t n = 2; n < 5000; ++n)
+					{
+						uint64_t product = 1;
+						for (auto factor : cache.factor(n, unlimited).primeFactors) product *= factor;
+						if (product != n) ++failures[t];
+					}
+				}));
+			}
+			for (auto& t : threads) t.join();
+
+			for (auto failureCount : failures) Assert::AreEqual(0, failureCount);
+		}
+
+	};
+}
@@ -0,0 +1,179 @@
+///////////////////////////////////////
+///
+///	\file		FactorDispatchLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		FactorDispatchLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "FactorDispatchLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace fd = factor_dispatch;
+namespace u = utils;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(FactorDispatchLibTests)
+	{
+	private:
+
+		//
+		// Variables to use in tests:
+		//
+		const string configFileName = "dispatch_test.cfg";
+		const u::FactorBudget unlimited;
+
+	public:
+
+
+		//
+		// Cleanup run AFTER each TEST_METHOD:
+		//
+		TEST_METHOD_CLEANUP(TestMethodCleanUp)
+		{
+			remove(configFileName.c_str());
+		}
+
+
+		//
+		// Test method choice follows the thresholds:
+		//
+		TEST_METHOD(ChooseMethod)
+		{
+			fd::DispatchThresholds thresholds = fd::defaultThresholds();
+			thresholds.lookupTableMaxBits = 16;
+			thresholds.trialDivisionMaxBits = 32;
+			fd::Dispatcher dispatcher(thresholds);
+
+			Assert::IsTrue(dispatcher.chooseMethod(65535) == fd::Method::lookupTable);
+			Assert::IsTrue(dispatcher.chooseMethod(65536) == fd::Method::trialDivision);
+			Assert::IsTrue(dispatcher.chooseMethod(4294967295) == fd::Method::trialDivision);
+			Assert::IsTrue(dispatcher.chooseMethod(4294967296) == fd::Method::millerRabinRho);
+		}
+
+
+		//
+		// Test every method gives the same factors:
+		//
+		TEST_METHOD(MethodsAgree)
+		{
+			fd::DispatchThresholds trialOnly = fd::defaultThresholds();
+			trialOnly.lookupTableMaxBits = 0;
+			trialOnly.trialDivisionMaxBits = 64;
+			fd::DispatchThresholds rhoOnly = trialOnly;
+			rhoOnly.trialDivisionMaxBits = 0;
+
+			fd::Dispatcher defaultDispatcher, trialDispatcher(trialOnly), rhoDispatcher(rhoOnly);
+			const uint64_t numbers[] = { 2, 455, 65536, 1048573, 1000036000099, 5915587277, 6000216000594 };
+			for (auto n : numbers)
+			{
+				auto expected = trialDispatcher.factor(n, unlimited).primeFactors;
+				auto fromDefault = defaultDispatcher.factor(n, unlimited).primeFactors;
+				auto fromRho = rhoDispatcher.factor(n, unlimited).primeFactors;
+
+				Assert::AreEqual(expected.size(), fromDefault.size());
+				Assert::AreEqual(expected.size(), fromRho.size());
+				for (uint32_t i = 0; i < expected.size(); ++i)
+				{
+					Assert::AreEqual(expected[i], fromDefault[i]);
+					Assert::AreEqual(expected[i], fromRho[i]);
+				}
+			}
+		}
+
+
+		//
+		// Test counting does not change the result and sees the rho work on a large semiprime:
+		//
+		TEST_METHOD(CountedFactorMatches)
+		{
+			fd::Dispatcher dispatcher;
+			u::FactorCounters counters;
+			auto counted = dispatcher.factor(1000036000099, unlimited, counters);
+			auto uncounted = dispatcher.factor(1000036000099, unlimited);
+
+			Assert::IsTrue(counted.primeFactors == uncounted.primeFactors);
+			Assert::IsTrue(counters.rhoSteps > 0);
+			Assert::IsTrue(counters.millerRabinRounds > 0);
+		}
+
+
+		//
+		// Test thresholds survive a save/load round trip:
+		//
+		TEST_METHOD(SaveLoadThresholds)
+		{
+			fd::DispatchThresholds thresholds;
+			thresholds.lookupTableMaxBits = 12;
+			thresholds.preTrialBound = 512;
+			thresholds.trialDivisionMaxBits = 0;
+			fd::saveThresholds(thresholds, configFileName);
+
+			auto loaded = fd::loadThresholds(configFileName);
+			Assert::AreEqual(thresholds.lookupTableMaxBits, loaded.lookupTableMaxBits);
+			Assert::AreEqual(thresholds.preTrialBound, loaded.preTrialBound);
+			Assert::AreEqual(thresholds.trialDivisionMaxBits, loaded.trialDivisionMaxBits);
+		}
+
+
+		//
+		// Test unknown keys in a config file are rejected:
+		//
+		TEST_METHOD(LoadThresholds_UnknownKey)
+		{
+			{
+				ofstream file(configFileName);
+				file << "lookupTableMaxBit = 12" << endl;
+			}
+
+			try
+			{
+				fd::loadThresholds(configFileName);
+			}
+			catch (const std::exception& e)
+			{
+				// Correct exception, return.
+				return;
+			}
+
+			// No exception was thrown, test failure:
+			Assert::Fail(L"No exception for unknown key.", LINE_INFO());
+		}
+
+	};
+}
@@ -0,0 +1,123 @@
+///////////////////////////////////////
+///
+///	\file		FactorGeneratorLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		FactorGeneratorLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "FactorGeneratorLib.h"
+#include "UtilsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace fg = factor_generator;
+namespace u = utils;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(FactorGeneratorLibTests)
+	{
+	public:
+
+
+		//
+		// Test the generator yields the same factors as calculatePrimeFactors, in ascending order:
+		//	Note: One number per stage: table, pre-pass, trial division and rho.
+		//
+		TEST_METHOD(MatchesFullFactorization)
+		{
+			vector<uint64_t> numbers = { 2, 720720, 1000036000099, 4 * 9 * 1000003ull, 18446744073709551557ull, 9223372036854775807ull };
+			for (auto n : numbers)
+			{
+				vector<uint64_t> generated;
+				uint64_t factor = 0;
+				fg::FactorGenerator generator(n);
+				while (generator.next(factor)) generated.push_back(factor);
+
+				vector<uint64_t> expected = u::calculatePrimeFactors(n);
+				Assert::AreEqual(expected.size(), generated.size());
+				for (size_t i = 0; i < expected.size(); ++i) Assert::AreEqual(expected[i], generated[i]);
+				Assert::AreEqual(uint64_t(1), generator.getRemaining());
+			}
+		}
+
+
+		//
+		// Test the remaining product shrinks as factors are pulled:
+		//
+		TEST_METHOD(RemainingAfterEachFactor)
+		{
+			uint64_t factor = 0;
+			fg::FactorGenerator generator(2 * 3 * 1000003ull);
+
+			Assert::IsTrue(generator.next(factor));
+			Assert::AreEqual(uint64_t(2), factor);
+			Assert::AreEqual(uint64_t(3 * 1000003ull), generator.getRemaining());
+
+			Assert::IsTrue(generator.next(factor));
+			Assert::AreEqual(uint64_t(3), factor);
+			Assert::IsTrue(generator.next(factor));
+			Assert::AreEqual(uint64_t(1000003), factor);
+			Assert::IsFalse(generator.next(factor));
+			Assert::IsFalse(generator.next(factor));
+		}
+
+
+		//
+		// Test smallest prime factor queries:
+		//
+		TEST_METHOD(SmallestPrimeFactor)
+		{
+			Assert::AreEqual(uint64_t(0), fg::smallestPrimeFactor(1));
+			Assert::AreEqual(uint64_t(2), fg::smallestPrimeFactor(1024));
+			Assert::AreEqual(uint64_t(1000003), fg::smallestPrimeFactor(1000036000099));
+			Assert::AreEqual(uint64_t(18446744073709551557ull), fg::smallestPrimeFactor(18446744073709551557ull));
+		}
+
+
+		//
+		// Test smoothness queries:
+		//
+		TEST_METHOD(IsSmooth)
+		{
+			Assert::IsTrue(fg::isSmooth(1, 2));
+			Assert::IsTrue(fg::isSmooth(720720, 13));
+			Assert::IsFalse(fg::isSmooth(720720, 11));
+			Assert::IsTrue(fg::isSmooth(1000036000099, 1000033));
+			Assert::IsFalse(fg::isSmooth(1000036000099, 1000032));
+			Assert::IsFalse(fg::isSmooth(18446744073709551557ull, 1000));
+		}
+
+	};
+}
@@ -0,0 +1,316 @@
+///////////////////////////////////////
+///
+///	\file		FactorStoreLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		FactorStoreLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "FactorStoreLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace fs = factor_store;
+namespace u = utils;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(FactorStoreLibTests)
+	{
+	private:
+
+		//
+		// Variables to use in tests:
+		//
+		const string storePath = "factor_store_test.log";
+
+		//
+		// Helper to build a complete result:
+		//
+		static u::FactorResult makeResult(const vector<uint64_t>& primeFactors)
+		{
+			u::FactorResult result;
+			result.primeFactors = primeFactors;
+			result.cofactor = 1;
+			result.status = u::FactorStatus::complete;
+			return result;
+		}
+
+		//
+		// Helper to remove all store files:
+		//
+		void removeStore()
+		{
+			remove(storePath.c_str());
+			remove((storePath + ".idx").c_str());
+			remove((storePath + ".idx.tmp").c_str());
+		}
+
+	public:
+
+
+		//
+		// Initilization run BEFORE each TEST_METHOD:
+		//
+		TEST_METHOD_INITIALIZE(TestMethodInitialize)
+		{
+			removeStore();
+		}
+
+
+		//
+		// Cleanup run AFTER each TEST_METHOD:
+		//
+		TEST_METHOD_CLEANUP(TestMethodCleanUp)
+		{
+			removeStore();
+		}
+
+
+		//
+		// Test results survive closing and reopening the store:
+		//
+		TEST_METHOD(ReopenFindsResults)
+		{
+			{
+				fs::FactorStore store(storePath);
+				store.add(455, makeResult({ 5, 7, 13 }));
+				store.add(6000216000594, makeResult({ 2, 3, 1000003, 1000033 }));
+				store.close();
+			}
+
+			fs::FactorStore store(storePath);
+			u::FactorResult result;
+
+			Assert::AreEqual(size_t(2), store.size());
+			Assert::IsTrue(store.find(6000216000594, result));
+			Assert::AreEqual(size_t(4), result.primeFactors.size());
+			Assert::AreEqual(uint64_t(1000033), result.primeFactors[3]);
+			Assert::IsTrue(store.find(455, result));
+			Assert::AreEqual(uint64_t(13), result.primeFactors[2]);
+			Assert::IsFalse(store.find(456, result));
+		}
+
+
+		//
+		// Test partial results are not stored:
+		//
+		TEST_METHOD(PartialNotStored)
+		{
+			fs::FactorStore store(storePath);
+			u::FactorResult partial = makeResult({ 2, 3 });
+			partial.cofactor = 1000036000099;
+			partial.status = u::FactorStatus::compositeUnfactored;
+			store.add(6000216000594, partial);
+
+			u::FactorResult result;
+			Assert::IsFalse(store.find(6000216000594, result));
+		}
+
+
+		//
+		// Test a store whose index was lost is rebuilt from the log:
+		//
+		TEST_METHOD(RebuildMissingIndex)
+		{
+			{
+				fs::FactorStore store(storePath);
+				store.add(455, makeResult({ 5, 7, 13 }));
+			}
+			remove((storePath + ".idx").c_str());
+
+			fs::FactorStore store(storePath);
+			u::FactorResult result;
+			Assert::IsTrue(store.find(455, result));
+			Assert::AreEqual(size_t(3), result.primeFactors.size());
+		}
+
+
+		//
+		// Test a torn record at the end of the log is dropped:
+		//
+		TEST_METHOD(TornRecordDropped)
+		{
+			{
+				fs::FactorStore store(storePath);
+				store.add(455, makeResult({ 5, 7, 13 }));
+			}
+			{
+				ofstream log(storePath, ios::binary | ios::app);
+				log.write("\x01\x02\x03", 3);
+			}
+
+			{
+				fs::FactorStore store(storePath);
+				store.add(4, makeResult({ 2, 2 }));
+			}
+
+			fs::FactorStore store(storePath);
+			u::FactorResult result;
+			Assert::IsTrue(store.find(455, result));
+			Assert::IsTrue(store.find(4, result));
+			Assert::AreEqual(size_t(2), result.primeFactors.size());
+		}
+
+
+		//
+		// Test index entries pointing past the log or at another record are misses, not reads out of bounds:
+		//
+		TEST_METHOD(BadIndexOffsetIsMiss)
+		{
+			{
+				fs::FactorStore store(storePath);
+				store.add(4, makeResult({ 2, 2 }));
+				store.add(455, makeResult({ 5, 7, 13 }));
+			}
+
+			// Entries are sorted by number: 4's offset goes past the end, 455's points at 4's record:
+			{
+				fstream index(storePath + ".idx", ios::binary | ios::in | ios::out);
+				uint64_t offsets[2] = { 0, 0 };
+				index.seekg(24 + 8);
+				index.read(reinterpret_cast<char*>(&offsets[0]), 8);
+				index.seekg(24 + 16 + 8);
+				index.read(reinterpret_cast<char*>(&offsets[1]), 8);
+
+				uint64_t pastEnd = uint64_t(1) << 40;
+				index.seekp(24 + 8);
+				index.write(reinterpret_cast<const char*>(&pastEnd), 8);
+				index.seekp(24 + 16 + 8);
+				index.write(reinterpret_cast<const char*>(&offsets[0]), 8);
+			}
+
+			fs::FactorStore store(storePath);
+			u::FactorResult result;
+			Assert::IsFalse(store.find(4, result));
+			Assert::IsFalse(store.find(455, result));
+		}
+
+
+		//
+		// Test index entries into a tail cut off when the log is reopened are misses, not reads past the file:
+		//
+		TEST_METHOD(IndexIntoTruncatedTailIsMiss)
+		{
+			{
+				fs::FactorStore store(storePath);
+				store.add(4, makeResult({ 2, 2 }));
+				for (uint64_t n = 1001; n < 3000; n += 2) store.add(n, makeResult({ n }));
+			}
+
+			// The index only claims to cover 4's record, and the record after it is damaged so the rescan stops there:
+			const uint64_t covered = 8 + 12 + 16;
+			{
+				fstream index(storePath + ".idx", ios::binary | ios::in | ios::out);
+				index.seekp(16);
+				index.write(reinterpret_cast<const char*>(&covered), 8);
+
+				fstream log(storePath, ios::binary | ios::in | ios::out);
+				const uint32_t badCount = 0xffffffff;
+				log.seekp(covered + 8);
+				log.write(reinterpret_cast<const char*>(&badCount), 4);
+			}
+
+			fs::FactorStore store(storePath);
+			u::FactorResult result;
+			Assert::IsTrue(store.find(4, result));
+			Assert::IsFalse(store.find(1001, result));
+			Assert::IsFalse(store.find(2999, result));
+		}
+
+
+		//
+		// Test lookups from several threads while another one adds:
+		//
+		TEST_METHOD(ConcurrentFindAndAdd)
+		{
+			{
+				fs::FactorStore store(storePath);
+				for (uint64_t n = 2; n < 1000; n += 2) store.add(n, makeResult({ 2, n / 2 }));
+			}
+
+			fs::FactorStore store(storePath);
+			atomic<unsigned> wrong(0);
+			vector<thread> readers;
+			for (int t = 0; t < 3; ++t)
+			{
+				readers.push_back(thread([&]
+				{
+					u::FactorResult result;
+					for (uint64_t n = 2; n < 1000; n += 2)
+					{
+						if (!store.find(n, result) || (result.primeFactors[1] != n / 2)) ++wrong;
+					}
+				}));
+			}
+			for (uint64_t n = 1001; n < 2000; n += 2) store.add(n, makeResult({ n }));
+			for (auto& reader : readers) reader.join();
+
+			u::FactorResult result;
+			Assert::AreEqual(0u, wrong.load());
+			Assert::IsTrue(store.find(1999, result));
+			Assert::AreEqual(size_t(499 + 500), store.size());
+		}
+
+
+		//
+		// Test a file that is not a store is refused:
+		//
+		TEST_METHOD(NotAStore)
+		{
+			{
+				ofstream log(storePath);
+				log << "12" << endl << "455" << endl;
+			}
+
+			try
+			{
+				fs::FactorStore store(storePath);
+			}
+			catch (const std::exception& e)
+			{
+				// Correct exception, return.
+				return;
+			}
+
+			// No exception was thrown, test failure:
+			Assert::Fail(L"No exception for a file that is not a store.", LINE_INFO());
+		}
+
+	};
+}
@@ -45,6 +45,7 @@ const char PATH_SEPARATOR = '/';
 #include <string>
 #include <memory>
 #include <iostream>
+#include <vector>
 
 
 //
@@ -192,12 +193,43 @@ namespace primefactorstests
 			auto& contents = safeFileParser->getContents();
 
 			// Do some spot checks of values that came from file:
-			Assert::AreEqual(string("#"),					contents[0]);
-			Assert::AreEqual(string("10"),					contents[14]);
-			Assert::AreEqual(string("dlfksdjf98y23rn2"),	contents[26]);
-			Assert::AreEqual(string("3498"),				contents[41]);
-			Assert::AreEqual(string("#@@@@!!!@#@@#W"),		contents[49]);
-			Assert::AreEqual(string("P"),					contents[55]);
+			Assert::AreEqual(string("#"),					contents[0].str());
+			Assert::AreEqual(string("10"),					contents[14].str());
+			Assert::AreEqual(string("dlfksdjf98y23rn2"),	contents[26].str());
+			Assert::AreEqual(string("3498"),				contents[41].str());
+			Assert::AreEqual(string("#@@@@!!!@#@@#W"),		contents[49].str());
+			Assert::AreEqual(string("P"),					contents[55].str());
+		}
+
+
+		//
+		// Test line splitting of the arena:
+		//	Note: Same rules as std::getline, a missing final newline still ends a line and empty lines are kept.
+		//
+		TEST_METHOD(LineArenaSplit)
+		{
+			string text = "12\n\nabc\n7";
+			fp::LineArena arena;
+			arena.assign(vector<char>(text.begin(), text.end()));
+
+			Assert::AreEqual(size_t(4), arena.size());
+			Assert::AreEqual(string("12"), arena[0].str());
+			Assert::IsTrue(arena[1].empty());
+			Assert::AreEqual(string("abc"), arena[2].str());
+			Assert::AreEqual(string("7"), arena[3].str());
+
+			// Iteration gives the same lines in order:
+			size_t index = 0;
+			for (auto line : arena)
+			{
+				Assert::AreEqual(arena[index].str(), line.str());
+				++index;
+			}
+			Assert::AreEqual(size_t(4), index);
+
+			// Empty text has no lines:
+			arena.assign(vector<char>());
+			Assert::IsTrue(arena.empty());
 		}
 
 	};
@@ -0,0 +1,158 @@
+///////////////////////////////////////
+///
+///	\file		NumaLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		NumaLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "NumaLib.h"
+#include "FactorAlgorithmsLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace nu = numa;
+namespace fa = factor_algorithms;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(NumaLibTests)
+	{
+	public:
+
+
+		//
+		// Test CPU lists in the formats sysfs writes, and that bad ones throw:
+		//
+		TEST_METHOD(ParseCpuList)
+		{
+			Assert::IsTrue(vector<unsigned>({ 0, 1, 2, 3, 8, 10, 11 }) == nu::parseCpuList("0-3,8,10-11\n"));
+			Assert::IsTrue(vector<unsigned>({ 5 }) == nu::parseCpuList("5"));
+			Assert::IsTrue(nu::parseCpuList("\n").empty());
+
+			for (const char* bad : { "1-", "3-1", "0,,1", "0,", "a", "0 1" })
+			{
+				try
+				{
+					nu::parseCpuList(bad);
+				}
+				catch (const runtime_error&)
+				{
+					continue;
+				}
+				Assert::Fail(L"Invalid CPU list was accepted.", LINE_INFO());
+			}
+		}
+
+
+		//
+		// Test one hardware thread of every core comes before any second thread, whichever way siblings are numbered:
+		//
+		TEST_METHOD(OrderByCore)
+		{
+			// Siblings numbered next to each other:
+			vector<vector<unsigned>> adjacent({ { 0, 1 }, { 0, 1 }, { 2, 3 }, { 2, 3 } });
+			Assert::IsTrue(vector<unsigned>({ 0, 2, 1, 3 }) == nu::orderByCore({ 0, 1, 2, 3 }, adjacent));
+
+			// Siblings numbered a core count apart are already in order:
+			vector<vector<unsigned>> apart({ { 0, 2 }, { 1, 3 }, { 0, 2 }, { 1, 3 } });
+			Assert::IsTrue(vector<unsigned>({ 0, 1, 2, 3 }) == nu::orderByCore({ 0, 1, 2, 3 }, apart));
+
+			// A sibling outside the affinity mask leaves the other thread first on its core:
+			vector<vector<unsigned>> masked({ { 0, 1 }, { 2, 3 }, { 2, 3 } });
+			Assert::IsTrue(vector<unsigned>({ 1, 2, 3 }) == nu::orderByCore({ 1, 2, 3 }, masked));
+		}
+
+
+		//
+		// Test workers take the nodes in turn, then the CPUs of each node, and wrap around:
+		//
+		TEST_METHOD(PlaceWorkers)
+		{
+			nu::Topology topology;
+			topology.nodeCpus.push_back(vector<unsigned>({ 0, 1, 2 }));
+			topology.nodeCpus.push_back(vector<unsigned>({ 4, 5 }));
+
+			const unsigned expectedNodes[] = { 0, 1, 0, 1, 0, 1, 0 };
+			const unsigned expectedCpus[] = { 0, 4, 1, 5, 2, 4, 0 };
+			for (unsigned worker = 0; worker < 7; ++worker)
+			{
+				nu::Placement placement = nu::placeWorker(topology, worker);
+				Assert::AreEqual(expectedNodes[worker], placement.node);
+				Assert::AreEqual(expectedCpus[worker], placement.cpu);
+			}
+
+			// The machine has at least one node with a CPU:
+			Assert::IsTrue(nu::nodeCount() >= 1);
+			Assert::IsTrue(nu::currentNode() < nu::nodeCount());
+		}
+
+
+		//
+		// Test large buffers are zeroed and writable however they are backed:
+		//
+		TEST_METHOD(LargePageBufferZeroed)
+		{
+			for (size_t bytes : { size_t(100), size_t(3) << 20 })
+			{
+				nu::LargePageBuffer buffer(bytes);
+				Assert::AreEqual(bytes, buffer.size());
+
+				const char* data = static_cast<const char*>(buffer.data());
+				Assert::IsTrue((data[0] == 0) && (data[bytes / 2] == 0) && (data[bytes - 1] == 0));
+				memset(buffer.data(), 0x5a, bytes);
+				Assert::AreEqual('\x5a', data[bytes - 1]);
+			}
+		}
+
+
+		//
+		// Test every node's replica of the smallest-factor table is built and gives the same answers:
+		//
+		TEST_METHOD(TableReplicas)
+		{
+			auto& table = fa::SmallestFactorTable::instance();
+			auto& lastNodeTable = fa::SmallestFactorTable::instance(1000);
+			Assert::IsTrue(&lastNodeTable == &fa::SmallestFactorTable::instance(nu::nodeCount() - 1));
+
+			for (uint64_t n : { uint64_t(2), uint64_t(1021 * 1021), uint64_t(1048573), uint64_t(1048574) })
+			{
+				Assert::AreEqual(table.smallestFactor(n), lastNodeTable.smallestFactor(n));
+			}
+		}
+
+	};
+}
@@ -0,0 +1,241 @@
+///////////////////////////////////////
+///
+///	\file		PipelineLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		PipelineLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "PipelineLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace aio = async_io;
+namespace pl = pipeline;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(PipelineLibTests)
+	{
+	private:
+
+		//
+		// Source of unitCount units with linesPerUnit numbered lines each:
+		//
+		static pl::Pipeline::Source makeSource(uint64_t unitCount, uint64_t linesPerUnit)
+		{
+			auto nextLine = make_shared<uint64_t>(0);
+			return [=](aio::LineBlock& block)
+			{
+				block.lines.clear();
+				for (uint64_t i = 0; (i < linesPerUnit) && (*nextLine < unitCount * linesPerUnit); ++i)
+				{
+					block.lines.push_back(to_string((*nextLine)++));
+				}
+				return !block.lines.empty();
+			};
+		}
+
+	public:
+
+
+		//
+		// Test the queue is first in, first out and drains after close:
+		//
+		TEST_METHOD(BoundedQueueOrder)
+		{
+			pl::BoundedQueue<int> queue(4);
+			for (int i = 0; i < 3; ++i) Assert::IsTrue(queue.push(i));
+			queue.close();
+
+			int item = 3;
+			Assert::IsFalse(queue.push(item));
+			for (int i = 0; i < 3; ++i)
+			{
+				Assert::IsTrue(queue.pop(item));
+				Assert::AreEqual(i, item);
+			}
+			Assert::IsFalse(queue.pop(item));
+		}
+
+
+		//
+		// Test ordered mode gives units back in input order even when early units finish last:
+		//
+		TEST_METHOD(OrderedCollect)
+		{
+			pl::Pipeline pipeline(4, true, makeSource(50, 3), [](unsigned, pl::WorkUnit& unit)
+			{
+				if ((unit.sequence % 7) == 0) this_thread::sleep_for(chrono::milliseconds(2));
+				for (auto& line : unit.block.lines) unit.output += line + "\n";
+			});
+
+			pl::WorkUnit unit;
+			uint64_t expectedSequence = 0;
+			string allOutput;
+			while (pipeline.collect(unit))
+			{
+				Assert::AreEqual(expectedSequence, unit.sequence);
+				Assert::AreEqual(expectedSequence * 3 + 1, unit.firstLineNumber);
+				allOutput += unit.output;
+				++expectedSequence;
+			}
+
+			Assert::AreEqual(uint64_t(50), expectedSequence);
+			Assert::AreEqual(string("0\n1\n2\n3\n"), allOutput.substr(0, 8));
+		}
+
+
+		//
+		// Test unordered mode gives every unit back exactly once:
+		//
+		TEST_METHOD(UnorderedCollect)
+		{
+			pl::Pipeline pipeline(3, false, makeSource(40, 5), [](unsigned, pl::WorkUnit& unit)
+			{
+				if (unit.sequence == 0) this_thread::sleep_for(chrono::milliseconds(20));
+				unit.output = to_string(unit.sequence);
+			});
+
+			pl::WorkUnit unit;
+			set<uint64_t> seen;
+			while (pipeline.collect(unit)) Assert::IsTrue(seen.insert(unit.sequence).second);
+
+			Assert::AreEqual(size_t(40), seen.size());
+		}
+
+
+		//
+		// Test each worker runs its start hook once, before its first unit:
+		//
+		TEST_METHOD(WorkerStartRunsFirst)
+		{
+			const unsigned workerCount = 3;
+			unique_ptr<atomic<unsigned>[]> starts(new atomic<unsigned>[workerCount]);
+			for (unsigned worker = 0; worker < workerCount; ++worker) starts[worker] = 0;
+			atomic<unsigned> unitsBeforeStart(0);
+
+			{
+				pl::Pipeline pipeline(workerCount, true, makeSource(30, 2), [&](unsigned worker, pl::WorkUnit&)
+				{
+					if (starts[worker] == 0) ++unitsBeforeStart;
+				}, nullptr, [&](unsigned worker) { ++starts[worker]; });
+
+				pl::WorkUnit unit;
+				while (pipeline.collect(unit)) {}
+			}
+
+			for (unsigned worker = 0; worker < workerCount; ++worker) Assert::AreEqual(1u, starts[worker].load());
+			Assert::AreEqual(0u, unitsBeforeStart.load());
+		}
+
+
+		//
+		// Test a worker error comes out of collect():
+		//
+		TEST_METHOD(WorkerErrorRethrown)
+		{
+			pl::Pipeline pipeline(2, true, makeSource(100, 1), [](unsigned, pl::WorkUnit& unit)
+			{
+				if (unit.sequence == 10) throw runtime_error("boom");
+			});
+
+			try
+			{
+				pl::WorkUnit unit;
+				while (pipeline.collect(unit)) {}
+			}
+			catch (const runtime_error&)
+			{
+				// Correct exception, return.
+				return;
+			}
+
+			// No exception was thrown, test failure:
+			Assert::Fail(L"Worker error was not rethrown.", LINE_INFO());
+		}
+
+
+		//
+		// Test the budget admits an oversized request when empty and wakes waiters on release and cancel:
+		//
+		TEST_METHOD(MemoryBudgetAcquireRelease)
+		{
+			pl::MemoryBudget budget(100);
+			Assert::IsTrue(budget.acquire(250));
+			Assert::AreEqual(size_t(250), budget.getBytesUsed());
+
+			thread releaser([&] { this_thread::sleep_for(chrono::milliseconds(10)); budget.release(250); });
+			Assert::IsTrue(budget.acquire(60));
+			releaser.join();
+			Assert::AreEqual(size_t(60), budget.getBytesUsed());
+			Assert::AreEqual(size_t(250), budget.getPeakBytes());
+
+			thread canceller([&] { this_thread::sleep_for(chrono::milliseconds(10)); budget.cancel(); });
+			Assert::IsFalse(budget.acquire(60));
+			canceller.join();
+		}
+
+
+		//
+		// Test a slow collector holds the input back to the budget instead of the in-flight limit:
+		//
+		TEST_METHOD(BudgetBoundsInFlightBytes)
+		{
+			const size_t maxBytes = 1024;
+			pl::MemoryBudget budget(maxBytes);
+			pl::Pipeline pipeline(4, true, makeSource(200, 8), [](unsigned, pl::WorkUnit&) {}, &budget);
+
+			pl::WorkUnit unit;
+			uint64_t collected = 0;
+			while (pipeline.collect(unit))
+			{
+				this_thread::sleep_for(chrono::microseconds(200));
+				budget.release(unit.chargedBytes);
+				++collected;
+			}
+
+			// Empty outputs only add their small inline capacity on top of the input lines:
+			Assert::AreEqual(uint64_t(200), collected);
+			Assert::AreEqual(size_t(0), budget.getBytesUsed());
+			Assert::IsTrue(budget.getPeakBytes() <= maxBytes + 16 * sizeof(string));
+		}
+
+	};
+}
@@ -0,0 +1,133 @@
+///////////////////////////////////////
+///
+///	\file		ProgressLibTests.cpp
+///	\author		J. Caleb Wherry
+///	\date		2/11/2015
+///	\brief		ProgressLib unit tests
+///
+///	\notes
+///		1. Even though this testing framework is specific to Visual Studio, all tests have
+///			been created with portability in mind so that the details could easily be
+///			transferred and work in a different testing framework.
+///////////////////////////////////////
+
+
+//
+// Test & VS includes:
+//
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+
+//
+// Local includes:
+//
+#include "ProgressLib.h"
+
+
+//
+// Compiler includes:
+//
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+
+//
+// Namspaces:
+//
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+namespace pr = progress;
+
+
+//
+// Test namespace:
+//
+namespace primefactorstests
+{
+	TEST_CLASS(ProgressLibTests)
+	{
+	private:
+
+		//
+		// Helper to build a sample:
+		//
+		static pr::ProgressSample makeSample(uint64_t lines, uint64_t bytes, double seconds)
+		{
+			pr::ProgressSample sample;
+			sample.lines = lines;
+			sample.bytes = bytes;
+			sample.seconds = seconds;
+			return sample;
+		}
+
+	public:
+
+
+		//
+		// Test rates, share of the file and time left:
+		//
+		TEST_METHOD(FormatKnownSize)
+		{
+			string report = pr::formatProgress(makeSample(1000, 2500, 10), makeSample(3000, 5000, 20), 20000);
+			Assert::AreEqual(string("progress: 3000 lines, 25.0% of 20000 bytes, 200 lines/s now, 150 lines/s average, 0:01:00 left"), report);
+		}
+
+
+		//
+		// Test a resumed run shows the whole file's share but rates and time left from the resume point only:
+		//
+		TEST_METHOD(FormatResumed)
+		{
+			pr::ProgressSample start = makeSample(10000, 10000, 0);
+			string report = pr::formatProgress(start, makeSample(12000, 12500, 10), 20000, start);
+			Assert::AreEqual(string("progress: 12000 lines, 62.5% of 20000 bytes, 200 lines/s now, 200 lines/s average, 0:00:30 left"), report);
+		}
+
+
+		//
+		// Test an input of unknown size leaves out the share and the time left:
+		//
+		TEST_METHOD(FormatUnknownSize)
+		{
+			string report = pr::formatProgress(makeSample(0, 0, 0), makeSample(500, 4000, 2), 0);
+			Assert::AreEqual(string("progress: 500 lines, 4000 bytes, 250 lines/s now, 250 lines/s average"), report);
+		}
+
+
+		//
+		// Test a requested report lands in the stats file with the counters at that time:
+		//
+		TEST_METHOD(RequestedReportToStatsFile)
+		{
+			const string statsFileName = "progress-test-stats.txt";
+			remove(statsFileName.c_str());
+
+			pr::ProgressCounters counters;
+			counters.add(40, 400);
+			counters.add(2, 20);
+			Assert::AreEqual(uint64_t(42), counters.getLines());
+			Assert::AreEqual(uint64_t(420), counters.getBytes());
+
+			{
+				pr::ProgressReporter reporter(counters, 840, chrono::milliseconds(0), statsFileName);
+				reporter.requestReport();
+				this_thread::sleep_for(chrono::milliseconds(200));
+			}
+
+			// Reports on request only, so no final one:
+			ifstream statsFile(statsFileName);
+			string line;
+			Assert::IsTrue(static_cast<bool>(getline(statsFile, line)));
+			Assert::AreEqual(0, line.compare(0, 32, "progress: 42 lines, 50.0% of 840"));
+			Assert::IsFalse(static_cast<bool>(getline(statsFile, line)));
+
+			statsFile.close();
+			remove(statsFileName.c_str());
+		}
+
+	};
+}
@@ -28,6 +28,7 @@
 //
 // Compiler includes:
 //
+#include <limits>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -214,6 +215,29 @@ namespace primefactorstests
 		}
 
 
+		//
+		// Test converting characters in place stops at their end and keeps the int64_t limits:
+		//
+		TEST_METHOD(ConvertStrToLL_InPlace)
+		{
+			bool conversionFailed = false;
+			int64_t convertedNumber = 0;
+
+			// Only the first 4 characters belong to the number:
+			const char line[] = "455912";
+			tie(conversionFailed, convertedNumber) = u::convertStrToLL(line, 4);
+			Assert::AreEqual(false, conversionFailed);
+			Assert::AreEqual(to_string(4559ll), to_string(convertedNumber));
+
+			tie(conversionFailed, convertedNumber) = u::convertStrToLL(" -9223372036854775808", 21);
+			Assert::AreEqual(false, conversionFailed);
+			Assert::AreEqual(to_string(numeric_limits<int64_t>::min()), to_string(convertedNumber));
+
+			tie(conversionFailed, convertedNumber) = u::convertStrToLL("9223372036854775808", 19);
+			Assert::AreEqual(true, conversionFailed);
+		}
+
+
 		//
 		// Test calculating prime factors of 1:
 		//	Note: 1, by definition, has zero prime factors.
@@ -337,5 +361,90 @@ namespace primefactorstests
 			}
 		}
 
+
+
+		//
+		// Test calculating prime factors of 5915587277 with an iteration budget that runs out:
+		//	Note: prime, the leftover cofactor is recognized as prime so the result is still complete.
+		//
+		TEST_METHOD(PrimeFactorsOf_5915587277_IterationBudget)
+		{
+			// Calculate prime factors:
+			auto factorResult = u::calculatePrimeFactors(5915587277, u::FactorBudget(10));
+
+			Assert::IsTrue(factorResult.status == u::FactorStatus::complete);
+			Assert::AreEqual(size_t(1), factorResult.primeFactors.size());
+			Assert::AreEqual(uint64_t(5915587277), factorResult.primeFactors[0]);
+			Assert::AreEqual(uint64_t(1), factorResult.cofactor);
+		}
+
+
+		//
+		// Test calculating prime factors of 2 * 3 * 1000003 * 1000033 with an iteration budget that runs out:
+		//	Note: Small factors found before the budget runs out are kept, the rest is a known composite.
+		//
+		TEST_METHOD(PrimeFactorsOf_6000216000594_IterationBudget)
+		{
+			// Calculate prime factors:
+			auto factorResult = u::calculatePrimeFactors(6000216000594, u::FactorBudget(10));
+			vector<uint64_t> actualPrimeFactors = { 2, 3 };
+
+			Assert::IsTrue(factorResult.status == u::FactorStatus::compositeUnfactored);
+			Assert::AreEqual(uint64_t(1000036000099), factorResult.cofactor);
+
+			// Make sure sizes are the same:
+			Assert::AreEqual(actualPrimeFactors.size(), factorResult.primeFactors.size());
+
+			// Loop through and test all factors:
+			for (uint32_t i = 0; i < factorResult.primeFactors.size(); ++i)
+			{
+				Assert::AreEqual(actualPrimeFactors[i], factorResult.primeFactors[i]);
+			}
+		}
+
+
+		//
+		// Test calculating prime factors of 2 * 3 * 1000003 * 1000033 without a budget:
+		//	Note: Balanced semiprime residual, split by rho.
+		//
+		TEST_METHOD(PrimeFactorsOf_6000216000594)
+		{
+			// Calculate prime factors:
+			auto& primeFactors = u::calculatePrimeFactors(6000216000594);
+			vector<uint64_t> actualPrimeFactors = { 2, 3, 1000003, 1000033 };
+
+			// Make sure sizes are the same:
+			Assert::AreEqual(actualPrimeFactors.size(), primeFactors.size());
+
+			// Loop through and test all factors:
+			for (uint32_t i = 0; i < primeFactors.size(); ++i)
+			{
+				Assert::AreEqual(actualPrimeFactors[i], primeFactors[i]);
+			}
+		}
+
+
+		//
+		// Test calculating prime factors of 455 with a budget that is big enough:
+		//
+		TEST_METHOD(PrimeFactorsOf_455_Budget)
+		{
+			// Calculate prime factors:
+			auto factorResult = u::calculatePrimeFactors(455, u::FactorBudget(100, 1000));
+			vector<uint64_t> actualPrimeFactors = { 5, 7, 13 };
+
+			Assert::IsTrue(factorResult.status == u::FactorStatus::complete);
+			Assert::AreEqual(uint64_t(1), factorResult.cofactor);
+
+			// Make sure sizes are the same:
+			Assert::AreEqual(actualPrimeFactors.size(), factorResult.primeFactors.size());
+
+			// Loop through and test all factors:
+			for (uint32_t i = 0; i < factorResult.primeFactors.size(); ++i)
+			{
+				Assert::AreEqual(actualPrimeFactors[i], factorResult.primeFactors[i]);
+			}
+		}
+
 	};
 }
\ No newline at end of file
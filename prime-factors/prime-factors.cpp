@@ -11,12 +11,49 @@
 ///		2. Prime factors will only be from Z+ \ {1}.
 ///		3. We chose to design this app by seperating the file IO from the prime factors generation. This leads to
 ///			a better ability to test the individual components and decouples the two activites making them completely
-///			non-dependent. This also allows us to easily use RAII when dealing with file IO. However, this design
-///			could potentially be a problem if the size of the input file becomes massive. Inlining the prime factor
-///			generation with the file IO would allow for the processing of vey large files whereas we are currently limited
-///			to the amount of data we can hold in the vector containing the file contents.
+///			non-dependent. This also allows us to easily use RAII when dealing with file IO. The input is streamed in
+///			blocks by async_io::BlockReader and the output is drained by async_io::AsyncWriter, each on its own I/O
+///			thread, so reading the next block and writing the previous one overlap with factoring the current one
+///			and memory use no longer depends on the size of the input file.
 ///     4. We chose to make one slight modification to the given requirements: the number that is being factored is output to
 ///         the console followed by a colon then a comma-separated list of the prime factors, not just the factors themselves.
+///     5. '--max-ms-per-number <ms>' caps the time spent on each number. Numbers that run out of time are printed with
+///         the factors found so far followed by ' | composite, unfactored: <cofactor>' so one pathological line cannot
+///         stall the rest of the file. Leftovers are always tested for primality, a prime one is listed as a factor.
+///     6. Each number is factored with the method factor_dispatch::Dispatcher picks for its size. '--calibrate <file>'
+///         measures the crossover points on this machine and saves them, '--dispatch-config <file>' uses them.
+///     7. Repeated numbers are only factored once: the factorization of recently seen numbers is kept in a table capped
+///         at '--dedupe-memory <bytes>' (default 64M, 0 disables it) and copied to every later line with the same number.
+///     8. '--store <file>' keeps complete factorizations on disk (see FactorStoreLib.h). Numbers already in the store are
+///         not factored again and new results are added to it, so reruns over overlapping inputs only pay for new numbers.
+///     9. '--batch-gcd' does not factor anything: it runs Bernstein's batch gcd (see BatchGcdLib.h) over all numbers in the
+///         file and prints every number that shares a factor with another one as '<number>: <shared factor>, <cofactor>'.
+///         Every copy of a repeated number is printed, and one that shares nothing else has itself as the shared factor.
+///     10. Lines are factored by '--threads <count>' worker threads (default: one per hardware thread) in units of
+///         consecutive lines (see PipelineLib.h), and output is still written in input order. With '--unordered' each
+///         unit is written as soon as it is done and every line is prefixed with its input line number and a tab, so
+///         a slow number only holds back the few lines of its own unit.
+///     11. '--max-memory <bytes>' (K, M or G suffixes, default 0 for no limit) caps the lines and output held between
+///         reading and writing: queued units, units being factored and the reorder buffer. Once it is reached the
+///         reader waits, so a slow consumer of the output holds the input back instead of growing memory. The block
+///         the reader prefetches, the block being written, the dedupe table and the store come on top of it.
+///     12. '--progress <seconds>' reports lines done, the share of the input file read, current and average lines per
+///         second and the time left to stderr at that interval (see ProgressLib.h). SIGUSR1 asks for a report at any
+///         time, even without '--progress'. '--progress-file <file>' appends the reports to that file instead.
+///     13. '--stats' counts the trial divisions, rho steps, gcds and Miller-Rabin rounds of every number factored and
+///         prints the totals, the average per number and the number that took the most work to stderr at the end.
+///         Without it the factoring code is the uncounted instantiation, so the counters cost nothing.
+///     14. The input file may be gzip or zstd compressed, it is decompressed while it is read (see CompressedInputLib.h).
+///         BGZF and zstd input is decompressed by '--threads' worker threads. Progress reports then show bytes read
+///         instead of the share of the file, and the decompression buffers come on top of '--max-memory'.
+///     15. '--output <file>' writes the results to a file instead of stdout. With '--checkpoint <file>' as well, the
+///         input bytes consumed and the output length of the last result written are saved every 10 seconds (see
+///         CheckpointLib.h). After the run was killed, the same command with '--resume' cuts the output back to
+///         the checkpoint, skips the input already done and carries on. Without a checkpoint '--resume' starts from
+///         the beginning, so a restart loop can always pass it. Checkpoints need the output in input order.
+///     16. '--pin-threads' pins each worker to one CPU, taking the NUMA nodes in turn (see NumaLib.h), so the workers
+///         on every socket keep reading their own node's copy of the factoring tables. The tables are backed by huge
+///         pages whether or not the workers are pinned. Where pinning is not supported the workers run unpinned.
 ///
 ///////////////////////////////////////
 
@@ -25,18 +62,33 @@
 // Local includes:
 //
 #include "UtilsLib.h"
+#include "AsyncIOLib.h"
+#include "FactorDispatchLib.h"
+#include "DedupeLib.h"
+#include "FactorStoreLib.h"
 #include "FileParserLib.h"
+#include "BatchGcdLib.h"
+#include "PipelineLib.h"
+#include "ProgressLib.h"
+#include "CheckpointLib.h"
+#include "NumaLib.h"
 
 
 //
 // Compiler includes:
 //
+#include <chrono>
 #include <exception>
 #include <stdint.h>
 #include <string>
 #include <fstream>
 #include <iostream>
 #include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
 
 
 //
@@ -44,17 +96,116 @@
 //
 using namespace std;
 namespace u  = utils;
+namespace aio = async_io;
+namespace fd = factor_dispatch;
+namespace dd = dedupe;
+namespace fs = factor_store;
 namespace fp = file_parser;
+namespace bg = batch_gcd;
+namespace pl = pipeline;
+namespace pr = progress;
+namespace ck = checkpoint;
+namespace nu = numa;
+
+
+//
+// Types:
+//
+
+/// Options given on the command line.
+struct CommandLineOptions
+{
+    string inFileName;                  ///< Input file to factor
+    u::FactorBudget budget;             ///< Per-number work limit (--max-ms-per-number)
+    string dispatchConfigFileName;      ///< Calibrated dispatch thresholds to load (--dispatch-config)
+    string calibrateFileName;           ///< Calibrate dispatch thresholds, save them here and exit (--calibrate)
+    size_t dedupeMemory;                ///< Memory cap of the repeated-number table (--dedupe-memory)
+    string storePath;                   ///< Persistent factorization store shared between runs (--store)
+    bool batchGcd;                      ///< Only look for factors shared between the numbers (--batch-gcd)
+    unsigned threadCount;               ///< Worker threads (--threads)
+    bool unordered;                     ///< Write results as they finish, tagged with their line number (--unordered)
+    size_t maxMemory;                   ///< Memory cap of the lines and output in flight, 0 for none (--max-memory)
+    unsigned progressSeconds;           ///< Seconds between progress reports, 0 for on SIGUSR1 only (--progress)
+    string progressFileName;            ///< File to append progress reports to instead of stderr (--progress-file)
+    bool stats;                         ///< Count the work done by the factoring algorithms (--stats)
+    string outFileName;                 ///< File to write results to instead of stdout (--output)
+    string checkpointFileName;          ///< File to save the position of the run to (--checkpoint)
+    bool resume;                        ///< Continue from the checkpoint if there is one (--resume)
+    bool pinThreads;                    ///< Pin workers to CPUs spread over the NUMA nodes (--pin-threads)
+
+    /// Default constructor:
+    CommandLineOptions() : dedupeMemory(64 << 20), batchGcd(false), threadCount(thread::hardware_concurrency()), unordered(false),
+                           maxMemory(0), progressSeconds(0), stats(false), resume(false), pinThreads(false)
+    {
+        // hardware_concurrency() may not know:
+        if (threadCount == 0) threadCount = 1;
+    }
+};
+
+
+/// Work counted by one worker for '--stats'.
+struct FactorStats
+{
+    uint64_t numbersFactored;           ///< Numbers actually factored (not taken from the dedupe table or store)
+    u::FactorCounters total;            ///< Work of all of them
+    uint64_t heaviestNumber;            ///< Number that took the most work
+    u::FactorCounters heaviest;         ///< Work of heaviestNumber
+
+    /// Default constructor:
+    FactorStats() : numbersFactored(0), heaviestNumber(0) {}
+};
+
+
+//
+// Constants:
+//
+
+/// Lines per work unit, small in unordered mode so a slow number delays few others.
+const size_t orderedLinesPerUnit = 4096;
+const size_t unorderedLinesPerUnit = 64;
+
+/// Time between checkpoints.
+const chrono::seconds checkpointInterval(10);
+
+/// Shards of the dedupe table shared by the workers, enough that they rarely wait on the same lock.
+const size_t dedupeShardCount = 64;
 
 
 //
 // Function prototypes:
 //
 
-/// Function to print out prime factors in specific format given a vector.
-void printPrimeFactors (
-    uint64_t, 
-    const vector<uint64_t>&
+/// Function to get the value following option argv[i], throws if there is none.
+string getOptionValue (
+    int,
+    char*[],
+    int&
+);
+
+/// Function to parse a byte count with an optional K, M or G suffix, throws on invalid input.
+size_t parseByteSize (
+    const string&,
+    const string&
+);
+
+/// Function to parse the command line into options, throws on invalid input.
+CommandLineOptions parseCommandLine (
+    int,
+    char*[],
+    const string&
+);
+
+/// Function to print the totals of the workers' '--stats' counters.
+void printFactorStats (
+    ostream&,
+    const vector<FactorStats>&
+);
+
+/// Function to append prime factors in specific format given a factorization result to an output buffer.
+void formatPrimeFactors (
+    string&,
+    uint64_t,
+    const u::FactorResult&
 );
 
 
@@ -76,51 +227,213 @@ int main(int argc, char* argv[]) try
     for (uint64_t i = 0; i < appName.size(); ++i) cout << "=";
     cout << endl << appName << endl;
     for (uint64_t i = 0; i < appName.size(); ++i) cout << "=";
-    cout << endl << endl
-         << "<number>: <CSV of prime factors>" << endl
-         << "--------------------------------" << endl;
+    cout << endl << endl;
 
 
     //
-    // Check number of CLI options:
+    // Parse CLI options:
     //
-    if (argc != 2)
+    CommandLineOptions options = parseCommandLine(argc, argv, appName);
+    if (options.batchGcd)
     {
-        // Throw exception since this application only accepts 1 argument:
-        //		Note: We perform the 'minus 1' since argc includes the executable name we are running in its value.
-        throw runtime_error(string("Error: '" + appName + "' takes only 1 CLI option, ") + to_string(argc-1) + string(" given; aborting."));
+        cout << "<number>: <shared factor>, <cofactor>" << endl
+             << "-------------------------------------" << endl;
+    }
+    else if (options.unordered)
+    {
+        cout << "<line>\t<number>: <CSV of prime factors>" << endl
+             << "---------------------------------------" << endl;
+    }
+    else
+    {
+        cout << "<number>: <CSV of prime factors>" << endl
+             << "--------------------------------" << endl;
     }
 
 
     //
-    // Use first CLI option and parse file to get contents:
+    // Calibration run: measure dispatch thresholds on this machine, save them and exit:
     //
-    string inFileName = string(argv[1]);
-    fp::FileParser fileParser(inFileName);
-    auto fileContents = fileParser.getContents();
+    if (!options.calibrateFileName.empty())
+    {
+        auto thresholds = fd::calibrateThresholds();
+        fd::saveThresholds(thresholds, options.calibrateFileName);
+
+        cout << "lookupTableMaxBits = " << thresholds.lookupTableMaxBits << endl
+             << "preTrialBound = " << thresholds.preTrialBound << endl
+             << "trialDivisionMaxBits = " << thresholds.trialDivisionMaxBits << endl
+             << endl << appName << ": calibration saved to '" << options.calibrateFileName << "'." << endl << endl;
+        return 0;
+    }
+
+
+    //
+    // Results go to '--output' if given. A resumed run cuts it back to the checkpoint and appends:
+    //	Note: The file is binary so the bytes written are exactly the bytes counted for the checkpoint.
+    //
+    ck::Position start;
+    unique_ptr<ofstream> outFile;
+    if (!options.outFileName.empty())
+    {
+        ios::openmode mode = ios::binary | ios::trunc;
+        if (options.resume && ck::hasCheckpoint(options.checkpointFileName))
+        {
+            start = ck::loadCheckpoint(options.checkpointFileName);
+            ck::rewindOutput(options.outFileName, start);
+            mode = ios::binary | ios::app;
+        }
+
+        outFile.reset(new ofstream(options.outFileName, mode));
+        if (!outFile->is_open())
+        {
+            throw runtime_error(string("Error: Problem(s) occured while trying to open the file: '") + options.outFileName + string("'; aborting."));
+        }
+    }
+    ostream& output = outFile ? *outFile : cout;
 
 
     //
-    // Iterate through all lines, convert, get prime factors, and print results to screen:
+    // Batch gcd run: the whole input is needed at once, report numbers sharing a factor and exit:
     //
-    for (auto& line : fileContents)
+    if (options.batchGcd)
     {
-        // Convert string to int64_t:
-        bool conversionFailed = false;
-        int64_t numberToFactor = 0;
-        tie(conversionFailed, numberToFactor) = u::convertStrToLL(line);
+        fp::FileParser parser(options.inFileName, options.threadCount);
+        vector<uint64_t> numbers;
+        for (auto line : parser.getContents())
+        {
+            // Same filtering as the factoring loop below:
+            bool conversionFailed = false;
+            int64_t number = 0;
+            tie(conversionFailed, number) = u::convertStrToLL(line.data(), line.size());
+            if (!conversionFailed && (number >= 2)) numbers.push_back(static_cast<uint64_t>(number));
+        }
+
+        for (auto& shared : bg::findSharedFactors(numbers, options.threadCount))
+        {
+            output << shared.number << ": " << shared.sharedFactor << ", " << shared.number / shared.sharedFactor << '\n';
+        }
+        output.flush();
+
+        cout << endl << endl << appName << ": finished." << endl << endl;
+        return 0;
+    }
+
+
+    //
+    // Method dispatcher, calibrated for this machine if a config file was given:
+    //
+    const fd::Dispatcher dispatcher(options.dispatchConfigFileName.empty() ? fd::defaultThresholds()
+                                                                           : fd::loadThresholds(options.dispatchConfigFileName));
+
+
+    //
+    // Open the input file where the checkpoint left off, the reader starts prefetching the first block right away:
+    //
+    aio::BlockReader reader(options.inFileName, options.unordered ? unorderedLinesPerUnit : orderedLinesPerUnit, options.threadCount,
+                            start.inputBytes);
+    aio::AsyncWriter writer(output, !options.checkpointFileName.empty());
+
+
+    //
+    // State shared by the workers, one dedupe table so a number seen by any worker is not factored again:
+    //
+    unique_ptr<fs::FactorStore> store(options.storePath.empty() ? nullptr : new fs::FactorStore(options.storePath));
+    dd::DedupeTable dedupeTable(options.dedupeMemory, dedupeShardCount);
+    vector<FactorStats> workerStats(options.stats ? options.threadCount : 0);
 
-        // If the above returned conversionFailed == true, we skip. We also ignore everything below 2 here 
-        // since 0 is the value returned from convertStrToLL if a conversion could not happen, 1 is not prime by 
-        // definition, and we are only showing prime factors for non-negative integers.
-        if (conversionFailed || (numberToFactor < 2)) continue;
 
-        // Get prime factors of parsed number:
-        auto primeFactors = u::calculatePrimeFactors(numberToFactor);
+    //
+    // Workers convert, get prime factors, and format each unit of lines:
+    //
+    auto factorUnit = [&](unsigned worker, pl::WorkUnit& unit)
+    {
+        u::FactorResult factorResult;
+        for (size_t i = 0; i < unit.block.lines.size(); ++i)
+        {
+            // Convert string to int64_t:
+            bool conversionFailed = false;
+            int64_t numberToFactor = 0;
+            tie(conversionFailed, numberToFactor) = u::convertStrToLL(unit.block.lines[i]);
+
+            // If the above returned conversionFailed == true, we skip. We also ignore everything below 2 here 
+            // since 0 is the value returned from convertStrToLL if a conversion could not happen, 1 is not prime by 
+            // definition, and we are only showing prime factors for non-negative integers.
+            if (conversionFailed || (numberToFactor < 2)) continue;
+
+            // Repeated numbers reuse the factorization of their last occurrence:
+            if (!dedupeTable.find(numberToFactor, factorResult))
+            {
+                // Numbers factored by earlier runs come from the store, new ones are added to it:
+                if (!store || !store->find(numberToFactor, factorResult))
+                {
+                    // Get prime factors of parsed number, partial if it runs over its budget:
+                    if (options.stats)
+                    {
+                        FactorStats& stats = workerStats[worker];
+                        u::FactorCounters counters;
+                        factorResult = dispatcher.factor(numberToFactor, options.budget, counters);
+
+                        ++stats.numbersFactored;
+                        stats.total += counters;
+                        if (counters.trialDivisions + counters.rhoSteps > stats.heaviest.trialDivisions + stats.heaviest.rhoSteps)
+                        {
+                            stats.heaviestNumber = numberToFactor;
+                            stats.heaviest = counters;
+                        }
+                    }
+                    else
+                    {
+                        factorResult = dispatcher.factor(numberToFactor, options.budget);
+                    }
+                    if (store) store->add(numberToFactor, factorResult);
+                }
+                dedupeTable.insert(numberToFactor, factorResult);
+            }
+
+            // Unordered output carries the input line number so it can be put back in order:
+            if (options.unordered)
+            {
+                unit.output += to_string(unit.firstLineNumber + i);
+                unit.output += '\t';
+            }
+
+            // Format prime factors data:
+            formatPrimeFactors(unit.output, numberToFactor, factorResult);
+        }
+    };
+
 
-        // Print prime factors data:
-        printPrimeFactors(numberToFactor, primeFactors);
+    //
+    // Hand finished units to the writer, in input order unless '--unordered' was given:
+    //
+    pl::MemoryBudget memoryBudget(options.maxMemory);
+    pl::Pipeline factorPipeline(options.threadCount, !options.unordered,
+                                [&](aio::LineBlock& block) { return reader.nextBlock(block); }, factorUnit, &memoryBudget,
+                                options.pinThreads ? pl::Pipeline::WorkerStart([](unsigned worker) { nu::pinWorker(worker); })
+                                                   : pl::Pipeline::WorkerStart());
+    pr::ProgressCounters progressCounters;
+    progressCounters.add(start.lines, start.inputBytes);
+    pr::installReportSignal();
+    pr::ProgressReporter progressReporter(progressCounters, reader.getFileSize(), chrono::seconds(options.progressSeconds),
+                                          options.progressFileName);
+    unique_ptr<ck::Checkpointer> checkpointer(options.checkpointFileName.empty() ? nullptr
+        : new ck::Checkpointer(options.checkpointFileName, start, [&writer] { return writer.getBytesWritten(); }, checkpointInterval));
+    pl::WorkUnit unit;
+    while (factorPipeline.collect(unit))
+    {
+        // Writer drains this unit while the workers carry on. write() waits while the previous unit is still being
+        //  drained, so a slow consumer stops us collecting and the budget fills up behind us:
+        size_t outputBytes = unit.output.size();
+        writer.write(unit.output);
+        memoryBudget.release(unit.chargedBytes);
+        progressCounters.add(unit.block.lines.size(), unit.block.byteCount);
+        if (checkpointer) checkpointer->add(unit.block.byteCount, unit.block.lines.size(), outputBytes);
     }
+    writer.close();
+    progressReporter.stop();
+    if (checkpointer) checkpointer->stop();
+    if (options.stats) printFactorStats(cerr, workerStats);
+    if (store) store->close();
 
 
     //
@@ -158,33 +471,270 @@ catch (...)
 
 
 //
-// Function to print prime factors data:
+// Function to get option value:
 //
-void printPrimeFactors (
+string getOptionValue (
+    int argc,
+    char* argv[],
+    int& i
+)
+{
+    if (i + 1 >= argc)
+    {
+        throw runtime_error(string("Error: '") + argv[i] + string("' requires a value; aborting."));
+    }
+
+    // Consume the value so the caller's loop skips it:
+    return string(argv[++i]);
+}
+
+
+//
+// Function to parse byte count:
+//
+size_t parseByteSize (
+    const string& option,
+    const string& value
+)
+{
+    // strtoull instead of convertStrToLL since 0 is a valid size here:
+    char* suffix = nullptr;
+    errno = 0;
+    unsigned long long bytes = strtoull(value.c_str(), &suffix, 10);
+
+    // Optional binary suffix:
+    string unit = string(suffix);
+    unsigned long long multiplier = 1;
+    if ((unit == "K") || (unit == "k")) multiplier = 1ull << 10;
+    else if ((unit == "M") || (unit == "m")) multiplier = 1ull << 20;
+    else if ((unit == "G") || (unit == "g")) multiplier = 1ull << 30;
+    else if (!unit.empty()) errno = EINVAL;
+
+    if (value.empty() || (value[0] == '-') || (suffix == value.c_str()) || (errno != 0) || (bytes > numeric_limits<size_t>::max() / multiplier))
+    {
+        throw runtime_error(string("Error: '") + option + string("' requires a byte count (optionally followed by K, M or G), '") + value + string("' given; aborting."));
+    }
+
+    return static_cast<size_t>(bytes * multiplier);
+}
+
+
+//
+// Function to parse command line:
+//
+CommandLineOptions parseCommandLine (
+    int argc,
+    char* argv[],
+    const string& appName
+)
+{
+    CommandLineOptions options;
+
+    // Walk all CLI options, the only positional option is the input file name:
+    //	Note: We start at 1 since argv[0] is the executable name we are running.
+    for (int i = 1; i < argc; ++i)
+    {
+        string option = string(argv[i]);
+
+        if (option == "--max-ms-per-number")
+        {
+            // Reuse the number conversion, 0 (or garbage) is rejected rather than treated as unlimited:
+            string value = getOptionValue(argc, argv, i);
+            bool conversionFailed = false;
+            int64_t maxMilliseconds = 0;
+            tie(conversionFailed, maxMilliseconds) = u::convertStrToLL(value);
+            if (conversionFailed || (maxMilliseconds < 1))
+            {
+                throw runtime_error(string("Error: '") + option + string("' requires a positive number of milliseconds, '") + value + string("' given; aborting."));
+            }
+            options.budget.maxMilliseconds = static_cast<uint64_t>(maxMilliseconds);
+        }
+        else if (option == "--dispatch-config")
+        {
+            options.dispatchConfigFileName = getOptionValue(argc, argv, i);
+        }
+        else if (option == "--calibrate")
+        {
+            options.calibrateFileName = getOptionValue(argc, argv, i);
+        }
+        else if (option == "--dedupe-memory")
+        {
+            options.dedupeMemory = parseByteSize(option, getOptionValue(argc, argv, i));
+        }
+        else if (option == "--store")
+        {
+            options.storePath = getOptionValue(argc, argv, i);
+        }
+        else if (option == "--batch-gcd")
+        {
+            options.batchGcd = true;
+        }
+        else if (option == "--threads")
+        {
+            string value = getOptionValue(argc, argv, i);
+            bool conversionFailed = false;
+            int64_t threadCount = 0;
+            tie(conversionFailed, threadCount) = u::convertStrToLL(value);
+            if (conversionFailed || (threadCount < 1) || (threadCount > 1024))
+            {
+                throw runtime_error(string("Error: '") + option + string("' requires a thread count between 1 and 1024, '") + value + string("' given; aborting."));
+            }
+            options.threadCount = static_cast<unsigned>(threadCount);
+        }
+        else if (option == "--unordered")
+        {
+            options.unordered = true;
+        }
+        else if (option == "--max-memory")
+        {
+            options.maxMemory = parseByteSize(option, getOptionValue(argc, argv, i));
+        }
+        else if (option == "--progress")
+        {
+            string value = getOptionValue(argc, argv, i);
+            bool conversionFailed = false;
+            int64_t progressSeconds = 0;
+            tie(conversionFailed, progressSeconds) = u::convertStrToLL(value);
+            if (conversionFailed || (progressSeconds < 1) || (progressSeconds > 86400))
+            {
+                throw runtime_error(string("Error: '") + option + string("' requires a number of seconds between 1 and 86400, '") + value + string("' given; aborting."));
+            }
+            options.progressSeconds = static_cast<unsigned>(progressSeconds);
+        }
+        else if (option == "--progress-file")
+        {
+            options.progressFileName = getOptionValue(argc, argv, i);
+        }
+        else if (option == "--stats")
+        {
+            options.stats = true;
+        }
+        else if (option == "--output")
+        {
+            options.outFileName = getOptionValue(argc, argv, i);
+        }
+        else if (option == "--checkpoint")
+        {
+            options.checkpointFileName = getOptionValue(argc, argv, i);
+        }
+        else if (option == "--resume")
+        {
+            options.resume = true;
+        }
+        else if (option == "--pin-threads")
+        {
+            options.pinThreads = true;
+        }
+        else if (option.compare(0, 2, "--") == 0)
+        {
+            throw runtime_error(string("Error: '") + appName + string("' does not know the CLI option '") + option + string("'; aborting."));
+        }
+        else if (options.inFileName.empty())
+        {
+            options.inFileName = option;
+        }
+        else
+        {
+            throw runtime_error(string("Error: '") + appName + string("' takes only 1 input file, '") + option + string("' is extra; aborting."));
+        }
+    }
+
+    // Input file is required unless we are only calibrating:
+    if (options.inFileName.empty() && options.calibrateFileName.empty())
+    {
+        throw runtime_error(string("Error: '") + appName + string("' requires an input file; aborting."));
+    }
+
+    // Checkpoints need the output in input order, in a file that can be cut back:
+    if (!options.checkpointFileName.empty() && (options.outFileName.empty() || options.unordered || options.batchGcd))
+    {
+        throw runtime_error(string("Error: '--checkpoint' requires '--output' and cannot be combined with '--unordered' or '--batch-gcd'; aborting."));
+    }
+    if (options.resume && options.checkpointFileName.empty())
+    {
+        throw runtime_error(string("Error: '--resume' requires '--checkpoint'; aborting."));
+    }
+
+    return options;
+}
+
+
+//
+// Function to print factor stats:
+//	Note: "Most work" is the number with the most trial divisions and rho steps, the two that grow with its size.
+//
+void printFactorStats (
+    ostream& stream,
+    const vector<FactorStats>& workerStats
+)
+{
+    FactorStats all;
+    for (auto& stats : workerStats)
+    {
+        all.numbersFactored += stats.numbersFactored;
+        all.total += stats.total;
+        if (stats.heaviest.trialDivisions + stats.heaviest.rhoSteps > all.heaviest.trialDivisions + all.heaviest.rhoSteps)
+        {
+            all.heaviestNumber = stats.heaviestNumber;
+            all.heaviest = stats.heaviest;
+        }
+    }
+
+    auto printCounters = [&](const char* label, const u::FactorCounters& counters, uint64_t divisor)
+    {
+        stream << label << counters.trialDivisions / divisor << " trial divisions, " << counters.rhoSteps / divisor << " rho steps, "
+               << counters.gcds / divisor << " gcds, " << counters.millerRabinRounds / divisor << " Miller-Rabin rounds" << endl;
+    };
+
+    stream << "stats: " << all.numbersFactored << " numbers factored" << endl;
+    printCounters("stats: total: ", all.total, 1);
+    if (all.numbersFactored == 0) return;
+    printCounters("stats: average per number: ", all.total, all.numbersFactored);
+    stream << "stats: most work: " << all.heaviestNumber << ": ";
+    printCounters("", all.heaviest, 1);
+}
+
+
+//
+// Function to format prime factors data:
+//	Note: Numbers that ran out of budget are followed by ' | <status>: <cofactor>' so they can be told apart from
+//		   complete factorizations, e.g. '7000000112000000441: 7 | composite, unfactored: 1000000016000000063'.
+//
+void formatPrimeFactors (
+    string& outBuffer,
     uint64_t numberFactored,
-    const vector<uint64_t>& primeFactors
+    const u::FactorResult& factorResult
 )
 {
-    // Print out number that was factored:
-    cout << numberFactored << ": ";
+    // Append number that was factored:
+    outBuffer += to_string(numberFactored);
+    outBuffer += ":";
 
-    // Print out all prime factors on the same line seperated by commas:
+    // Append all prime factors on the same line seperated by commas:
     bool firstCSVElement = true;
-    for (auto& factor : primeFactors)
+    for (auto& factor : factorResult.primeFactors)
     {
-        // Do not print trailing comma on first item, print it starting with the second item BEFORE
-        //	printing the item.
+        // Do not append trailing comma on first item, append it starting with the second item BEFORE
+        //	appending the item.
         if (firstCSVElement)
         {
-            cout << factor;
+            outBuffer += " ";
             firstCSVElement = false;
         }
         else
         {
-            cout << ", " << factor;
+            outBuffer += ", ";
         }
+        outBuffer += to_string(factor);
+    }
+
+    // Append what is left of partial factorizations:
+    if (factorResult.status == u::FactorStatus::compositeUnfactored)
+    {
+        outBuffer += " | composite, unfactored: ";
+        outBuffer += to_string(factorResult.cofactor);
     }
 
-    // Print newline so next iteration will be starting fresh:
-    cout << endl;
+    // Append newline so next line will be starting fresh:
+    outBuffer += '\n';
 }